@@ -0,0 +1,398 @@
+/*
+   Benchmark of the functions spherematch2 and spherematch2_mm on synthetic
+   paired catalogues generated in memory.
+
+   The reference catalogue (1) is generated in a square sky patch with the
+   requested density; a fraction of its objects can be clustered in
+   gaussian blobs. The second catalogue (2) holds, for each object of (1),
+   a counterpart displaced by a gaussian positional error (with probability
+   given by the match fraction), a further counterpart for a fraction of
+   objects (duplicates) and unrelated field objects.
+   The "lmc" preset mimics the crowded field of the Large Magellanic Cloud.
+
+   For each catalogue size it reports:
+    - the number of candidate pairs found by spherematch2_mm and the rate
+      (pairs/s),
+    - the time spent by spherematch2 in the 1-to-1 resolution, not measured
+      but derived as the spherematch2 time minus the spherematch2_mm time
+      ("resolve_s_derived"),
+    - the candidate pairs limit given to spherematch2 (4 times the larger
+      catalogue) and whether the candidates exceed it ("maxmatch_hit": the
+      pairs beyond it are dropped, so that the 1-to-1 result is partial),
+    - the peak resident memory of each step (Linux only).
+
+   Output is one JSON record per catalogue size.
+
+Compile: g++ -O3 -o benchspm benchspm.cc ../lib/libspheregroup.a
+
+Examples:
+  ./benchspm -h
+  ./benchspm -n 1000 -N 1000000
+  ./benchspm -P lmc -n 1000 -N 100000 -R 100000
+
+  LN@INAF-OAS, October 2026                      Last change: 19/10/2026
+ */
+
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <ctime>
+#include <vector>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <algorithm>
+
+using namespace std;
+
+long spherematch2(unsigned long npoints1, double *ra1, double *dec1,
+                 unsigned long npoints2, double *ra2, double *dec2,
+                 double matchlength, double minchunksize,
+                 vector<long> &match1, vector<long>&match2, vector<float>&distance12, unsigned long *nmatch);
+long spherematch2_mm(unsigned long npoints1, double *ra1, double *dec1,
+                 unsigned long npoints2, double *ra2, double *dec2,
+                 double matchlength, double minchunksize,
+                 vector<long> &match1, vector<long>&match2, vector<float>&distance12, unsigned long *nmatch);
+
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+// Progran name
+const char PROGNAME[] = "benchspm";
+
+
+// Synthetic catalogues parameters
+struct SkyModel {
+  double ra0, dec0;      // patch center (deg)
+  double dens;           // objects per deg^2 in catalogue 1
+  double poserr;         // positional error (arcsec, 1 sigma per coordinate)
+  double match_frac;     // fraction of cat. 1 objects with a counterpart
+  double dup_frac;       // fraction of cat. 1 objects with a 2nd counterpart
+  double field_frac;     // unrelated objects in cat. 2 (fraction of N1)
+  double clust_frac;     // fraction of clustered objects
+  int nclust;            // number of clusters
+  double clust_sig;      // cluster size (arcsec, 1 sigma)
+  unsigned long long seed;
+};
+
+
+/*
+  Small deterministic generator (splitmix64) so that catalogues are
+  the same on any platform for a given seed.
+*/
+class Rng {
+  unsigned long long s;
+public:
+  Rng(unsigned long long seed) : s(seed) {}
+
+  unsigned long long next() {
+    unsigned long long z = (s += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  // uniform in [0,1)
+  double uni() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+
+  // standard normal (Box-Muller)
+  double gauss() {
+    double u1 = uni(), u2 = uni();
+    if (u1 < 1e-300) u1 = 1e-300;
+    return sqrt(-2. * log(u1)) * cos(2. * M_PI * u2);
+  }
+};
+
+
+// Move (ra, dec) by (dx, dy) arcsec on the tangent plane
+static void offset(double &ra, double &dec, double dx, double dy)
+{
+  double cd = cos(dec * DEG2RAD);
+  if (cd < 1e-6) cd = 1e-6;
+  dec += dy / 3600.;
+  ra += dx / 3600. / cd;
+  if (dec >  90.) { dec =  180. - dec; ra += 180.; }
+  if (dec < -90.) { dec = -180. - dec; ra += 180.; }
+  ra = fmod(ra, 360.);
+  if (ra < 0.) ra += 360.;
+}
+
+
+static void generate(const SkyModel &sm, unsigned long n1,
+                     vector<double> &ra1, vector<double> &de1,
+                     vector<double> &ra2, vector<double> &de2)
+{
+  Rng rng(sm.seed ^ (n1 * 0x2545F4914F6CDD1DULL));
+  unsigned long i;
+
+  // Square patch with area n1/dens deg^2, uniform on the sphere
+  double side = sqrt(n1 / sm.dens);
+  if (side > 180.) side = 180.;
+  double dmin = sm.dec0 - side/2., dmax = sm.dec0 + side/2.;
+  if (dmin < -90.) dmin = -90.;
+  if (dmax >  90.) dmax =  90.;
+  double zmin = sin(dmin * DEG2RAD), zmax = sin(dmax * DEG2RAD);
+  double wra = side / cos(sm.dec0 * DEG2RAD);
+  if (wra > 360.) wra = 360.;
+
+  vector<double> cra, cde;
+  for (i=0; i<(unsigned long) sm.nclust; i++) {
+    double z = zmin + (zmax - zmin) * rng.uni();
+    cde.push_back(asin(z) / DEG2RAD);
+    cra.push_back(fmod(sm.ra0 - wra/2. + wra * rng.uni() + 360., 360.));
+  }
+
+  ra1.resize(n1);
+  de1.resize(n1);
+  for (i=0; i<n1; i++) {
+    if (sm.nclust > 0  &&  rng.uni() < sm.clust_frac) {
+      int c = (int) (rng.uni() * sm.nclust);
+      ra1[i] = cra[c];
+      de1[i] = cde[c];
+      offset(ra1[i], de1[i], sm.clust_sig * rng.gauss(), sm.clust_sig * rng.gauss());
+    } else {
+      double z = zmin + (zmax - zmin) * rng.uni();
+      de1[i] = asin(z) / DEG2RAD;
+      ra1[i] = fmod(sm.ra0 - wra/2. + wra * rng.uni() + 360., 360.);
+    }
+  }
+
+  ra2.clear();
+  de2.clear();
+  ra2.reserve((unsigned long) (n1 * (sm.match_frac + sm.dup_frac + sm.field_frac)) + 1);
+  de2.reserve(ra2.capacity());
+  for (i=0; i<n1; i++) {
+    int ncp = (rng.uni() < sm.match_frac ? 1 : 0) + (rng.uni() < sm.dup_frac ? 1 : 0);
+    for (int k=0; k<ncp; k++) {
+      double ra = ra1[i], de = de1[i];
+      offset(ra, de, sm.poserr * rng.gauss(), sm.poserr * rng.gauss());
+      ra2.push_back(ra);
+      de2.push_back(de);
+    }
+  }
+  unsigned long nfield = (unsigned long) (n1 * sm.field_frac);
+  for (i=0; i<nfield; i++) {
+    double z = zmin + (zmax - zmin) * rng.uni();
+    de2.push_back(asin(z) / DEG2RAD);
+    ra2.push_back(fmod(sm.ra0 - wra/2. + wra * rng.uni() + 360., 360.));
+  }
+
+  // Shuffle catalogue 2 so that it is not ordered as catalogue 1
+  for (i=ra2.size(); i>1; i--) {
+    unsigned long j = rng.next() % i;
+    swap(ra2[i-1], ra2[j]);
+    swap(de2[i-1], de2[j]);
+  }
+}
+
+
+static double now_s()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+// Reset the peak RSS counter (Linux >= 4.0): return 0 on success
+static int reset_peak_mem()
+{
+  FILE *f = fopen("/proc/self/clear_refs", "w");
+  if (! f) return 1;
+  int ret = (fputs("5", f) < 0);
+  fclose(f);
+  return ret;
+}
+
+
+// Peak resident memory in MB (VmHWM), -1 if not available
+static double peak_mem_mb()
+{
+  ifstream in("/proc/self/status");
+  string line;
+  while (getline(in, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return atof(line.c_str() + 6) / 1024.;
+  return -1.;
+}
+
+
+void
+usage() {
+
+  cout << PROGNAME << "\n" << endl
+       << "Usage:" << endl
+       << PROGNAME << " [OPTIONS]" << endl
+       << "Where OPTIONS are:\n" << endl
+       << "  -h: print this help" << endl
+       << "  -c Frac: fraction of clustered objects (def. 0)" << endl
+       << "  -C Ncl: number of clusters (def. 10)" << endl
+       << "  -D Dens: cat. 1 density in objects per deg^2 (def. 1000)" << endl
+       << "  -d Frac: fraction of cat. 1 objects with a duplicated counterpart (def. 0.02)" << endl
+       << "  -e Err: positional error in arcsec (def. 0.2)" << endl
+       << "  -f Frac: unrelated cat. 2 objects, fraction of cat. 1 size (def. 0.1)" << endl
+       << "  -m Frac: fraction of cat. 1 objects with a counterpart (def. 0.9)" << endl
+       << "  -n N: smallest cat. 1 size (def. 1000)" << endl
+       << "  -N N: largest cat. 1 size, sizes grow by 10x (def. 1000000)" << endl
+       << "  -P Preset: 'sparse' (def.), 'lmc' (crowded field)" << endl
+       << "  -R N: skip the 1-to-1 resolution above N cat. 1 objects (def. 100000)" << endl
+       << "  -r Seed: random generator seed (def. 1)" << endl
+       << "  -S Sep: match radius in arcsec (def. 1)" << endl
+       << "  -s Size: cluster size (1 sigma) in arcsec (def. 60)" << endl
+       << endl
+       << "Sizes up to 1e8 are accepted: about 40 bytes per object are needed" << endl
+       << "for the catalogues plus the matcher working memory." << endl
+       << endl;
+  exit(0);
+
+}
+
+
+int main (int argc, char *argv[])
+{
+  unsigned short kwds=0;
+  char c;
+
+  SkyModel sm;
+  sm.ra0 = 180.;
+  sm.dec0 = 30.;
+  sm.dens = 1000.;
+  sm.poserr = 0.2;
+  sm.match_frac = 0.9;
+  sm.dup_frac = 0.02;
+  sm.field_frac = 0.1;
+  sm.clust_frac = 0.;
+  sm.nclust = 10;
+  sm.clust_sig = 60.;
+  sm.seed = 1;
+
+  unsigned long nmin = 1000, nmax = 1000000, nres = 100000, n1;
+  double sep = 1.;
+  char preset[33] = "sparse";
+
+/* Keywords section */
+  while (--argc > 0 && (*++argv)[0] == '-')
+  {
+    kwds=1;
+    while (kwds && (c = *++argv[0]))
+    {
+      if (c != 'h'  &&  argc < 2) usage();
+      switch (c)
+      {
+        case 'h': usage(); break;
+        case 'c': sm.clust_frac = atof(*++argv); break;
+        case 'C': sm.nclust = atoi(*++argv); break;
+        case 'D': sm.dens = atof(*++argv); break;
+        case 'd': sm.dup_frac = atof(*++argv); break;
+        case 'e': sm.poserr = atof(*++argv); break;
+        case 'f': sm.field_frac = atof(*++argv); break;
+        case 'm': sm.match_frac = atof(*++argv); break;
+        case 'n': nmin = strtoul(*++argv, NULL, 10); break;
+        case 'N': nmax = strtoul(*++argv, NULL, 10); break;
+        case 'P':
+          sscanf(*++argv,"%32s",preset);
+          if (strcmp(preset, "lmc") == 0) {
+            // LMC-like crowded field: ~1e6 objects/deg^2 at faint limits,
+            // half of them in compact clusters
+            sm.ra0 = 80.894;
+            sm.dec0 = -69.756;
+            sm.dens = 1e6;
+            sm.poserr = 0.1;
+            sm.dup_frac = 0.05;
+            sm.field_frac = 0.3;
+            sm.clust_frac = 0.5;
+            sm.nclust = 200;
+            sm.clust_sig = 20.;
+          } else if (strcmp(preset, "sparse") != 0) {
+            fprintf (stderr,"Unknown preset `%s'.\n\n",preset);
+            usage();
+          }
+          break;
+        case 'R': nres = strtoul(*++argv, NULL, 10); break;
+        case 'r': sm.seed = strtoull(*++argv, NULL, 10); break;
+        case 'S': sep = atof(*++argv); break;
+        case 's': sm.clust_sig = atof(*++argv); break;
+        default:
+          fprintf (stderr,"Illegal option `%c'.\n\n",c);
+          usage();
+      }
+      if (c != 'h') {
+        --argc;
+        kwds=0;
+      }
+    }
+  }
+
+  if (nmin < 1 || nmax < nmin || sm.dens <= 0. || sep <= 0.)
+    usage();
+
+  double matchlength = sep / 3600., minchunksize = matchlength * 10;
+
+  // spherematch2 writes progress messages on cout: discard them
+  ofstream devnull("/dev/null");
+  streambuf *coutbuf = cout.rdbuf();
+
+  cout << "[" << endl;
+  for (n1 = nmin; n1 <= nmax; n1 *= 10) {
+    vector<double> ra1, de1, ra2, de2;
+    vector<long> match1, match2;
+    vector<float> distance12;
+    unsigned long nmm, n1to1, maxmatch;
+    double t0, tgen, tmm, t1to1 = -1., mem_mm, mem_1to1 = -1.;
+
+    t0 = now_s();
+    generate(sm, n1, ra1, de1, ra2, de2);
+    tgen = now_s() - t0;
+
+    // Candidate pairs
+    reset_peak_mem();
+    nmm = (unsigned long) -1 >> 1;
+    cout.rdbuf(devnull.rdbuf());
+    t0 = now_s();
+    spherematch2_mm(n1, &ra1[0], &de1[0], ra2.size(), &ra2[0], &de2[0],
+                    matchlength, minchunksize, match1, match2, distance12, &nmm);
+    tmm = now_s() - t0;
+    cout.rdbuf(coutbuf);
+    mem_mm = peak_mem_mb();
+
+    vector<long>().swap(match1);
+    vector<long>().swap(match2);
+    vector<float>().swap(distance12);
+
+    // Candidate pairs plus 1-to-1 resolution
+    n1to1 = 0;
+    maxmatch = max(n1, (unsigned long) ra2.size()) * 4;
+    if (n1 <= nres) {
+      reset_peak_mem();
+      n1to1 = maxmatch;
+      cout.rdbuf(devnull.rdbuf());
+      t0 = now_s();
+      spherematch2(n1, &ra1[0], &de1[0], ra2.size(), &ra2[0], &de2[0],
+                   matchlength, minchunksize, match1, match2, distance12, &n1to1);
+      t1to1 = now_s() - t0;
+      cout.rdbuf(coutbuf);
+      mem_1to1 = peak_mem_mb();
+      if (nmm > maxmatch)
+        fprintf(stderr, "n1 = %lu: %lu candidate pairs exceed maxmatch = %lu, "
+                "the 1-to-1 matches are partial\n", n1, nmm, maxmatch);
+    }
+
+    char buf[1024];
+    sprintf(buf, "{\"preset\": \"%s\", \"n1\": %lu, \"n2\": %lu, "
+                 "\"dens\": %g, \"sep_arcsec\": %g, \"gen_s\": %.4f, "
+                 "\"pairs\": %lu, \"pairs_s\": %.4f, \"pairs_per_s\": %.0f, "
+                 "\"nmatch_1to1\": %lu, \"resolve_s_derived\": %.4f, "
+                 "\"maxmatch\": %lu, \"maxmatch_hit\": %s, "
+                 "\"peak_mb_pairs\": %.1f, \"peak_mb_1to1\": %.1f}",
+            preset, n1, (unsigned long) ra2.size(), sm.dens, sep, tgen,
+            nmm, tmm, (tmm > 0. ? nmm / tmm : 0.),
+            n1to1, (t1to1 >= 0. ? max(t1to1 - tmm, 0.) : -1.),
+            maxmatch, (n1 <= nres  &&  nmm > maxmatch ? "true" : "false"),
+            mem_mm, mem_1to1);
+    cout << "  " << buf << (n1 * 10 <= nmax ? "," : "") << endl;
+  }
+  cout << "]" << endl;
+
+  return 0;
+}
@@ -13,6 +13,37 @@ CREATE TABLE tbl(db VARCHAR(64),
 		 param INTEGER NOT NULL,
                  Ra_field VARCHAR(128),
                  Dec_field VARCHAR(128),
+                 clustered DATETIME DEFAULT NULL,
                  UNIQUE KEY(db, name, id_type, id_opt, param))//
 
 CREATE TABLE dif(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+
+CREATE TABLE difm(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+
+# Tables reading the region slots 1-7 (see the optional slot argument of the
+# region functions)
+CREATE TABLE dif1(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif2(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif3(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif4(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif5(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif6(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE dif7(param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+
+CREATE TABLE difm1(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm2(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm3(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm4(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm5(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm6(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difm7(target BIGINT, param INTEGER, id BIGINT, full BOOL) ENGINE=DIF//
+
+# Ranges of consecutive pixel IDs (see the "_r" views)
+CREATE TABLE difr(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr1(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr2(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr3(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr4(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr5(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr6(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
+CREATE TABLE difr7(param INTEGER, lo BIGINT, hi BIGINT, full BOOL) ENGINE=DIF//
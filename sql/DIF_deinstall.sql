@@ -26,6 +26,12 @@ DROP FUNCTION HTMLookup//
 #@ONERR_IGNORE_INFO|Cannot drop function HEALPLookup|
 DROP FUNCTION HEALPLookup//
 
+#@ONERR_IGNORE_INFO|Cannot drop function HTMParent|
+DROP FUNCTION HTMParent//
+
+#@ONERR_IGNORE_INFO|Cannot drop function HEALPNestParent|
+DROP FUNCTION HEALPNestParent//
+
 #@ONERR_IGNORE_INFO|Cannot drop function DIF_HEALPCircle|
 DROP FUNCTION DIF_HEALPCircle//
 
@@ -65,6 +71,45 @@ DROP FUNCTION DIF_HEALPNeighbC//
 #@ONERR_IGNORE_INFO|Cannot drop function DIF_HTMNeighbC|
 DROP FUNCTION DIF_HTMNeighbC//
 
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_addTarget|
+DROP FUNCTION DIF_addTarget//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Cones|
+DROP FUNCTION DIF_Cones//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Polygon|
+DROP FUNCTION DIF_Polygon//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_MOC|
+DROP FUNCTION DIF_MOC//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_MOCBuild|
+DROP FUNCTION DIF_MOCBuild//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Annulus|
+DROP FUNCTION DIF_Annulus//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Ellipse|
+DROP FUNCTION DIF_Ellipse//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Strip|
+DROP FUNCTION DIF_Strip//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_RegionExpr|
+DROP FUNCTION DIF_RegionExpr//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Prepare|
+DROP FUNCTION DIF_Prepare//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_UsePrepared|
+DROP FUNCTION DIF_UsePrepared//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Unprepare|
+DROP FUNCTION DIF_Unprepare//
+
+#@ONERR_IGNORE_INFO|Cannot drop function DIF_Chunk|
+DROP FUNCTION DIF_Chunk//
+
 #@ONERR_IGNORE_INFO|Cannot drop function DIF_setHTMDepth|
 DROP FUNCTION DIF_setHTMDepth//
 
@@ -56,6 +56,18 @@ DROP FUNCTION IF EXISTS HEALPLookup//
 #@ONERR_DIE|Cannot install function HEALPLookup|
 CREATE FUNCTION HEALPLookup RETURNS INTEGER SONAME 'ha_dif.so'//
 
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS HTMParent//
+
+#@ONERR_DIE|Cannot install function HTMParent|
+CREATE FUNCTION HTMParent RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS HEALPNestParent//
+
+#@ONERR_DIE|Cannot install function HEALPNestParent|
+CREATE FUNCTION HEALPNestParent RETURNS INTEGER SONAME 'ha_dif.so'//
+
 #@ONERR_IGNORE||
 DROP FUNCTION IF EXISTS Sphedist//
 
@@ -165,6 +177,12 @@ DROP FUNCTION IF EXISTS DIF_cpuTime//
 #@ONERR_DIE|Cannot install function DIF_cpuTime|
 CREATE FUNCTION DIF_cpuTime RETURNS REAL SONAME 'ha_dif.so'//
 
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Chunk//
+
+#@ONERR_DIE|Cannot install function DIF_Chunk|
+CREATE FUNCTION DIF_Chunk RETURNS INTEGER SONAME 'ha_dif.so'//
+
 
 #@ONERR_IGNORE||
 DROP FUNCTION IF EXISTS DIF_FineSearch//
@@ -204,6 +222,78 @@ DROP FUNCTION IF EXISTS DIF_sNeighb//
 #@ONERR_DIE|Cannot install function DIF_Neighb|
 CREATE FUNCTION DIF_sNeighb RETURNS INTEGER SONAME 'ha_dif.so'//
 
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_addTarget//
+
+#@ONERR_DIE|Cannot install function DIF_addTarget|
+CREATE FUNCTION DIF_addTarget RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Cones//
+
+#@ONERR_DIE|Cannot install function DIF_Cones|
+CREATE FUNCTION DIF_Cones RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Polygon//
+
+#@ONERR_DIE|Cannot install function DIF_Polygon|
+CREATE FUNCTION DIF_Polygon RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_MOC//
+
+#@ONERR_DIE|Cannot install function DIF_MOC|
+CREATE FUNCTION DIF_MOC RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_MOCBuild//
+
+#@ONERR_DIE|Cannot install function DIF_MOCBuild|
+CREATE AGGREGATE FUNCTION DIF_MOCBuild RETURNS STRING SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Annulus//
+
+#@ONERR_DIE|Cannot install function DIF_Annulus|
+CREATE FUNCTION DIF_Annulus RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Ellipse//
+
+#@ONERR_DIE|Cannot install function DIF_Ellipse|
+CREATE FUNCTION DIF_Ellipse RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Strip//
+
+#@ONERR_DIE|Cannot install function DIF_Strip|
+CREATE FUNCTION DIF_Strip RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_RegionExpr//
+
+#@ONERR_DIE|Cannot install function DIF_RegionExpr|
+CREATE FUNCTION DIF_RegionExpr RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Prepare//
+
+#@ONERR_DIE|Cannot install function DIF_Prepare|
+CREATE FUNCTION DIF_Prepare RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_UsePrepared//
+
+#@ONERR_DIE|Cannot install function DIF_UsePrepared|
+CREATE FUNCTION DIF_UsePrepared RETURNS INTEGER SONAME 'ha_dif.so'//
+
+#@ONERR_IGNORE||
+DROP FUNCTION IF EXISTS DIF_Unprepare//
+
+#@ONERR_DIE|Cannot install function DIF_Unprepare|
+CREATE FUNCTION DIF_Unprepare RETURNS INTEGER SONAME 'ha_dif.so'//
+
 
 #@ONERR_IGNORE||
 DROP FUNCTION IF EXISTS HEALPMaxS//
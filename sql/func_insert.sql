@@ -2,6 +2,8 @@ INSERT INTO `func` VALUES ('HTMnameById','(Id INT)','string','function','ha_dif.
 ('HTMidByName','(IdName STRING)','longlong','function','ha_dif.so','Return the HTM ID given its string name');
 ('HTMLookup','(Depth INT, Ra_deg DOUBLE, Dec_deg DOUBLE)','longlong','function','ha_dif.so','Return the HTM ID at a given depth and sky coordinates');
 ('HEALPLookup','(nested INT, order INT, Ra_deg DOUBLE, Dec_deg DOUBLE)','longlong','function','ha_dif.so','Return HEALPix ID at a given schema, order and coordinates');
+('HTMParent','(id BIGINT, from_depth INT, to_depth INT)','longlong','function','ha_dif.so','Return the HTM ID at the coarser depth to_depth of the given ID at depth from_depth');
+('HEALPNestParent','(id BIGINT, from_order INT, to_order INT)','longlong','function','ha_dif.so','Return the HEALPix NESTED ID at the coarser order to_order of the given ID at order from_order');
 ('Sphedist','(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE)','double','function','ha_dif.so','Return the distance of 2 sky points');
 ('HTMBaryDist','(depth INT, id INT, ra DOUBLE, dec DOUBLE)','double','function','ha_dif.so','Return the distance from the HTM trixel barycenter given depth, pixel ID and coordinates');
 ('HEALPBaryDist','(nested INT, order INT, id INT, ra DOUBLE, dec DOUBLE)','double','function','ha_dif.so','Return the distance from the HEALPix pixel barycentre (center) given scheme, order, pixel ID and coordinates');
@@ -17,15 +19,28 @@ INSERT INTO `func` VALUES ('HTMnameById','(Id INT)','string','function','ha_dif.
 ('HEALPBound','(nested INT, order INT, id INT [,step INT])','string','function','ha_dif.so','Return the HEALPix pixel boundaries coordinates given scheme, order and pixel ID. If step=1 then return the 4 corners (north, west, south and east)');
 ('HEALPBoundC','(nested INT, order INT, Ra_deg DOUBLE, Dec_deg DOUBLE [,step INT])','string','function','ha_dif.so','Return the HEALPix pixel boundaries coordinates given scheme, order and spherical coordinates. If step=1 then return the 4 corners (north, west, south and east)');
 ('HEALPMaxS','(order INT)','double','function','ha_dif.so','Return the HEALPix max size (in arcmin) from center to corner, given the order');
-('DIF_Circle','(Ra_deg DOUBLE, Dec_deg DOUBLE, Rad_arcmin DOUBLE)','longlong','function','ha_dif.so','Populate the DIF.dif table with the fully and partially covered pixels by the given circular region ');
-('DIF_Rect','(Ra_deg DOUBLE, Dec_deg DOUBLE, side_ra_arcmin DOUBLE [, side_dec_arcmin DOUBLE])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the given rectangular region, defined by center and one or two sides');
-('DIF_Rectv','(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE [, x 2])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the given rectangular region, defined by the coordinates of the 2 opposite (or 4) corners');
-('DIF_NeighbC','(Ra_deg DOUBLE, Dec_deg DOUBLE)','longlong','function','ha_dif.so','Populate the DIF.dif table with the pixel ID identified by the input coodinates and its neighboring pixel IDs. For multiple depths, use the smallest one.');
-('DIF_sNeighb','(in_depth INT, id INT, out_depth INT)','longlong','function','ha_dif.so','Populate the DIF.dif table with the neighboring pixels of a given pixel ID whose depth is definied by the out_depth (greater or equal to in_depth) parameter');
-('DIF_cpuTime','()','double','function','ha_dif.so','Return the cumulative CPU time (s) of the last DIF processes');
-('DIF_setHTMDepth','(depth INT)','longlong','function','ha_dif.so','Internal func.: set the current HTM depth(s)');
-('DIF_setHEALPOrder','(nested INT, order INT)','longlong','function','ha_dif.so','Internal func.: set the current HEALpix order');
-('DIF_clear','()','longlong','function','ha_dif.so','Internal func.: clear internal settings');
+('DIF_Circle','(Ra_deg DOUBLE, Dec_deg DOUBLE, Rad_arcmin DOUBLE [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the fully and partially covered pixels by the given circular region ');
+('DIF_Rect','(Ra_deg DOUBLE, Dec_deg DOUBLE, side_ra_arcmin DOUBLE [, side_dec_arcmin DOUBLE] [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the given rectangular region, defined by center and one or two sides');
+('DIF_Rectv','(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE [, x 2] [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the given rectangular region, defined by the coordinates of the 2 opposite (or 4) corners');
+('DIF_NeighbC','(Ra_deg DOUBLE, Dec_deg DOUBLE [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the pixel ID identified by the input coodinates and its neighboring pixel IDs. For multiple depths, use the smallest one.');
+('DIF_sNeighb','(in_depth INT, id INT, out_depth INT [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the neighboring pixels of a given pixel ID whose depth is definied by the out_depth (greater or equal to in_depth) parameter');
+('DIF_addTarget','(Id INT, Ra_deg DOUBLE, Dec_deg DOUBLE [, slot INT])','longlong','function','ha_dif.so','Append a target (ID and coordinates) to the multi-region list used by DIF_Cones. Return the number of targets');
+('DIF_Polygon','(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg, Dec2_deg, Ra3_deg, Dec3_deg [, ...] [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the spherical polygon with the given (N >= 3) vertices');
+('DIF_MOC','(moc STRING|BLOB [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels (HEALPix only) of the given MOC, ASCII or binary ranges serialization. Return the number of order 29 ranges');
+('DIF_MOCBuild','(order INT, nested_id INT)','string','aggregate','ha_dif.so','Aggregate: return the MOC (ASCII serialization) of the given HEALPix NESTED pixels of the given order');
+('DIF_Annulus','(Ra_deg DOUBLE, Dec_deg DOUBLE, Rin_arcmin DOUBLE, Rout_arcmin DOUBLE [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the annulus with the given center and radii');
+('DIF_Ellipse','(Ra_deg DOUBLE, Dec_deg DOUBLE, SemiMajor_arcmin DOUBLE, SemiMinor_arcmin DOUBLE, PA_deg DOUBLE [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the ellipse with the given center, semi-axes and position angle');
+('DIF_Strip','(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE, HalfWidth_arcmin DOUBLE [, frame STRING] [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels covered by the strip of given half width along the great circle through the two given points');
+('DIF_RegionExpr','(expr STRING [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels of an expression of circle, rect, poly, annulus, ellipse and strip regions joined by union, intersection and difference, e.g. "poly(...) - circle(...) | circle(...)". Return the number of regions');
+('DIF_Prepare','(expr_or_moc STRING|BLOB)','longlong','function','ha_dif.so','Prepare a region expression (as DIF_RegionExpr) or a MOC for all the connections: its pixels are computed once for each schema and depth/order. Return its handle, NULL if not valid');
+('DIF_UsePrepared','(handle INT [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.dif table with the full and partial pixels of the region prepared by DIF_Prepare. Always 1');
+('DIF_Unprepare','(handle INT)','longlong','function','ha_dif.so','Release the region prepared by DIF_Prepare. Return 1, 0 if the handle is not valid');
+('DIF_Cones','(Rad_arcmin DOUBLE [, slot INT])','longlong','function','ha_dif.so','Populate the DIF.difm (DIF.dif) table with the fully and partially covered pixels by circles of the given radius around each target set by DIF_addTarget');
+('DIF_cpuTime','([slot INT])','double','function','ha_dif.so','Return the cumulative CPU time (s) of the last DIF processes');
+('DIF_Chunk','(k INT, n INT [, slot INT])','longlong','function','ha_dif.so','Read only the chunk k (0 <= k < n) of n disjoint chunks of the pixel lists of the region in this statement. Always 1');
+('DIF_setHTMDepth','(depth INT [, slot INT])','longlong','function','ha_dif.so','Internal func.: set the current HTM depth(s)');
+('DIF_setHEALPOrder','(nested INT, order INT [, slot INT])','longlong','function','ha_dif.so','Internal func.: set the current HEALpix order');
+('DIF_clear','([slot INT])','longlong','function','ha_dif.so','Internal func.: clear internal settings');
 ('DIF_FineSearch','(...)','longlong','function','ha_dif.so','Internal func.: perform distance selection for objects in partial pixels');
 ('getHTMDepth','(db_name CHAR(64), tab_name CHAR(64))','INTEGER','function','void','Return the available HTM depths for a given DB and table as read from DIF.tbl');
 ('getHEALPOrder','(db_name CHAR(64), tab_name CHAR(64))','INTEGER','function','void','Return the available HEALPix orders for a given DB and table as read from DIF.tbl');
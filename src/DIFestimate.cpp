@@ -0,0 +1,325 @@
+/*
+  Name:  DIF_Region::estimatePixels
+
+  Description:
+   Estimates the number of pixels (full and partial) of the region at the
+   available depths/orders without computing them, for the optimizer
+   statistics of the DIF tables (see ha_dif::info).
+   With pixel area a and side s = sqrt(a), a region of area A and
+   perimeter P is covered by about A/a + P/s + 1 HEALPix pixels (inner ones
+   plus those crossed by the border) of the lowest available order, no more
+   than all the pixels. The HTM regions return full trixels of all the
+   depths and partial ones of the highest: A/a - 0.6 P/s inner trixels of
+   the lowest depth, the inner part of the band of partial trixels of each
+   depth filled by trixels of the next one (0.6 P s/a' - 0.6 P/s'), and
+   1.5 P/s partial trixels of the highest depth. The trixel area a is the
+   mean one over the region (trixel areas vary by a factor 2 over the
+   sphere), the mean one over the sphere for strips, boxes in other frames,
+   MOCs and multiple cones.
+   The regions given as a neighbors list have a known number of pixels.
+   Expressions (see DIFexpr.cpp) add the pixels of the regions of a union,
+   take the fewer ones of an intersection and those of the left operand of
+   a difference.
+   Only the chunk read (see DIF_Chunk) is counted.
+   Compared with the pixels computed by go() for circles and rectangles of
+   more than about 30 pixels, the estimate is within about 10% for HEALPix,
+   20% for HTM at one depth and 40% at several depths (see testEstimate.cc),
+   for a few pixels it only gives the order of magnitude. For expressions
+   it is within a factor 2 (the smaller operand bounds an intersection).
+
+  Note:
+   Areas are exact for circles, annuli, strips and boxes, the others are
+   approximated (spherical polygon area from the edges as parallel arcs,
+   ellipse area as the planar one). The perimeter is that of the circle of
+   the same area, but for strips, annuli and boxes.
+   Targets of DIF_Cones may be added by DIF_addTarget while reading the
+   table, their number is at least 1.
+
+  Return the estimated number of pixels, 0 if no region or depth/order is
+  defined.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* inner part of the band of partial trixels along the border, in units of
+   the border length times the trixel side (measured on circles and boxes) */
+static const double HTM_BAND = 0.6;
+
+
+// Area (sr) of a trixel of depth d
+static double htmArea(int d)
+{
+  return 4.*M_PI / (8. * pow(4., d));
+}
+
+
+static void unitVec(double ra, double de, double v[3])
+{
+  v[0] = cos(de*DEG2RAD) * cos(ra*DEG2RAD);
+  v[1] = cos(de*DEG2RAD) * sin(ra*DEG2RAD);
+  v[2] = sin(de*DEG2RAD);
+}
+
+
+static void midPoint(const double *a, const double *b, double *m)
+{
+  double n = 0.;
+  for (int k=0; k<3; k++) {
+    m[k] = a[k] + b[k];
+    n += m[k]*m[k];
+  }
+  n = sqrt(n);
+  for (int k=0; k<3; k++)
+    m[k] /= n;
+}
+
+
+static double triple(const double *a, const double *b, const double *c)
+{
+  return a[0]*(b[1]*c[2] - b[2]*c[1]) + a[1]*(b[2]*c[0] - b[0]*c[2]) +
+         a[2]*(b[0]*c[1] - b[1]*c[0]);
+}
+
+
+// Area (sr) of the trixel of depth d containing the point p
+static double htmTrixelArea(const double p[3], int d)
+{
+  double t[3][3] = {{(p[0] >= 0. ? 1. : -1.), 0., 0.},
+                    {0., (p[1] >= 0. ? 1. : -1.), 0.},
+                    {0., 0., (p[2] >= 0. ? 1. : -1.)}};
+  double w[3][3];
+  int i, k, c;
+
+  for (i=0; i<d; i++) {
+    midPoint(t[1], t[2], w[0]);
+    midPoint(t[0], t[2], w[1]);
+    midPoint(t[0], t[1], w[2]);
+    const double *ch[4][3] = {{t[0], w[2], w[1]}, {t[1], w[0], w[2]},
+                              {t[2], w[1], w[0]}, {w[0], w[1], w[2]}};
+
+// Child containing p: the one with p farthest inside all its edges
+    double best = -2., nt[3][3];
+    for (c=0; c<4; c++) {
+      double o = (triple(ch[c][0], ch[c][1], ch[c][2]) > 0.  ?  1.  :  -1.);
+      double m = o * triple(p, ch[c][0], ch[c][1]);
+      m = min(m, o * triple(p, ch[c][1], ch[c][2]));
+      m = min(m, o * triple(p, ch[c][2], ch[c][0]));
+      if (m > best) {
+        best = m;
+        for (k=0; k<3; k++)
+          copy(ch[c][k], ch[c][k] + 3, nt[k]);
+      }
+    }
+    for (k=0; k<3; k++)
+      copy(nt[k], nt[k] + 3, t[k]);
+  }
+
+// Spherical excess
+  double dots = 0.;
+  for (k=0; k<3; k++)
+    dots += t[k][0]*t[(k+1)%3][0] + t[k][1]*t[(k+1)%3][1] +
+            t[k][2]*t[(k+1)%3][2];
+  return 2. * atan2(fabs(triple(t[0], t[1], t[2])), 1. + dots);
+}
+
+
+// Mean area (sr) of the trixels of depth d in a region of area A centered
+// on p: harmonic mean (the mean density) over p and six points at 0.6 of
+// the region radius
+static double htmLocalArea(const double p[3], int d, double A)
+{
+  double e[3], n[3], q[3];
+  double rho = 0.6 * sqrt(A / M_PI);
+  double s = 1. / htmTrixelArea(p, d);
+  int j, k;
+
+// Tangent basis at p
+  double h = sqrt(p[0]*p[0] + p[1]*p[1]);
+  if (h > 1.e-9) {
+    e[0] = -p[1]/h;  e[1] = p[0]/h;  e[2] = 0.;
+  }
+  else {
+    e[0] = 1.;  e[1] = 0.;  e[2] = 0.;
+  }
+  n[0] = p[1]*e[2] - p[2]*e[1];
+  n[1] = p[2]*e[0] - p[0]*e[2];
+  n[2] = p[0]*e[1] - p[1]*e[0];
+
+  for (j=1; j<=6; j++) {
+    double th = j * M_PI/3.;
+    for (k=0; k<3; k++)
+      q[k] = p[k]*cos(rho) + (e[k]*cos(th) + n[k]*sin(th))*sin(rho);
+    s += 1. / htmTrixelArea(q, d);
+  }
+
+  return 7. / s;
+}
+
+
+// Area (sr) of the polygon with the given vertices (deg), not containing a
+// pole: each edge is the arc of parallel between its vertices longitudes
+static double polygonArea(const vector<double>& ra, const vector<double>& de)
+{
+  unsigned int i, n = ra.size();
+  double s = 0.;
+
+  for (i=0; i<n; i++) {
+    unsigned int j = (i+1) % n;
+    double dl = ra[j] - ra[i];
+    if (dl > 180.)  dl -= 360.;
+    if (dl < -180.) dl += 360.;
+    s += dl*DEG2RAD * (sin(de[i]*DEG2RAD) + sin(de[j]*DEG2RAD));
+  }
+
+  return fabs(s) / 2.;
+}
+
+
+double DIF_Region::estimatePixels()
+{
+  unsigned int i;
+  double area = 0., perim = -1.;
+  double mult = 1.;   //number of equal regions (DIF_Cones)
+  double r, r2;
+  double ctr[3];
+  bool local = true;  //ctr is the region center
+
+  if (avail_params.size() == 0)
+    return 0.;
+
+  switch (regtype) {
+  case DIF_REG_CIRCLE:
+  case DIF_REG_CONES:
+    r = rad/60.*DEG2RAD;
+    area = 2.*M_PI*(1. - cos(r));
+    perim = 2.*M_PI*sin(r);
+    if (regtype == DIF_REG_CONES  &&  tg_id.size() > 1)
+      mult = tg_id.size();
+    if (regtype == DIF_REG_CONES  &&  tg_id.size() != 1)
+      local = false;
+    else if (regtype == DIF_REG_CONES)
+      unitVec(tg_ra[0], tg_de[0], ctr);
+    else
+      unitVec(ra1, de1, ctr);
+    break;
+
+  case DIF_REG_ANNULUS:
+    r = rad/60.*DEG2RAD;
+    r2 = rad2/60.*DEG2RAD;
+    area = 2.*M_PI*(cos(r2) - cos(r));
+    perim = 2.*M_PI*(sin(r) + sin(r2));
+    unitVec(ra1, de1, ctr);
+    break;
+
+  case DIF_REG_ELLIPSE:
+    area = M_PI * (rad/60.*DEG2RAD) * (rad2/60.*DEG2RAD);
+    unitVec(ra1, de1, ctr);
+    break;
+
+  case DIF_REG_STRIP:   //band around a whole great circle
+    r = rad/60.*DEG2RAD;
+    area = 4.*M_PI*sin(r);
+    perim = 4.*M_PI*cos(r);
+    local = false;
+    break;
+
+  case DIF_REG_4VERT:
+  case DIF_REG_LONLAT: {
+    double dl = ra3 - ra1;
+    double c = ra1;
+    if (dl <= 0.) dl += 360.;
+    if (regtype == DIF_REG_4VERT  &&  dl > 180.) {   //go() takes the
+      dl = 360. - dl;                                //narrower box
+      c = ra3;
+    }
+    area = dl*DEG2RAD * fabs(sin(de2*DEG2RAD) - sin(de1*DEG2RAD));
+    perim = 2.*fabs(de2 - de1)*DEG2RAD +
+            dl*DEG2RAD * (cos(de1*DEG2RAD) + cos(de2*DEG2RAD));
+    if (regtype == DIF_REG_4VERT)
+      unitVec(c + dl/2., (de1 + de2)/2., ctr);
+    else
+      local = false;   //may be in another frame
+    break;
+  }
+
+  case DIF_REG_POLYGON: {
+    double v[3];
+    area = polygonArea(pg_ra, pg_de);
+    ctr[0] = ctr[1] = ctr[2] = 0.;
+    for (i=0; i<pg_ra.size(); i++) {
+      unitVec(pg_ra[i], pg_de[i], v);
+      ctr[0] += v[0];
+      ctr[1] += v[1];
+      ctr[2] += v[2];
+    }
+    local = (ctr[0] != 0.  ||  ctr[1] != 0.  ||  ctr[2] != 0.);
+    break;
+  }
+
+  case DIF_REG_MOC:
+    for (i=0; i<moc_lo.size(); i++)
+      area += (double) (moc_hi[i] - moc_lo[i]);
+    area *= M_PI / (3. * pow(4., 29));
+    local = false;
+    break;
+
+  case DIF_REG_NEIGHBC:   //a pixel and its neighbors at each depth/order
+    return 9. * avail_params.size() / chunk_n;
+
+  case DIF_REG_SNEIGHB:   //border pixels at outdepth of a pixel at indepth
+    return 4. * (pow(2., outdepth - indepth) + 1.) / chunk_n;
+
+  case DIF_REG_EXPR:   //combined by the operators
+    return estimateExpr() / chunk_n;
+
+  default:
+    return 0.;
+  }
+
+  if (perim < 0.)
+    perim = 2.*sqrt(M_PI*area);
+
+// HEALPix: pixels of the lowest order only
+  if (schema != DIF_HTM) {
+    int k = *min_element(avail_params.begin(), avail_params.end());
+    double ntot = 12. * pow(4., k);
+    double a = 4.*M_PI / ntot;
+    double npix = area/a + perim/sqrt(a) + 1.;
+    return mult * ((npix < ntot)  ?  npix  :  ntot) / chunk_n;
+  }
+
+// HTM: inner trixels of the lowest depth, the inner half of the partial
+// trixels band of each depth filled by trixels of the next one, partial
+// trixels of the highest depth
+  vector<int> d(avail_params);
+  sort(d.begin(), d.end());
+
+  vector<double> a(d.size());
+  for (i=0; i<d.size(); i++)
+    a[i] = (local  ?  htmLocalArea(ctr, d[i], area)  :  htmArea(d[i]));
+
+  double npix = area/a[0] - HTM_BAND * perim/sqrt(a[0]);
+  for (i=0; i+1<d.size(); i++) {
+    double band = HTM_BAND * perim * sqrt(a[i]);
+    npix += ((band < area)  ?  band  :  area) / a[i+1] -
+            HTM_BAND * perim/sqrt(a[i+1]);
+  }
+  npix += 1.5 * perim / sqrt(a.back());
+  if (npix < 1.)
+    npix = 1.;
+
+  return mult * npix / chunk_n;
+}
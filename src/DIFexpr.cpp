@@ -0,0 +1,484 @@
+/*
+  Name:  DIF_Region::setExpr, DIF_Region::inExpr, DIF_Region::inRegion,
+         DIF_Region::go_expr, DIF_Region::estimateExpr
+
+  Description:
+   Regions combined by union, intersection and difference (DIF_RegionExpr),
+   e.g. the survey footprint without the bright star masks:
+     "poly(10,-5, 20,-5, 20,5, 10,5) - (circle(12,0,6) | circle(15,2,4))"
+   The expression is a sequence of regions (equatorial coordinates):
+     circle(ra, dec, rad_arcmin)
+     rect(ra1, dec1, ra2, dec2)           (opposite corners, as DIF_Rectv)
+     poly(ra1, dec1, ra2, dec2, ra3, dec3 [, ...])   (or polygon)
+     annulus(ra, dec, rin_arcmin, rout_arcmin)
+     ellipse(ra, dec, smaj_arcmin, smin_arcmin, pa_deg)
+     strip(ra1, dec1, ra2, dec2, halfwidth_arcmin)
+   joined by "|" (union), "&" (intersection, binding tighter) and "-"
+   (difference, same precedence as "|", left to right), with parentheses.
+   setExpr stores each region as a DIF_Region (atom) and the expression in
+   postfix order.
+   go_expr computes the pixels of each atom at the available depths/orders
+   and converts them to ranges of IDs at the highest depth (HTM) or at the
+   order (HEALPix), full and partial. A pixel of the result is:
+    - union:        full if full in A or B, else partial if partial in any;
+    - intersection: full if full in A and B, else partial if in both;
+    - difference:   full if full in A and outside B, partial if in A and
+                    not full in B;
+   computed with the range set operations (see DIFsetops.cpp) on the
+   stack of the operands. The full ranges of the result are split into the
+   largest HTM trixels of the available depths, the partial ones are
+   returned at the highest depth (or order), as the other regions.
+   inExpr (DIF_FineSearch) evaluates the expression on the point.
+   estimateExpr (see DIFestimate.cpp) combines the estimated pixels of the
+   atoms: the sum for a union, the smaller one for an intersection and the
+   left operand for a difference, as their areas (the holes cut by a
+   difference may split full pixels into more ones of higher depths).
+
+  Note:
+   Frames other than equatorial, MOC and DIF_Cones cannot be used in the
+   expression. Parentheses can be nested up to 64 levels, polygons have
+   any number of vertices. As for the single regions, partial pixels could be > real
+   ones, full pixels could be < real ones.
+
+  Return (setExpr) the number of regions, -1 on syntax error, -2 if a
+  region is not valid.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* Operators in the postfix expression */
+static const int EXPR_OR = -1;
+static const int EXPR_AND = -2;
+static const int EXPR_MINUS = -3;
+
+/* Maximum nesting of parentheses */
+static const int EXPR_MAXDEPTH = 64;
+
+
+static void skipBlanks(const char*& s)
+{
+  while (isspace((unsigned char) *s))
+    s++;
+}
+
+
+static int parseExpr(const char*& s, vector<DIF_Region*>& atoms,
+                     vector<int>& code, enum DIF_Schema schema, int depth);
+
+
+// Region name and its numbers: return 0, -1 on syntax error, -2 if the
+// region is not valid
+static int parseAtom(const char*& s, vector<DIF_Region*>& atoms,
+                     vector<int>& code, enum DIF_Schema schema)
+{
+  string name;
+  vector<double> v;
+  int i, n;
+
+  while (isalpha((unsigned char) *s))
+    name += tolower(*s++);
+  skipBlanks(s);
+  if (name.size() == 0  ||  *s != '(')
+    return -1;
+
+  do {
+    char* e;
+    s++;
+    v.push_back(strtod(s, &e));
+    if (e == s)
+      return -1;
+    s = e;
+    skipBlanks(s);
+  } while (*s == ',');
+
+  if (*s != ')')
+    return -1;
+  s++;
+  n = v.size();
+
+  DIF_Region* a = new DIF_Region;
+  atoms.push_back(a);
+  a->setSchema(schema);
+
+  if (name == "circle"  &&  n == 3)
+    a->setCircle(v[0], v[1], v[2]);
+
+  else if (name == "rect"  &&  n == 4)
+    a->setRect(min(v[0], v[2]), min(v[1], v[3]),
+               max(v[0], v[2]), max(v[1], v[3]));
+
+  else if ((name == "poly"  ||  name == "polygon")  &&
+           n >= 6  &&  n % 2 == 0) {
+    for (i=0; i<n; i+=2) {
+      if (! (-90. <= v[i+1]  &&  v[i+1] <= 90.))
+        return -2;
+      a->addVertex(v[i], v[i+1]);
+    }
+    if (a->makePolygon() < 0)
+      return -2;
+    a->regtype = DIF_REG_POLYGON;
+  }
+
+  else if (name == "annulus"  &&  n == 4) {
+    a->regtype = DIF_REG_ANNULUS;
+    a->ra1 = v[0];
+    a->de1 = v[1];
+    a->rad2 = v[2];
+    a->rad = v[3];
+  }
+
+  else if (name == "ellipse"  &&  n == 5) {
+    a->regtype = DIF_REG_ELLIPSE;
+    a->ra1 = v[0];
+    a->de1 = v[1];
+    a->rad = v[2];
+    a->rad2 = v[3];
+    a->pa = v[4];
+  }
+
+  else if (name == "strip"  &&  n == 5) {
+    a->regtype = DIF_REG_STRIP;
+    a->ra1 = v[0];
+    a->de1 = v[1];
+    a->ra2 = v[2];
+    a->de2 = v[3];
+    a->rad = v[4];
+  }
+
+  else
+    return -1;
+
+  if (a->regtype == DIF_REG_ANNULUS  ||  a->regtype == DIF_REG_ELLIPSE  ||
+      a->regtype == DIF_REG_STRIP)
+    if (a->makeShape() < 0)
+      return -2;
+
+  code.push_back(atoms.size() - 1);
+  return 0;
+}
+
+
+// Parenthesized expression (up to EXPR_MAXDEPTH levels) or region
+static int parseFactor(const char*& s, vector<DIF_Region*>& atoms,
+                       vector<int>& code, enum DIF_Schema schema, int depth)
+{
+  int ret;
+
+  skipBlanks(s);
+  if (*s != '(')
+    return parseAtom(s, atoms, code, schema);
+
+  if (depth == EXPR_MAXDEPTH)
+    return -1;
+  s++;
+  if ((ret = parseExpr(s, atoms, code, schema, depth + 1)))
+    return ret;
+  skipBlanks(s);
+  if (*s != ')')
+    return -1;
+  s++;
+  return 0;
+}
+
+
+static int parseTerm(const char*& s, vector<DIF_Region*>& atoms,
+                     vector<int>& code, enum DIF_Schema schema, int depth)
+{
+  int ret;
+
+  if ((ret = parseFactor(s, atoms, code, schema, depth)))
+    return ret;
+
+  skipBlanks(s);
+  while (*s == '&') {
+    s++;
+    if ((ret = parseFactor(s, atoms, code, schema, depth)))
+      return ret;
+    code.push_back(EXPR_AND);
+    skipBlanks(s);
+  }
+  return 0;
+}
+
+
+static int parseExpr(const char*& s, vector<DIF_Region*>& atoms,
+                     vector<int>& code, enum DIF_Schema schema, int depth)
+{
+  int ret;
+
+  if ((ret = parseTerm(s, atoms, code, schema, depth)))
+    return ret;
+
+  skipBlanks(s);
+  while (*s == '|'  ||  *s == '-') {
+    int op = (*s == '|'  ?  EXPR_OR  :  EXPR_MINUS);
+    s++;
+    if ((ret = parseTerm(s, atoms, code, schema, depth)))
+      return ret;
+    code.push_back(op);
+    skipBlanks(s);
+  }
+  return 0;
+}
+
+
+int DIF_Region::setExpr(const char* expr, unsigned long len)
+{
+  string e(expr, len);
+  const char* s = e.c_str();
+
+  clear_expr();
+  int ret = parseExpr(s, ex_atom, ex_code, schema, 0);
+  skipBlanks(s);
+  if (ret == 0  &&  *s)
+    ret = -1;
+  if (ret < 0) {
+    clear_expr();
+    return ret;
+  }
+
+  return ex_atom.size();
+}
+
+
+
+bool DIF_Region::inRegion(double ra, double de)
+{
+  double sep;
+
+  switch (regtype) {
+    case DIF_REG_CIRCLE:
+      sep = skysep_h(ra1, de1, ra, de, 0);
+      return (sep >= 0.  &&  sep <= rad);
+
+    case DIF_REG_4VERT:
+      return ((ra1 <= ra  &&  ra <= ra3)  &&
+              (de1 <= de  &&  de <= de3));
+
+    case DIF_REG_POLYGON:
+      return inPolygon(ra, de);
+
+    case DIF_REG_MOC:
+      return inMOC(ra, de);
+
+    case DIF_REG_ANNULUS:
+    case DIF_REG_ELLIPSE:
+    case DIF_REG_STRIP:
+    case DIF_REG_LONLAT:
+      return inShape(ra, de);
+
+    case DIF_REG_EXPR:
+      return inExpr(ra, de);
+
+    default:
+      return false;
+  }
+}
+
+
+bool DIF_Region::inExpr(double ra, double de)
+{
+  unsigned int i;
+
+  ex_eval.clear();
+  for (i=0; i<ex_code.size(); i++) {
+    int c = ex_code[i];
+    if (c >= 0) {
+      ex_eval.push_back(ex_atom[c]->inRegion(ra, de));
+      continue;
+    }
+    char b = ex_eval.back();
+    ex_eval.pop_back();
+    char& a = ex_eval.back();
+    a = (c == EXPR_OR  ?  (a || b)  :
+         (c == EXPR_AND  ?  (a && b)  :  (a && ! b)));
+  }
+
+  return (ex_eval.size()  &&  ex_eval[0]);
+}
+
+
+double DIF_Region::estimateExpr()
+{
+  vector<double> n;   //operands stack
+  unsigned int i;
+
+  exprSetup();
+  for (i=0; i<ex_code.size(); i++) {
+    int c = ex_code[i];
+    if (c >= 0) {
+      n.push_back(ex_atom[c]->estimatePixels());
+      continue;
+    }
+    double b = n.back();
+    n.pop_back();
+    double& a = n.back();
+    if (c == EXPR_OR)
+      a += b;
+    else if (c == EXPR_AND)
+      a = min(a, b);
+  }
+
+  return (n.size()  ?  n[0]  :  0.);
+}
+
+
+
+// Schema and available params of the atoms, as this region
+void DIF_Region::exprSetup()
+{
+  unsigned int i, j;
+
+  for (i=0; i<ex_atom.size(); i++) {
+    ex_atom[i]->clear_pixel();
+    ex_atom[i]->setSchema(schema);
+    for (j=0; j<avail_params.size(); j++)
+      ex_atom[i]->setAvailParam(avail_params[j]);
+  }
+}
+
+
+// Sort and merge ranges
+static void toRanges(vector<pair<long long int, long long int> >& r,
+                     DIF_Ranges& out)
+{
+  unsigned long i;
+
+  sort(r.begin(), r.end());
+  out.clear();
+  for (i=0; i<r.size(); i++) {
+    if (out.size()  &&  r[i].first <= out.hi.back()) {
+      if (r[i].second > out.hi.back())
+        out.hi.back() = r[i].second;
+    }
+    else {
+      out.lo.push_back(r[i].first);
+      out.hi.push_back(r[i].second);
+    }
+  }
+}
+
+
+// Full and partial pixels of an atom as ranges at level maxlev
+static void atomRanges(DIF_Region& a, int maxlev, DIF_Ranges& f,
+                       DIF_Ranges& p)
+{
+  vector<pair<long long int, long long int> > fr, pr;
+  DIF_Ranges t;
+  unsigned int i;
+  unsigned long j;
+
+  a.go();
+  for (i=0; i<a.params.size(); i++) {
+    int sh = 2*(maxlev - a.params[i]);
+    if (sh < 0)
+      continue;
+    vector<long long int>& fl = a.flist(a.params[i]);
+    vector<long long int>& pl = a.plist(a.params[i]);
+    for (j=0; j<fl.size(); j++)
+      fr.push_back(make_pair(fl[j] << sh, (fl[j]+1) << sh));
+    for (j=0; j<pl.size(); j++)
+      pr.push_back(make_pair(pl[j] << sh, (pl[j]+1) << sh));
+  }
+  a.clear_pixel();
+
+  toRanges(fr, f);
+  toRanges(pr, t);
+  DIF_rangeDifference(t, f, p);
+}
+
+
+void DIF_Region::go_expr()
+{
+  int maxlev = (schema == DIF_HTM  ?  params.back()  :  params[0]);
+  int ipart = locateParam(maxlev);
+  vector<DIF_Ranges> full, part;   //operands stack
+  DIF_Ranges f, p, t1, t2, t3;
+  unsigned int i, k;
+  unsigned long n;
+
+  exprSetup();
+
+  for (i=0; i<ex_code.size(); i++) {
+    int c = ex_code[i];
+    if (c >= 0) {
+      full.push_back(DIF_Ranges());
+      part.push_back(DIF_Ranges());
+      atomRanges(*ex_atom[c], maxlev, full.back(), part.back());
+      continue;
+    }
+
+    n = full.size();
+    DIF_Ranges& fa = full[n-2];
+    DIF_Ranges& pa = part[n-2];
+    DIF_Ranges& fb = full[n-1];
+    DIF_Ranges& pb = part[n-1];
+
+    switch (c) {
+      case EXPR_OR:
+        DIF_rangeUnion(fa, fb, f);
+        DIF_rangeUnion(pa, pb, t1);
+        DIF_rangeDifference(t1, f, p);
+        break;
+
+      case EXPR_AND:
+        DIF_rangeIntersection(fa, fb, f);
+        DIF_rangeUnion(fa, pa, t1);
+        DIF_rangeUnion(fb, pb, t2);
+        DIF_rangeIntersection(t1, t2, t3);
+        DIF_rangeDifference(t3, f, p);
+        break;
+
+      default:   //EXPR_MINUS
+        DIF_rangeUnion(fb, pb, t2);
+        DIF_rangeDifference(fa, t2, f);
+        DIF_rangeUnion(fa, pa, t1);
+        DIF_rangeDifference(t1, fb, t3);
+        DIF_rangeDifference(t3, f, p);
+    }
+
+    fa.swap(f);
+    pa.swap(p);
+    full.pop_back();
+    part.pop_back();
+  }
+
+  if (full.size() != 1)
+    return;
+
+// Full ranges: largest pixels of the available params, aligned in the range
+  for (n=0; n<full[0].size(); n++) {
+    long long int x = full[0].lo[n], hi = full[0].hi[n];
+    while (x < hi)
+      for (k=0; k<params.size(); k++) {
+        if (params[k] > maxlev)
+          continue;
+        int sh = 2*(maxlev - params[k]);
+        long long int np = 1LL << sh;
+        if ((x & (np - 1)) == 0  &&  x + np <= hi) {
+          pflist[k]->push_back(x >> sh);
+          x += np;
+          break;
+        }
+      }
+  }
+
+// Partial ranges at maxlev
+  vector<long long int>& pl = *pplist[ipart];
+  for (n=0; n<part[0].size(); n++)
+    for (long long int x = part[0].lo[n]; x < part[0].hi[n]; x++)
+      pl.push_back(x);
+}
@@ -0,0 +1,149 @@
+/*
+  Name:  DIF_frameParse, DIF_frameRotate, DIF_frameToEq, DIF_frameToEqPA
+
+  Description:
+   Regions given in Galactic or Ecliptic coordinates are rotated to the
+   equatorial (ICRS, J2000) frame of the indexed tables once, when they are
+   defined, so that pixels and fine search use equatorial unit vectors.
+
+   DIF_frameParse: frame from its name ("EQ", "ICRS", "J2000", "GAL",
+   "GALACTIC", "ECL", "ECLIPTIC", case insensitive), -1 if unknown.
+   DIF_frameRotate: rotate the unit vector v from the frame to equatorial.
+   DIF_frameToEq: equatorial coordinates (deg) of a frame lon, lat (deg),
+   unchanged for the equatorial frame.
+   DIF_frameToEqPA: equatorial position angle (deg, east of north) of a
+   direction with position angle pa in the frame at lon, lat.
+
+  Note:
+   Galactic to ICRS matrix from the Hipparcos catalogue (ESA 1997, vol. 1,
+   sect. 1.5.3), Ecliptic with the IAU 2006 J2000 obliquity.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <math.h>
+#include <strings.h>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* Galactic to equatorial (ICRS) rotation matrix */
+static const double GAL2EQ[3][3] = {
+  {-0.0548755604162154,  0.4941094278755837, -0.8676661490190047},
+  {-0.8734370902348850, -0.4448296299600112, -0.1980763734312015},
+  {-0.4838350155487132,  0.7469822444972189,  0.4559837761750669}
+};
+
+/* Obliquity of the ecliptic at J2000 (deg) */
+static const double ECL_EPS = 23.4392794444;
+
+
+int DIF_frameParse(const char* name, unsigned long len)
+{
+  static const char* eq[]  = {"EQ", "ICRS", "J2000", "FK5", "EQUATORIAL", 0};
+  static const char* gal[] = {"GAL", "GALACTIC", 0};
+  static const char* ecl[] = {"ECL", "ECLIPTIC", 0};
+  int i;
+
+  for (i=0; eq[i]; i++)
+    if (len == strlen(eq[i])  &&  ! strncasecmp(name, eq[i], len))
+      return DIF_FRAME_EQ;
+  for (i=0; gal[i]; i++)
+    if (len == strlen(gal[i])  &&  ! strncasecmp(name, gal[i], len))
+      return DIF_FRAME_GAL;
+  for (i=0; ecl[i]; i++)
+    if (len == strlen(ecl[i])  &&  ! strncasecmp(name, ecl[i], len))
+      return DIF_FRAME_ECL;
+
+  return -1;
+}
+
+
+
+void DIF_frameRotate(enum DIF_Frame frame, const double* v, double* w)
+{
+  int i;
+
+  switch (frame) {
+    case DIF_FRAME_GAL:
+      for (i=0; i<3; i++)
+        w[i] = GAL2EQ[i][0]*v[0] + GAL2EQ[i][1]*v[1] + GAL2EQ[i][2]*v[2];
+      break;
+
+    case DIF_FRAME_ECL: {
+      double ce = cos(ECL_EPS*DEG2RAD), se = sin(ECL_EPS*DEG2RAD);
+      double y = v[1], z = v[2];
+      w[0] = v[0];
+      w[1] = ce*y - se*z;
+      w[2] = se*y + ce*z;
+      break;
+    }
+
+    case DIF_FRAME_EQ:
+      for (i=0; i<3; i++)
+        w[i] = v[i];
+      break;
+  }
+}
+
+
+
+void DIF_frameToEq(enum DIF_Frame frame, double lon, double lat,
+                   double* ra, double* de)
+{
+  double v[3], w[3];
+  double l = lon*DEG2RAD, b = lat*DEG2RAD;
+
+  if (frame == DIF_FRAME_EQ) {
+    *ra = lon;
+    *de = lat;
+    return;
+  }
+
+  v[0] = cos(b)*cos(l);
+  v[1] = cos(b)*sin(l);
+  v[2] = sin(b);
+  DIF_frameRotate(frame, v, w);
+
+  if (w[2] > 1.) w[2] = 1.;
+  if (w[2] < -1.) w[2] = -1.;
+  *de = asin(w[2]) / DEG2RAD;
+  *ra = atan2(w[1], w[0]) / DEG2RAD;
+  if (*ra < 0.)
+    *ra += 360.;
+}
+
+
+
+double DIF_frameToEqPA(enum DIF_Frame frame, double lon, double lat,
+                       double pa)
+{
+  double ra, de;
+  double l = lon*DEG2RAD, b = lat*DEG2RAD;
+
+  if (frame == DIF_FRAME_EQ)
+    return pa;
+
+// Frame north at (lon, lat), rotated to equatorial
+  double nf[3] = {-sin(b)*cos(l), -sin(b)*sin(l), cos(b)};
+  double n[3];
+  DIF_frameRotate(frame, nf, n);
+
+// Equatorial north and east at the same point
+  DIF_frameToEq(frame, lon, lat, &ra, &de);
+  double r = ra*DEG2RAD, d = de*DEG2RAD;
+  double ne[3] = {-sin(d)*cos(r), -sin(d)*sin(r), cos(d)};
+  double ee[3] = {-sin(r), cos(r), 0.};
+
+  double th = atan2(n[0]*ee[0] + n[1]*ee[1] + n[2]*ee[2],
+                    n[0]*ne[0] + n[1]*ne[1] + n[2]*ne[2]);
+
+  return pa + th / DEG2RAD;
+}
@@ -7,12 +7,12 @@
    spherical coordinates.
    Result contains (tipically) 9 pixel numbers (in this order): central one,
    the SW, W, NW, N, NE, E, SE and S neighbor.
-   DIFgetHealPNeighb1C always creates a new Healpix_Base2 base and destroys
-   it on exit.
+   The shared (read only) base of the view scheme and order is used (see
+   getHealPBase), no base is allocated.
    This is a DIF custom version.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base2 )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) DIF_Region &p: Pointer to the DIF_Region class
    (i) double ra:   Right Ascension (degrees)
    (i) double dec:  Declination (degrees)
@@ -30,7 +30,7 @@
   Return 0 on success.
 
 
-  LN@IASF-INAF, March 2009                      Last change: 16/05/2016
+  LN@IASF-INAF, March 2009                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -52,45 +52,29 @@ int DIFgetHealPNeighbC(char*& saved, DIF_Region &p, double ra, double dec)
 {
   int64 id;
   fix_arr<int64, 8> idn_temp;
-  long long int my_nside;
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
 // Not an available order?
   if (p.params.size() == 0)
     return -1;
 
-// Default is RING scheme
-  int nested = 0, ik;
+// Default is NESTED scheme
+  int nested = 1;
+  if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
 
 // Use the smaller pixel (if more than one order)
 //   int k = p.params[0];
   int k = p.params.back();
 
-// Nested?
-  if (k < 0) {
-    nested = 1;
-    ik = -k;
-  }
-
-//cout << "Nested: "<< nested << "  Order: " << ik << endl;
-
   if (! saved) {
 
 // Out of range: return here
-    if ( ik > 29 )
+    if ((k < 0) || (k > 29))
       return -2;
 
-    my_nside = 1 << ik;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
 
   vector<long long int> &list = p.flist(k);
@@ -52,7 +52,7 @@ int DIFhtmCircleRegion(DIF_Region &p)
   vector<long long int> nid_depths;
 
   ValVec<uint64> plist, flist;  // List results
-  unsigned long long int i, j, j0=0;
+  unsigned long long int i, j0=0;
   double distance = cos(radius/60.*DEG2RAD);
 
 
@@ -67,11 +67,10 @@ int DIFhtmCircleRegion(DIF_Region &p)
     cvx.add(constr);
     domain.add(cvx);
 
-// Test for just number of trixels
-    vector<long long int> nid_part, nid_full;
-    domain.intersect(&index,depths,nid_part,nid_full);
-
 #ifdef DEBUG_PRINT
+// Test for just number of trixels
+vector<long long int> nid_part, nid_full;
+domain.intersect(&index,depths,nid_part,nid_full);
 for (i = 0; i < depths.size(); i++)
 cout <<"Depth: "<< depths[i] <<"  N full: "<< nid_full[i]
      <<"  N part: "<< nid_part[i] << endl << endl;
@@ -81,8 +80,6 @@ cout <<"Depth: "<< depths[i] <<"  N full: "<< nid_full[i]
 // Domain intersection
     domain.intersect(&index,depths,nid_depths,plist,flist);
 
-    vector<long long int> *list;
-
 #ifdef DEBUG_PRINT
 cout <<"N pars: "<< p.params.size() << endl;
 for (i = 0; i < p.params.size(); i++)
@@ -101,17 +98,13 @@ cout <<"DIFhtmCircleRegion: Depth: "<<i depths[i] <<"  N full: "<< nid_depths[i]
 #endif
 
 //      vector<long long int>& flist2 = p.flist(depths[i]);
-        list = &p.flist(depths[i]);
-
-        for (j = 0; j < nid_depths[i]; j++) {    // loop full nodes list
-
 #ifdef DEBUG_PRINT
+for (unsigned long long int j = 0; j < nid_depths[i]; j++)
 cout << j <<": "<< index.nameById(flist(j+j0)) <<": "<< flist(j+j0) << endl;
 #endif
 
-          list->push_back(flist(j+j0));
-        }
-        j0 += j;
+        DIF_appendIds(p.flist(depths[i]), flist, j0, nid_depths[i]);
+        j0 += nid_depths[i];
 //      }
     }
 
@@ -121,19 +114,13 @@ cout <<"\nDIFhtmCircleRegion: Total N full: "<< j0 << endl;
 
 // Returned list of partial nodes at the max depth
 //    vector<long long int>& plist2 = p.plist(max_depth);
-    list = &p.plist(max_depth);
-
 #ifdef DEBUG_PRINT
 cout <<"DIFhtmCircleRegion: N partial: "<< plist.length() << endl;
-#endif
-
-    for (i = 0; i < plist.length(); i++) {    // loop partial nodes list
-
-#ifdef DEBUG_PRINT
+for (i = 0; i < plist.length(); i++)
 cout << plist(i) << endl;
 #endif
-      list->push_back(plist(i));
-    }
+
+    DIF_appendIds(p.plist(max_depth), plist, 0, plist.length());
 
   }
   catch (SpatialException &x) {
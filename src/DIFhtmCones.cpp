@@ -0,0 +1,88 @@
+/*
+  Name:  int DIFhtmCones
+
+  Description:
+   Intersect a list of circular domains (multi-region search) with the HTM
+   grid returning into the input DIF_Region class, for each target, the IDs
+   of fully contained trixels of various depths and partial trixels of the
+   highest available depth.
+   The index is constructed once and used for all the targets.
+   For a single circular domain see 'DIFhtmCircleRegion'.
+
+  Parameters:
+   (i) DIF_Region &p:   Pointer to the DIF_Region class
+
+  Note:
+    All circles have the same radius p.rad (arcmin).
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                   ( Last change: 19/10/2026 )
+*/
+
+#include <vector>
+#include "SpatialInterface.h"
+
+#include "dif.hh"
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+
+int DIFhtmCones(DIF_Region &p)
+{
+// No available depth: return
+  if (p.params.size() == 0)
+    return -1;
+
+  int max_depth = p.params.back();
+
+// Out of range: return here (note that here we reject depth=0)
+  if ((max_depth <= 0) || (max_depth > 25))
+    return -1;
+
+  double distance = cos(p.rad/60.*DEG2RAD);
+  int it, nt = p.ntargets();
+  unsigned long long int i, j, j0;
+
+  try {
+// Construct index with max depth
+    const SpatialIndex index(max_depth);
+
+// Loop on targets
+    for (it = 0; it < nt; it++) {
+      vector<int> depths(p.params);
+      vector<long long int> nid_depths;
+      ValVec<uint64> plist, flist;  // List results
+
+      SpatialDomain domain;
+      SpatialVector v(p.targetRa(it), p.targetDec(it));
+      SpatialConvex cvx;
+      SpatialConstraint constr(v, distance);
+      cvx.add(constr);
+      domain.add(cvx);
+
+// Domain intersection
+      domain.intersect(&index,depths,nid_depths,plist,flist);
+
+// Full nodes at the various depths
+      j0 = 0;
+      for (i = 0; i < depths.size(); i++) {
+        for (j = 0; j < (unsigned long long int) nid_depths[i]; j++)
+          p.addTargetPix(it, depths[i], flist(j+j0), 1);
+        j0 += j;
+      }
+
+// Partial nodes at the max depth
+      for (i = 0; i < plist.length(); i++)
+        p.addTargetPix(it, max_depth, plist(i), 0);
+    }
+
+  }
+  catch (SpatialException &x) {
+    return -2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,102 @@
+/*
+  Name:  int DIFhtmPolygon
+
+  Description:
+   Intersect a spherical polygon with the HTM grid returning into the input
+   DIF_Region class IDs of fully contained trixels of various depths and
+   partial trixels of the highest available depth.
+   Each convex piece of the polygon (see DIF_Region::makePolygon) is a
+   convex of half-spaces bounded by its edges' great circles. The index is
+   constructed once and used for all the pieces. Trixels of adjacent pieces
+   are merged: a trixel full in a piece is never reported as partial, nor
+   is any descendant of it (see DIF_Region::dropCovered).
+
+  Parameters:
+   (i) DIF_Region &p:   Pointer to the DIF_Region class
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                   ( Last change: 19/10/2026 )
+*/
+
+#include <algorithm>
+#include <vector>
+#include "SpatialInterface.h"
+
+#include "dif.hh"
+
+
+int DIFhtmPolygon(DIF_Region &p)
+{
+// No available depth: return
+  if (p.params.size() == 0)
+    return -1;
+
+  int max_depth = p.params.back();
+
+// Out of range: return here (note that here we reject depth=0)
+  if ((max_depth <= 0) || (max_depth > 25))
+    return -1;
+
+  int ip, np = p.npieces();
+  unsigned long long int i, j0;
+  vector<long long int> part;
+
+  try {
+// Construct index with max depth
+    const SpatialIndex index(max_depth);
+
+// Loop on convex pieces
+    for (ip = 0; ip < np; ip++) {
+      vector<int> depths(p.params);
+      vector<long long int> nid_depths;
+      ValVec<uint64> plist, flist;  // List results
+
+      const vector<double>& n = p.piece(ip).nrm;
+      SpatialDomain domain;
+      SpatialConvex cvx;
+      for (i = 0; i < n.size(); i += 3) {
+        SpatialVector a(n[i], n[i+1], n[i+2]);
+        SpatialConstraint constr(a, 0.);
+        cvx.add(constr);
+      }
+      domain.add(cvx);
+
+// Domain intersection
+      domain.intersect(&index,depths,nid_depths,plist,flist);
+
+// Full nodes at the various depths
+      j0 = 0;
+      for (i = 0; i < depths.size(); i++) {
+        DIF_appendIds(p.flist(depths[i]), flist, j0, nid_depths[i]);
+        j0 += nid_depths[i];
+      }
+
+// Partial nodes at the max depth
+      DIF_appendIds(part, plist, 0, plist.length());
+    }
+
+  }
+  catch (SpatialException &x) {
+    return -2;
+  }
+
+// Merge pieces: sort, remove duplicates, full nodes from partial ones and
+// nodes covered by full ones of a lower depth
+  for (i = 0; i < p.params.size(); i++) {
+    vector<long long int>& list = p.flist(p.params[i]);
+    sort(list.begin(), list.end());
+    list.erase(unique(list.begin(), list.end()), list.end());
+  }
+
+  sort(part.begin(), part.end());
+  part.erase(unique(part.begin(), part.end()), part.end());
+
+  vector<long long int>& full = p.flist(max_depth);
+  vector<long long int>& plist = p.plist(max_depth);
+  DIF_setDifference(part, full, plist);
+  p.dropCovered();
+
+  return 0;
+}
@@ -183,7 +183,7 @@ int DIFhtmRectRegion4V(DIF_Region &p)
   vector<long long int> nid_depths;
 
   ValVec<uint64> plist, flist;  // List results
-  unsigned long long int i, j, j0=0;
+  unsigned long long int i, j0=0;
 
 
   try {
@@ -198,11 +198,10 @@ int DIFhtmRectRegion4V(DIF_Region &p)
     SpatialConvex cvx(&v1,&v2,&v3,&v4);
     domain.add(cvx);
 
-// Test for just number of trixels
-    vector<long long int> nid_part, nid_full;
-    domain.intersect(&index,depths,nid_part,nid_full);
-
 #ifdef DEBUG_PRINT
+// Test for just number of trixels
+vector<long long int> nid_part, nid_full;
+domain.intersect(&index,depths,nid_part,nid_full);
 for (i = 0; i < depths.size(); i++)
 cout <<"Depth: "<< depths[i] <<"  N full: "<< nid_full[i]
      <<"  N part: "<< nid_part[i] << endl;
@@ -213,33 +212,25 @@ cout <<"Depth: "<< depths[i] <<"  N full: "<< nid_full[i]
     domain.intersect(&index,depths,nid_depths,plist,flist);
     //domain.intersect(&index,plist,flist);
 
-    vector<long long int> *list;
-
 // Returned lists of full nodes at the various depths
     for (i = 0; i < depths.size(); i++) {
 #ifdef DEBUG_PRINT
 cout <<"DIFhtmRectRegion4V: Depth: "<< depths[i] <<"  N full: "<< nid_depths[i]
      << endl;
 #endif
-//      vector<long long int>& flist2 = p.flist(depths[i]);
-      list = &p.flist(depths[i]);
-
-      for (j = 0; j < nid_depths[i]; j++) {    // loop full nodes list
-        list->push_back(flist(j+j0));
 #ifdef DEBUG_PRINT
+for (unsigned long long int j = 0; j < nid_depths[i]; j++)
 cout << j <<": "<< index.nameById(flist(j+j0)) <<": "<< flist(j+j0) << endl;
 #endif
-      }
-      j0 += j;
+      DIF_appendIds(p.flist(depths[i]), flist, j0, nid_depths[i]);
+      j0 += nid_depths[i];
     }
 
 // Returned list of partial nodes at the max depth
-    list = &p.plist(max_depth);
 #ifdef DEBUG_PRINT
 cout <<"DIFhtmRectRegion4V: N partial: "<< plist.length() << endl;
 #endif
-    for (i = 0; i < plist.length(); i++)      // loop partial nodes list
-      list->push_back(plist(i));
+    DIF_appendIds(p.plist(max_depth), plist, 0, plist.length());
 
   }
   catch (SpatialException &x) {
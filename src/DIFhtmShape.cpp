@@ -0,0 +1,116 @@
+/*
+  Name:  int DIFhtmShape
+
+  Description:
+   Intersect an annulus, ellipse or great circle strip (see
+   DIF_Region::makeShape) with the HTM grid returning into the input
+   DIF_Region class IDs of fully contained trixels of various depths and
+   partial trixels of the highest available depth.
+   Annulus and strip are exactly a convex of two constraints (with negative
+   ones), intersected as the circle in DIFhtmCircleRegion. For the ellipse
+   the full trixels are those of the inscribed polygon, partial trixels
+   those of the circumscribed polygon not already covered by a full one.
+
+  Parameters:
+   (i) DIF_Region &p:   Pointer to the DIF_Region class
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                   ( Last change: 19/10/2026 )
+*/
+
+#include <algorithm>
+#include <vector>
+#include "SpatialInterface.h"
+
+#include "dif.hh"
+
+
+static void addConvex(SpatialDomain& domain, const DIF_Convex& c)
+{
+  SpatialConvex cvx;
+  for (unsigned int i = 0; i < c.d.size(); i++) {
+    SpatialVector a(c.nrm[3*i], c.nrm[3*i+1], c.nrm[3*i+2]);
+    SpatialConstraint constr(a, c.d[i]);
+    cvx.add(constr);
+  }
+  domain.add(cvx);
+}
+
+
+int DIFhtmShape(DIF_Region &p)
+{
+// No available depth: return
+  if (p.params.size() == 0)
+    return -1;
+
+  int max_depth = p.params.back();
+
+// Out of range: return here (note that here we reject depth=0)
+  if ((max_depth <= 0) || (max_depth > 25))
+    return -1;
+
+  vector<int> depths(p.params);
+  vector<long long int> nid_depths;
+
+  ValVec<uint64> plist, flist;  // List results
+  unsigned long long int i, j0=0;
+
+  try {
+// Construct index with max depth
+    const SpatialIndex index(max_depth);
+
+    SpatialDomain domain;
+    addConvex(domain, p.shapeIn());
+
+// Domain intersection
+    domain.intersect(&index,depths,nid_depths,plist,flist);
+
+// Full nodes at the various depths
+    for (i = 0; i < depths.size(); i++) {
+      DIF_appendIds(p.flist(depths[i]), flist, j0, nid_depths[i]);
+      j0 += nid_depths[i];
+    }
+
+    vector<long long int>& part = p.plist(max_depth);
+
+    if (p.shapeExact()) {
+// Partial nodes at the max depth
+      DIF_appendIds(part, plist, 0, plist.length());
+    }
+
+    else {
+// Partial and full nodes of the containing convex at the max depth
+      vector<int> odepth(1, max_depth);
+      vector<long long int> onid;
+      ValVec<uint64> oplist, oflist;
+
+      SpatialDomain odomain;
+      addConvex(odomain, p.shapeOut());
+      odomain.intersect(&index,odepth,onid,oplist,oflist);
+
+      vector<long long int> cand, tmp;
+      DIF_appendIds(cand, oplist, 0, oplist.length());
+      DIF_appendIds(cand, oflist, 0, oflist.length());
+      sort(cand.begin(), cand.end());
+      cand.erase(unique(cand.begin(), cand.end()), cand.end());
+
+// Drop nodes whose parent (or itself) is full at any depth
+      for (i = 0; i < depths.size(); i++) {
+        vector<long long int>& list = p.flist(depths[i]);
+        sort(list.begin(), list.end());
+        DIF_setDropCovered(cand, list, 2*(max_depth - depths[i]), tmp);
+        cand.swap(tmp);
+      }
+
+      part.insert(part.end(), cand.begin(), cand.end());
+    }
+
+  }
+  catch (SpatialException &x) {
+    return -2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,239 @@
+/*
+  Name:  DIF_MOCParse, DIF_MOCString, DIF_Region::inMOC
+
+  Description:
+   IVOA MOC (Multi-Order Coverage map) support. A MOC is a set of HEALPix
+   NESTED cells at mixed orders, internally stored as sorted and disjoint
+   ranges [lo, hi) of order 29 NESTED pixels.
+
+   DIF_MOCParse reads either:
+    - the ASCII serialization, i.e. "order/" followed by cells (or "i-j"
+      ranges of cells) of that order, separated by commas or blanks, as in
+      "3/1-5 4/35,36 6/";
+    - the binary ranges serialization: pairs of little-endian unsigned
+      64 bit integers (lo, hi) at order 29, e.g. a blob read by LOAD_FILE().
+   Return the number of ranges, -1 on error.
+
+   DIF_MOCString writes the ASCII serialization of the MOC made of the
+   given order NESTED pixel IDs: every 4 sibling cells are replaced by their
+   parent, so that the result is the normalized (smallest) MOC.
+
+   DIF_Region::inMOC: whether the given coordinates fall inside the MOC.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+#include <stdio.h>
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* Maximum HEALPix order */
+static const int MOC_MAX_ORDER = 29;
+
+/* Number of order 29 pixels */
+static const unsigned long long MOC_NPIX29 = 12ULL << (2*MOC_MAX_ORDER);
+
+
+static bool mocAsciiChar(char c)
+{
+  return ((c >= '0'  &&  c <= '9')  ||  c == '/'  ||  c == '-'  ||  c == ','  ||
+          c == ' '  ||  c == '\t'  ||  c == '\r'  ||  c == '\n');
+}
+
+
+static bool mocSep(char c)
+{
+  return (c == ','  ||  c == ' '  ||  c == '\t'  ||  c == '\r'  ||  c == '\n');
+}
+
+
+// Read an unsigned integer at moc[*pos]: false if no digit is found
+static bool mocNumber(const char* moc, unsigned long len, unsigned long* pos,
+                      unsigned long long* val)
+{
+  unsigned long p = *pos;
+  unsigned long long v = 0;
+
+  if (p >= len  ||  moc[p] < '0'  ||  moc[p] > '9')
+    return false;
+  while (p < len  &&  moc[p] >= '0'  &&  moc[p] <= '9') {
+    if (v > (MOC_NPIX29 / 10))
+      return false;
+    v = v*10 + (moc[p] - '0');
+    p++;
+  }
+
+  *pos = p;
+  *val = v;
+  return true;
+}
+
+
+int DIF_MOCParse(const char* moc, unsigned long len,
+                 vector<unsigned long long>& lo,
+                 vector<unsigned long long>& hi)
+{
+  vector<pair<unsigned long long, unsigned long long> > rng;
+  unsigned long i;
+
+  lo.clear();
+  hi.clear();
+
+  bool ascii = true;
+  for (i=0; i<len  &&  ascii; i++)
+    ascii = mocAsciiChar(moc[i]);
+
+  if (ascii) {
+    int order = -1;
+    unsigned long pos = 0;
+    unsigned long long a, b;
+
+    while (pos < len) {
+      if (mocSep(moc[pos])) {
+        pos++;
+        continue;
+      }
+      if (! mocNumber(moc, len, &pos, &a))
+        return -1;
+
+      if (pos < len  &&  moc[pos] == '/') {   // New order
+        if (a > MOC_MAX_ORDER)
+          return -1;
+        order = a;
+        pos++;
+        continue;
+      }
+      if (order < 0)
+        return -1;
+
+      b = a;
+      if (pos < len  &&  moc[pos] == '-') {
+        pos++;
+        if (! mocNumber(moc, len, &pos, &b))
+          return -1;
+      }
+
+      int sh = 2*(MOC_MAX_ORDER - order);
+      if (b < a  ||  b >= (12ULL << (2*order)))
+        return -1;
+      rng.push_back(make_pair(a << sh, (b+1) << sh));
+    }
+  }
+
+  else {
+    if (len % 16)
+      return -1;
+    const unsigned char* u = (const unsigned char*) moc;
+    for (i=0; i<len; i+=16) {
+      unsigned long long a = 0, b = 0;
+      for (int k=7; k>=0; k--) {
+        a = (a << 8) | u[i+k];
+        b = (b << 8) | u[i+8+k];
+      }
+      if (a >= b  ||  b > MOC_NPIX29)
+        return -1;
+      rng.push_back(make_pair(a, b));
+    }
+  }
+
+// Sort and merge overlapping or adjacent ranges
+  sort(rng.begin(), rng.end());
+  for (i=0; i<rng.size(); i++) {
+    if (hi.size()  &&  rng[i].first <= hi.back()) {
+      if (rng[i].second > hi.back())
+        hi.back() = rng[i].second;
+    } else {
+      lo.push_back(rng[i].first);
+      hi.push_back(rng[i].second);
+    }
+  }
+
+  return lo.size();
+}
+
+
+
+void DIF_MOCString(int order, vector<long long int>& ids, string& out)
+{
+  vector<vector<long long int> > cells(order+1);
+  vector<long long int> cur, par;
+  unsigned long i;
+  char buf[64];
+  int o;
+
+  out.clear();
+
+  sort(ids.begin(), ids.end());
+  ids.erase(unique(ids.begin(), ids.end()), ids.end());
+  for (i=0; i<ids.size(); i++)
+    if (ids[i] >= 0  &&  ids[i] < (long long int) (12LL << (2*order)))
+      cur.push_back(ids[i]);
+
+// Replace complete sets of 4 siblings by their parent
+  for (o=order; o>0; o--) {
+    par.clear();
+    for (i=0; i<cur.size(); ) {
+      if (cur[i] % 4 == 0  &&  i+3 < cur.size()  &&  cur[i+3] == cur[i]+3) {
+        par.push_back(cur[i] >> 2);
+        i += 4;
+      } else
+        cells[o].push_back(cur[i++]);
+    }
+    cur.swap(par);
+  }
+  cells[0] = cur;
+
+// "order/" followed by cells and ranges of consecutive cells
+  for (o=0; o<=order; o++) {
+    vector<long long int>& c = cells[o];
+    if (c.size() == 0)
+      continue;
+
+    if (out.size())
+      out += " ";
+    sprintf(buf, "%d/", o);
+    out += buf;
+
+    for (i=0; i<c.size(); ) {
+      unsigned long j = i;
+      while (j+1 < c.size()  &&  c[j+1] == c[j]+1)
+        j++;
+      if (j > i)
+        sprintf(buf, "%s%lld-%lld", (i ? "," : ""), c[i], c[j]);
+      else
+        sprintf(buf, "%s%lld", (i ? "," : ""), c[i]);
+      out += buf;
+      i = j+1;
+    }
+  }
+
+// Empty MOC: just the order
+  if (out.size() == 0) {
+    sprintf(buf, "%d/", order);
+    out = buf;
+  }
+}
+
+
+
+bool DIF_Region::inMOC(double ra, double de)
+{
+  long long int id;
+  getHealPidBatch(1, &MOC_MAX_ORDER, 1, 1, &ra, &de, &id);
+
+// Last range starting at or before id
+  vector<unsigned long long>::iterator it =
+    upper_bound(moc_lo.begin(), moc_lo.end(), id);
+  if (it == moc_lo.begin())
+    return false;
+  return (id < moc_hi[(it - moc_lo.begin()) - 1]);
+}
@@ -27,7 +27,7 @@
   05/07/2016: Correct DIF_HEALP_RING setting to reflect udf.cc fix
 
 
-  LN@IASF-INAF, March 2009                        Last change: 07/07/2016
+  LN@IASF-INAF, March 2009                        Last change: 19/10/2026
 */
 
 #include <algorithm>
@@ -48,11 +48,6 @@ using namespace std;
 #include "dif.hh"
 
 
-extern void difflist_i(vector<long long int>& v1,
-                       vector<long long int>& v2,
-                       vector<long long int>& vdiff);
-
-
 int DIFmyHealPCone(DIF_Region &p)
 {
 
@@ -60,7 +55,6 @@ int DIFmyHealPCone(DIF_Region &p)
   if (p.params.size() == 0)
     return -1;
 
-  int64 my_nside;
   vector<int64> tmp_list;
   vector<long long int> all;
   unsigned long long int j;
@@ -70,12 +64,11 @@ int DIFmyHealPCone(DIF_Region &p)
   double radius = p.rad;
 
 // Default is NESTED scheme
-  int nested = 1, ik;
+  int nested = 1;
 
 
   if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
   int k = p.params[0];
-  ik = k;
 
 //// Nested?
 //  if (k < 0) {
@@ -90,20 +83,11 @@ int DIFmyHealPCone(DIF_Region &p)
   if ((k < 0) || (k > 29))
     return -2;
 
-  my_nside = 1 << ik;
-
-  T_Healpix_Base<int64>* base;
-
-  if (nested)
-//    Healpix_Base2 base (my_nside, NEST, SET_NSIDE);
-    base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-  else
-//    Healpix_Base2 base (my_nside, RING, SET_NSIDE);
-    base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
+// Shared base: nothing to destroy on return
+  const T_Healpix_Base<int64>* base = getHealPBase(nested, k);
 
 #ifdef DEBUG_PRINT
-//  int order = base.nside2order(my_nside);
-  cout <<"Nside of map: "<< my_nside << endl;
+  cout <<"Nside of map: "<< base->Nside() << endl;
 #endif
 
   pointing ptg;
@@ -170,14 +154,13 @@ cout<<"rad="<<rad<<endl;
 
 // Decrease by the max pix. radius. This would give all pixel (approx ?!)
 // fully covered by the disc.
-//--  base.query_disc(ptg, rad-1.362*M_PI/(4*my_nside), tmp_list);
+//--  base.query_disc(ptg, rad-1.362*M_PI/(4*base->Nside()), tmp_list);
   //base->query_disc(ptg, rad-mpr, tmp_list);
 
     if (rad-mpr > 0) {
       base->query_disc(ptg, rad-mpr, tmp_list);
 
-      for (j=0; j<tmp_list.size(); j++)
-        flist->push_back( tmp_list[j] );
+      flist->insert(flist->end(), tmp_list.begin(), tmp_list.end());
 
       tmp_list.clear();
 
@@ -191,7 +174,7 @@ cout<<"rad="<<rad<<endl;
     }
 
 // Difference -> partial nodes
-    difflist_i(all,*flist,*plist);
+    DIF_setDifference(all,*flist,*plist);
 
 #ifdef DEBUG_PRINT
   cout <<"DIFmyHealPCone: N partial: "<< plist->size() << endl;
@@ -0,0 +1,111 @@
+/*
+  Name:  int DIFmyHealPCones
+
+  Description:
+   Calculates, for each target of a multi-region search, full and partial
+   pixels intersected by a cone in the HEALPix RING or NESTED sheme.
+   The HEALPix base is constructed once and used for all the targets.
+   For a single cone see 'DIFmyHealPCone'.
+
+  Parameters:
+   (i) DIF_Region &p:  Pointer to the DIF_Region class
+
+  Note:
+   All cones have the same radius p.rad (arcmin).
+   As in DIFmyHealPCone, returned partial pixels could be > real ones, full
+   pixels could be < real ones.
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* Minimum cone radius (rad): ~ 1 mas - see DIFmyHealPCone */
+static const double MIN_CONE_RAD = 5e-9;
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+int DIFmyHealPCones(DIF_Region &p)
+{
+
+// No available order: return
+  if (p.params.size() == 0)
+    return -1;
+
+// Default is NESTED scheme
+  int nested = 1;
+  if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
+  int k = p.params[0];
+
+// Out of range: return here
+  if ((k < 0) || (k > 29))
+    return -2;
+
+  const T_Healpix_Base<int64>& base = *getHealPBase(nested, k);
+
+  double rad = p.rad/60.*DEG2RAD;
+  if (rad < MIN_CONE_RAD)
+    rad = MIN_CONE_RAD;
+
+  vector<int64> all, full;
+  vector<int64>::iterator ia, iF;
+  int it, nt = p.ntargets();
+
+  try {
+
+// maximum angular distance between any pixel center and its corners
+    double mpr = base.max_pixrad();
+
+    for (it = 0; it < nt; it++) {
+      pointing ptg;
+      ptg.theta = (90. - p.targetDec(it))*DEG2RAD;
+      ptg.phi   = p.targetRa(it)*DEG2RAD;
+
+// All intersted pixels (sorted)
+      base.query_disc_inclusive(ptg, rad, all, 2);
+
+      if (all.size() == 1) {
+        p.addTargetPix(it, k, all[0], 0);
+        continue;
+      }
+
+// Pixels fully covered (sorted)
+      full.clear();
+      if (rad-mpr > 0)
+        base.query_disc(ptg, rad-mpr, full);
+
+// Full pixels, then the difference -> partial pixels
+      for (iF = full.begin(); iF != full.end(); iF++)
+        p.addTargetPix(it, k, *iF, 1);
+
+      iF = full.begin();
+      for (ia = all.begin(); ia != all.end(); ia++) {
+        while (iF != full.end()  &&  *iF < *ia) iF++;
+        if (iF == full.end()  ||  *iF != *ia)
+          p.addTargetPix(it, k, *ia, 0);
+      }
+    }
+
+    return 0;
+
+  }
+  catch (std::exception &e) {
+    cout <<"Error executing DIFmyHealPCones. std::exception: "<< e.what() << std::endl;
+    return -3;
+  }
+
+}
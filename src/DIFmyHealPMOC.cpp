@@ -0,0 +1,96 @@
+/*
+  Name:  int DIFmyHealPMOC
+
+  Description:
+   Calculates full and partial pixels of a MOC (see DIF_MOCParse) in the
+   HEALPix RING or NESTED sheme.
+   MOC ranges are at order 29, so they are simply shifted to the requested
+   order: a pixel is full if entirely covered by a range, partial if only
+   the first or last pixel of a range (not aligned to the pixel boundaries).
+   NESTED IDs are converted to RING IDs if needed.
+
+  Parameters:
+   (i) DIF_Region &p:  Pointer to the DIF_Region class
+
+  Note:
+   Unlike the other regions, full and partial pixels are exact.
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+int DIFmyHealPMOC(DIF_Region &p)
+{
+
+// No available order: return
+  if (p.params.size() == 0)
+    return -1;
+
+// Default is NESTED scheme
+  int nested = 1;
+  if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
+  int k = p.params[0];
+
+// Out of range: return here
+  if ((k < 0) || (k > 29))
+    return -2;
+
+  int sh = 2*(29 - k);
+  unsigned long long int i, lo, hi, mask = (1ULL << sh) - 1;
+  long long int id, id0, id1;
+
+  vector<long long int> part;
+  vector<long long int>& full = p.flist(k);
+
+  for (i = 0; i < (unsigned long long int) p.nmocranges(); i++) {
+    lo = p.mocLo(i);
+    hi = p.mocHi(i);
+    id0 = lo >> sh;           // first pixel
+    id1 = (hi - 1) >> sh;     // last pixel
+
+    if (lo & mask)
+      part.push_back(id0++);
+    if (id1 >= id0  &&  (hi & mask))
+      part.push_back(id1--);
+    for (id = id0; id <= id1; id++)
+      full.push_back(id);
+  }
+
+// Consecutive ranges can share a partial pixel
+  sort(part.begin(), part.end());
+  part.erase(unique(part.begin(), part.end()), part.end());
+
+  vector<long long int>& plist = p.plist(k);
+  plist.insert(plist.end(), part.begin(), part.end());
+
+  if (! nested) {
+    try {
+      const T_Healpix_Base<int64>& base = *getHealPBase(1, k);
+      for (i = 0; i < full.size(); i++)
+        full[i] = base.nest2ring(full[i]);
+      for (i = 0; i < plist.size(); i++)
+        plist[i] = base.nest2ring(plist[i]);
+    }
+    catch (std::exception &e) {
+      cout <<"Error executing DIFmyHealPMOC. std::exception: "<< e.what() << std::endl;
+      return -3;
+    }
+    sort(full.begin(), full.end());
+    sort(plist.begin(), plist.end());
+  }
+
+  return 0;
+}
@@ -0,0 +1,115 @@
+/*
+  Name:  int DIFmyHealPPolygon
+
+  Description:
+   Calculates full and partial pixels intersected by a spherical polygon in
+   the HEALPix RING or NESTED sheme.
+   Pixels of each convex piece of the polygon (see DIF_Region::makePolygon)
+   are given by "query_polygon_inclusive" in the NESTED scheme (the RING
+   version can miss pixels close to the poles), converted to RING IDs if
+   needed. A pixel is full if its center is inside the piece by more than
+   the maximum pixel radius. Pixels of adjacent pieces are merged: a pixel
+   full in a piece is never reported as partial.
+
+  Parameters:
+   (i) DIF_Region &p:  Pointer to the DIF_Region class
+
+  Note:
+   As in DIFmyHealPCone, returned partial pixels could be > real ones, full
+   pixels could be < real ones.
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+int DIFmyHealPPolygon(DIF_Region &p)
+{
+
+// No available order: return
+  if (p.params.size() == 0)
+    return -1;
+
+// Default is NESTED scheme
+  int nested = 1;
+  if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
+  int k = p.params[0];
+
+// Out of range: return here
+  if ((k < 0) || (k > 29))
+    return -2;
+
+  const T_Healpix_Base<int64>& base = *getHealPBase(1, k);
+
+  vector<long long int> part;
+  vector<long long int>& full = p.flist(k);
+  vector<int64> tmp_list;
+  unsigned long long int j;
+  int ip, np = p.npieces();
+
+  try {
+
+// maximum angular distance between any pixel center and its corners
+// (incremented by 50% as in DIFmyHealPRect4V)
+    double margin = sin(base.max_pixrad() * 1.5);
+
+    for (ip = 0; ip < np; ip++) {
+      const vector<int>& vtx = p.piece(ip).vtx;
+      vector<pointing> vertex;
+      rangeset<int64> pixset;
+
+      for (j = 0; j < vtx.size(); j++) {
+        pointing ptg;
+        ptg.theta = (90. - p.vertexDec(vtx[j]))*DEG2RAD;
+        ptg.phi   = p.vertexRa(vtx[j])*DEG2RAD;
+        vertex.push_back(ptg);
+      }
+
+// All interested pixels
+      base.query_polygon_inclusive(vertex, pixset, 8);
+      pixset.toVector(tmp_list);
+
+// Full if the center is far enough from all the edges
+      for (j = 0; j < tmp_list.size(); j++) {
+        vec3 v = base.pix2vec(tmp_list[j]);
+        int64 id = (nested  ?  tmp_list[j]  :  base.nest2ring(tmp_list[j]));
+        if (p.inPiece(ip, v.x, v.y, v.z, margin))
+          full.push_back(id);
+        else
+          part.push_back(id);
+      }
+    }
+
+  }
+  catch (std::exception &e) {
+    cout <<"Error executing DIFmyHealPPolygon. std::exception: "<< e.what() << std::endl;
+    return -3;
+  }
+
+// Merge pieces: sort, remove duplicates and full pixels from partial ones
+  sort(full.begin(), full.end());
+  full.erase(unique(full.begin(), full.end()), full.end());
+  sort(part.begin(), part.end());
+  part.erase(unique(part.begin(), part.end()), part.end());
+
+  vector<long long int>& plist = p.plist(k);
+  DIF_setDifference(part, full, plist);
+
+  return 0;
+}
@@ -29,7 +29,7 @@
   Return 0 on success.
 
 
-  LN@INAF-OAS, July 2016                   ( Last change: 21/03/2020 )
+  LN@INAF-OAS, July 2016                   ( Last change: 19/10/2026 )
 */
 
 #include <algorithm>
@@ -49,11 +49,6 @@ using namespace std;
 #include "dif.hh"
 
 
-extern void difflist_i(vector<long long int>& v1,
-                       vector<long long int>& v2,
-                       vector<long long int>& vdiff);
-
-
 // Input RA and Dec arrays of the four corners.
 // This is the main function and the only one used by DIF.
 
@@ -64,7 +59,6 @@ int DIFmyHealPRect4V(DIF_Region &p)
   if (p.params.size() == 0)
   return -1;
 
-  int64 my_nside;
   vector<int64> tmp_list;
   vector<long long int> all;
   unsigned long long int j;
@@ -81,14 +75,8 @@ int DIFmyHealPRect4V(DIF_Region &p)
   if ((k < 0) || (k > 29))
     return -2;
 
-  my_nside = 1 << k;
-
-  T_Healpix_Base<int64>* base;
-
-  if (nested)
-    base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-  else
-    base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
+// Shared base: nothing to destroy on return
+  const T_Healpix_Base<int64>* base = getHealPBase(nested, k);
 
   try {
     std::vector<pointing> vertex;
@@ -191,8 +179,7 @@ for (unsigned short i=0; i<4; i++)
 
         pixset.toVector(tmp_list);
 
-        for (j=0; j<tmp_list.size(); j++)
-          flist->push_back( tmp_list[j] );
+        flist->insert(flist->end(), tmp_list.begin(), tmp_list.end());
 
         tmp_list.clear();
 
@@ -207,7 +194,7 @@ for (unsigned short i=0; i<4; i++)
     }
 
 // Difference -> partial nodes
-    difflist_i(all,*flist,*plist);
+    DIF_setDifference(all,*flist,*plist);
     return 0;
 
   }
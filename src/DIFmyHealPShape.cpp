@@ -0,0 +1,120 @@
+/*
+  Name:  int DIFmyHealPShape
+
+  Description:
+   Calculates full and partial pixels intersected by an annulus, ellipse or
+   great circle strip (see DIF_Region::makeShape) in the HEALPix RING or
+   NESTED sheme.
+   The NESTED hierarchy is descended from the 12 base pixels, as in
+   Healpix_Base::query_multidisc_general (which is not available for these
+   non-disc regions): a pixel whose center is inside the region by more than
+   its radius is full (with all its sub-pixels), if it is outside by more
+   than its radius it is skipped, otherwise its 4 sub-pixels are checked up
+   to the requested order, where it is partial.
+   NESTED IDs are converted to RING IDs if needed.
+
+  Parameters:
+   (i) DIF_Region &p:  Pointer to the DIF_Region class
+
+  Note:
+   As in DIFmyHealPCone, returned partial pixels could be > real ones, full
+   pixels could be < real ones. The pixel radius is the maximum pixel radius,
+   the safety distance of query_multidisc_general.
+
+  Return 0 on success.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+#include <utility>
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+int DIFmyHealPShape(DIF_Region &p)
+{
+
+// No available order: return
+  if (p.params.size() == 0)
+    return -1;
+
+// Default is NESTED scheme
+  int nested = 1;
+  if (p.getSchema() == DIF_HEALP_RING) { nested = 0; } // Ring schema?
+  int k = p.params[0];
+
+// Out of range: return here
+  if ((k < 0) || (k > 29))
+    return -2;
+
+  vector<long long int>& full = p.flist(k);
+  vector<long long int>& part = p.plist(k);
+  int o;
+
+  try {
+
+// Bases and pixel radius at the orders to be descended
+    vector<const T_Healpix_Base<int64>*> base(k+1);
+    vector<double> pixrad(k+1);
+    for (o = 0; o <= k; o++) {
+      base[o] = getHealPBase(1, o);
+      pixrad[o] = base[o]->max_pixrad();
+    }
+
+    vector<pair<int64, int> > stk;   // pixels and their order
+    for (o = 11; o >= 0; o--)
+      stk.push_back(make_pair((int64) o, 0));
+
+    while (stk.size()) {
+      int64 pix = stk.back().first;
+      o = stk.back().second;
+      stk.pop_back();
+
+      vec3 v = base[o]->pix2vec(pix);
+      int c = p.classifyShape(v.x, v.y, v.z, pixrad[o]);
+
+      if (c < 0)
+        continue;
+
+      if (c > 0) {   // all its sub-pixels at order k
+        int sh = 2*(k - o);
+        for (int64 id = pix << sh; id < ((pix+1) << sh); id++)
+          full.push_back(id);
+      }
+      else if (o == k)
+        part.push_back(pix);
+      else
+        for (int i = 3; i >= 0; i--)
+          stk.push_back(make_pair(4*pix + i, o+1));
+    }
+
+    if (! nested) {
+      unsigned long long int j;
+      for (j = 0; j < full.size(); j++)
+        full[j] = base[k]->nest2ring(full[j]);
+      for (j = 0; j < part.size(); j++)
+        part[j] = base[k]->nest2ring(part[j]);
+    }
+
+  }
+  catch (std::exception &e) {
+    cout <<"Error executing DIFmyHealPShape. std::exception: "<< e.what() << std::endl;
+    return -3;
+  }
+
+// Depth first descent gives sorted NESTED IDs
+  if (! nested) {
+    sort(full.begin(), full.end());
+    sort(part.begin(), part.end());
+  }
+
+  return 0;
+}
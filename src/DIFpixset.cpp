@@ -0,0 +1,393 @@
+/*
+  Name:  DIF_PixelSet
+
+  Description:
+   Compressed set of pixel IDs, used for the large pixel lists of a region
+   (see DIF_Region::compact).
+   The IDs are grouped in blocks by their high bits (ID >> 16) and the low
+   16 bits of each block are stored in the smallest of:
+    - ENC_DELTA:  the first value and the differences from the previous
+                  one, as varints (7 bits per byte), for sparse blocks;
+    - ENC_RUN:    runs of consecutive values as the distance from the end
+                  of the previous run and the length, as varints;
+    - ENC_BITMAP: a bitmap of 1024 64-bit words, for dense blocks.
+   Union, intersection and difference merge the two block lists by key:
+   blocks in one set only are copied (or skipped), blocks with the same key
+   are expanded to bitmaps, combined word by word and encoded again.
+   The Cursor reads the IDs in ascending order as maximal runs of
+   consecutive values, so that ranges (DIF.difr) come out directly.
+
+  Note:
+   The output set of setUnion, setIntersection and setDifference must be
+   different from the input ones.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <string.h>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* Bitmap words of a block */
+static const unsigned int NWORDS = 1024;
+
+
+static unsigned int varintSize(unsigned int x)
+{
+  return (x < 128  ?  1  :  (x < 16384  ?  2  :  3));
+}
+
+
+static void putVarint(vector<unsigned char>& d, unsigned int x)
+{
+  while (x >= 128) {
+    d.push_back((unsigned char) ((x & 127) | 128));
+    x >>= 7;
+  }
+  d.push_back((unsigned char) x);
+}
+
+
+static unsigned int getVarint(const unsigned char* d, unsigned int& pos)
+{
+  unsigned int x = 0, sh = 0;
+  unsigned char c;
+  do {
+    c = d[pos++];
+    x |= (unsigned int) (c & 127) << sh;
+    sh += 7;
+  } while (c & 128);
+  return x;
+}
+
+
+
+void DIF_PixelSet::clear()
+{
+  blk.clear();
+  data.clear();
+  words.clear();
+  card = 0;
+}
+
+
+// Append a block of n sorted low values, in the smallest encoding
+void DIF_PixelSet::addBlock(unsigned long long key, const unsigned short* low,
+                            unsigned int n)
+{
+  unsigned int i, dbytes, rbytes, prev_end = 0;
+
+  dbytes = varintSize(low[0]);
+  rbytes = 0;
+  for (i=0; i<n; ) {
+    unsigned int s = i;
+    while (i+1 < n  &&  low[i+1] == low[i] + 1)
+      i++;
+    rbytes += varintSize(s  ?  low[s] - prev_end - 1  :  low[s]);
+    rbytes += varintSize(i - s);
+    prev_end = low[i];
+    i++;
+  }
+  for (i=1; i<n; i++)
+    dbytes += varintSize(low[i] - low[i-1]);
+
+  Block b;
+  b.key = key;
+  b.card = n;
+
+  if (rbytes <= dbytes  &&  rbytes < NWORDS*8) {
+    b.enc = ENC_RUN;
+    b.off = data.size();
+    for (i=0; i<n; ) {
+      unsigned int s = i;
+      while (i+1 < n  &&  low[i+1] == low[i] + 1)
+        i++;
+      putVarint(data, s  ?  low[s] - prev_end - 1  :  low[s]);
+      putVarint(data, i - s);
+      prev_end = low[i];
+      i++;
+    }
+    b.len = data.size() - b.off;
+  }
+  else if (dbytes < NWORDS*8) {
+    b.enc = ENC_DELTA;
+    b.off = data.size();
+    putVarint(data, low[0]);
+    for (i=1; i<n; i++)
+      putVarint(data, low[i] - low[i-1]);
+    b.len = data.size() - b.off;
+  }
+  else {
+    b.enc = ENC_BITMAP;
+    b.off = words.size();
+    b.len = NWORDS;
+    words.resize(words.size() + NWORDS, 0);
+    unsigned long long* w = &words[b.off];
+    for (i=0; i<n; i++)
+      w[low[i] >> 6] |= 1ULL << (low[i] & 63);
+  }
+
+  blk.push_back(b);
+  card += n;
+}
+
+
+void DIF_PixelSet::copyBlock(const DIF_PixelSet& s, const Block& b)
+{
+  Block c = b;
+  if (b.enc == ENC_BITMAP) {
+    c.off = words.size();
+    words.insert(words.end(), s.words.begin() + b.off,
+                 s.words.begin() + b.off + b.len);
+  }
+  else {
+    c.off = data.size();
+    data.insert(data.end(), s.data.begin() + b.off,
+                s.data.begin() + b.off + b.len);
+  }
+  blk.push_back(c);
+  card += c.card;
+}
+
+
+void DIF_PixelSet::toBitmap(const Block& b, unsigned long long* w) const
+{
+  unsigned int i, pos = b.off, low = 0;
+
+  if (b.enc == ENC_BITMAP) {
+    memcpy(w, &words[b.off], NWORDS * sizeof(unsigned long long));
+    return;
+  }
+
+  memset(w, 0, NWORDS * sizeof(unsigned long long));
+  const unsigned char* d = (data.size()  ?  &data[0]  :  NULL);
+
+  if (b.enc == ENC_DELTA)
+    for (i=0; i<b.card; i++) {
+      low = (i  ?  low + getVarint(d, pos)  :  getVarint(d, pos));
+      w[low >> 6] |= 1ULL << (low & 63);
+    }
+  else
+    for (i=0; i<b.card; ) {
+      unsigned int g = getVarint(d, pos);
+      low = (i  ?  low + 1 + g  :  g);
+      unsigned int len = getVarint(d, pos) + 1;
+      for (unsigned int k=0; k<len; k++, low++)
+        w[low >> 6] |= 1ULL << (low & 63);
+      low--;
+      i += len;
+    }
+}
+
+
+void DIF_PixelSet::assign(const vector<long long int>& ids)
+{
+  vector<unsigned short> low;
+  unsigned long i = 0, n = ids.size();
+
+  clear();
+  while (i < n) {
+    unsigned long long key = (unsigned long long) ids[i] >> 16;
+    low.clear();
+    while (i < n  &&  ((unsigned long long) ids[i] >> 16) == key)
+      low.push_back((unsigned short) (ids[i++] & 0xFFFF));
+    addBlock(key, &low[0], low.size());
+  }
+}
+
+
+void DIF_PixelSet::toVector(vector<long long int>& ids) const
+{
+  Cursor c;
+  long long int lo, hi;
+
+  ids.clear();
+  ids.reserve(card);
+  c.begin(*this);
+  while (c.nextRun(lo, hi, card))
+    for (long long int id=lo; id<=hi; id++)
+      ids.push_back(id);
+}
+
+
+// op: 0 union, 1 intersection, 2 difference
+void DIF_PixelSet::combine(const DIF_PixelSet& x, const DIF_PixelSet& y,
+                           int op, DIF_PixelSet& out)
+{
+  vector<unsigned long long> wx(NWORDS), wy(NWORDS);
+  vector<unsigned short> low(NWORDS*64);
+  unsigned int i = 0, j = 0, k, nx = x.blk.size(), ny = y.blk.size();
+
+  out.clear();
+  while (i < nx  ||  j < ny) {
+    if (j == ny  ||  (i < nx  &&  x.blk[i].key < y.blk[j].key)) {
+      if (op != 1)
+        out.copyBlock(x, x.blk[i]);
+      i++;
+    }
+    else if (i == nx  ||  y.blk[j].key < x.blk[i].key) {
+      if (op == 0)
+        out.copyBlock(y, y.blk[j]);
+      j++;
+    }
+    else {
+      x.toBitmap(x.blk[i], &wx[0]);
+      y.toBitmap(y.blk[j], &wy[0]);
+      unsigned int n = 0;
+      for (k=0; k<NWORDS; k++) {
+        unsigned long long w = (op == 0  ?  wx[k] | wy[k]  :
+                                (op == 1  ?  wx[k] & wy[k]  :
+                                 wx[k] & ~wy[k]));
+        while (w) {
+          low[n++] = (unsigned short) (k*64 + __builtin_ctzll(w));
+          w &= w - 1;
+        }
+      }
+      if (n > 0)
+        out.addBlock(x.blk[i].key, &low[0], n);
+      i++;
+      j++;
+    }
+  }
+}
+
+
+
+void DIF_PixelSet::Cursor::openBlock()
+{
+  if (ib >= set->blk.size())
+    return;
+  const Block& B = set->blk[ib];
+  pos = (B.enc == ENC_BITMAP  ?  0  :  B.off);
+  left = B.card;
+  last = 0;
+  bits = (B.enc == ENC_BITMAP  ?  set->words[B.off]  :  0);
+}
+
+
+bool DIF_PixelSet::Cursor::fetch()
+{
+  while (ib < set->blk.size()) {
+    const Block& B = set->blk[ib];
+
+    if (left == 0) {
+      ib++;
+      openBlock();
+      continue;
+    }
+
+    long long int base = (long long int) (B.key << 16);
+    unsigned int lo, hi;
+    const unsigned char* d = (set->data.size()  ?  &set->data[0]  :  NULL);
+
+    switch (B.enc) {
+      case ENC_DELTA: {
+        lo = (left == B.card  ?  getVarint(d, pos)  :
+              last + getVarint(d, pos));
+        hi = lo;
+        left--;
+        while (left > 0) {
+          unsigned int p = pos;
+          if (getVarint(d, p) != 1)
+            break;
+          pos = p;
+          hi++;
+          left--;
+        }
+        break;
+      }
+
+      case ENC_RUN: {
+        unsigned int g = getVarint(d, pos);
+        lo = (left == B.card  ?  g  :  last + 1 + g);
+        hi = lo + getVarint(d, pos);
+        left -= hi - lo + 1;
+        break;
+      }
+
+      default: {   //ENC_BITMAP
+        const unsigned long long* w = &set->words[B.off];
+        while (bits == 0)
+          bits = w[++pos];
+        unsigned int k = __builtin_ctzll(bits);
+        unsigned long long r = ~(bits >> k);
+        unsigned int m = (r  ?  __builtin_ctzll(r)  :  64 - k);
+        lo = pos*64 + k;
+        hi = lo + m - 1;
+        bits = (k + m == 64  ?  0  :  bits & ~(((1ULL << m) - 1) << k));
+        while (k + m == 64  &&  pos+1 < NWORDS  &&  (w[pos+1] & 1)) {
+          bits = w[++pos];
+          k = 0;
+          m = (~bits  ?  __builtin_ctzll(~bits)  :  64);
+          hi += m;
+          bits = (m == 64  ?  0  :  bits & ~((1ULL << m) - 1));
+        }
+        left -= hi - lo + 1;
+      }
+    }
+
+    last = hi;
+    a = base + lo;
+    b = base + hi;
+    return true;
+  }
+
+  return false;
+}
+
+
+void DIF_PixelSet::Cursor::begin(const DIF_PixelSet& s,
+                                 unsigned long long rank)
+{
+  set = &s;
+  ib = 0;
+  a = 1;
+  b = 0;
+  while (ib < s.blk.size()  &&  rank >= s.blk[ib].card)
+    rank -= s.blk[ib++].card;
+  openBlock();
+
+  while (rank > 0  &&  fetch()) {
+    unsigned long long len = b - a + 1;
+    if (rank < len) {
+      a += rank;
+      rank = 0;
+    }
+    else {
+      rank -= len;
+      a = b + 1;
+    }
+  }
+}
+
+
+unsigned long long DIF_PixelSet::Cursor::nextRun(long long int& lo,
+                                                 long long int& hi,
+                                                 unsigned long long n)
+{
+  unsigned long long cnt = 0;
+
+  if (n == 0  ||  ! peek(lo))
+    return 0;
+  hi = lo - 1;
+
+  while (cnt < n) {
+    if (a > b  &&  ! fetch())
+      break;
+    if (a != hi + 1)
+      break;
+    unsigned long long take = b - a + 1;
+    if (take > n - cnt)
+      take = n - cnt;
+    hi += take;
+    a += take;
+    cnt += take;
+  }
+
+  return cnt;
+}
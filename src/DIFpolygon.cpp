@@ -0,0 +1,296 @@
+/*
+  Name:  int DIF_Region::makePolygon
+
+  Description:
+   Split the spherical polygon defined by the DIF_Region vertex list
+   (edges are great circle arcs) into convex pieces, used by DIFhtmPolygon,
+   DIFmyHealPPolygon and by the fine search (DIF_Region::inPolygon).
+
+   Vertices are projected on the plane tangent to the sphere at their
+   barycenter (gnomonic projection), where great circles are straight
+   lines. Then:
+    - repeated and collinear vertices are dropped;
+    - self-intersecting polygons are rejected;
+    - a convex polygon is kept as it is, otherwise it is triangulated by
+      ear clipping and adjacent triangles are merged as long as the result
+      is convex (Hertel-Mehlhorn).
+
+  Note:
+   The polygon must be contained in the hemisphere centered on the
+   barycenter of its vertices.
+
+  Return the number of convex pieces, -1 if the polygon is not valid.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <math.h>
+#include <algorithm>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* Minimum cosine of the distance of a vertex from the barycenter */
+static const double MIN_CEN_COS = 1e-3;
+
+/* Relative tolerance for collinear points */
+static const double COLL_EPS = 1e-12;
+
+
+// Orientation of the triangle (a, b, c) in the tangent plane: > 0 if
+// counter-clockwise, 0 if (almost) collinear
+static int orient(const vector<double>& x, const vector<double>& y,
+                  int a, int b, int c)
+{
+  double ux = x[b] - x[a], uy = y[b] - y[a];
+  double vx = x[c] - x[a], vy = y[c] - y[a];
+  double cr = ux*vy - uy*vx;
+  double sc = sqrt((ux*ux + uy*uy) * (vx*vx + vy*vy));
+
+  if (fabs(cr) <= COLL_EPS * sc)
+    return 0;
+  return (cr > 0.)  ?  1  :  -1;
+}
+
+
+// Whether the point c, collinear with a and b, is in the segment a-b
+static bool onSegment(const vector<double>& x, const vector<double>& y,
+                      int a, int b, int c)
+{
+  return (fmin(x[a], x[b]) <= x[c]  &&  x[c] <= fmax(x[a], x[b])  &&
+          fmin(y[a], y[b]) <= y[c]  &&  y[c] <= fmax(y[a], y[b]));
+}
+
+
+// Whether the segments a-b and c-d intersect (touching included)
+static bool segCross(const vector<double>& x, const vector<double>& y,
+                     int a, int b, int c, int d)
+{
+  int o1 = orient(x, y, a, b, c), o2 = orient(x, y, a, b, d);
+  int o3 = orient(x, y, c, d, a), o4 = orient(x, y, c, d, b);
+
+  if (o1 != o2  &&  o3 != o4  &&  o1 && o2 && o3 && o4)
+    return true;
+
+  return ((o1 == 0  &&  onSegment(x, y, a, b, c))  ||
+          (o2 == 0  &&  onSegment(x, y, a, b, d))  ||
+          (o3 == 0  &&  onSegment(x, y, c, d, a))  ||
+          (o4 == 0  &&  onSegment(x, y, c, d, b)));
+}
+
+
+// Whether the (counter-clockwise) polygon is strictly convex
+static bool isConvex(const vector<double>& x, const vector<double>& y,
+                     const vector<int>& pg)
+{
+  int n = pg.size();
+  for (int i=0; i<n; i++)
+    if (orient(x, y, pg[(i+n-1)%n], pg[i], pg[(i+1)%n]) <= 0)
+      return false;
+  return true;
+}
+
+
+int DIF_Region::makePolygon()
+{
+  int i, j, n = pg_ra.size();
+  vector<double> vx, vy, vz;
+  vector<int> idx;   // index of each used vertex in pg_ra, pg_de
+
+  pg_piece.clear();
+
+// Unit vectors, skip repeated vertices
+  for (i=0; i<n; i++) {
+    double r = pg_ra[i]*DEG2RAD, d = pg_de[i]*DEG2RAD;
+    double x = cos(d)*cos(r), y = cos(d)*sin(r), z = sin(d);
+    j = vx.size() - 1;
+    if (j >= 0  &&  x*vx[j] + y*vy[j] + z*vz[j] > 1. - 1e-15)
+      continue;
+    vx.push_back(x);
+    vy.push_back(y);
+    vz.push_back(z);
+    idx.push_back(i);
+  }
+  n = vx.size();
+  if (n > 1  &&  vx[0]*vx[n-1] + vy[0]*vy[n-1] + vz[0]*vz[n-1] > 1. - 1e-15)
+    n--;   // closing vertex
+  if (n < 3)
+    return -1;
+
+// Barycenter
+  double cx = 0., cy = 0., cz = 0.;
+  for (i=0; i<n; i++) {
+    cx += vx[i];
+    cy += vy[i];
+    cz += vz[i];
+  }
+  double cn = sqrt(cx*cx + cy*cy + cz*cz);
+  if (cn < 1e-12)
+    return -1;
+  cx /= cn;  cy /= cn;  cz /= cn;
+
+// Tangent plane basis: e1 (east), e2 (north)
+  double e1x = -cy, e1y = cx, e1z = 0.;
+  double en = sqrt(e1x*e1x + e1y*e1y);
+  if (en < 1e-12) {
+    e1x = 1.;  e1y = 0.;
+  } else {
+    e1x /= en;  e1y /= en;
+  }
+  double e2x = cy*e1z - cz*e1y;
+  double e2y = cz*e1x - cx*e1z;
+  double e2z = cx*e1y - cy*e1x;
+
+// Gnomonic projection
+  vector<double> px(n), py(n);
+  for (i=0; i<n; i++) {
+    double w = vx[i]*cx + vy[i]*cy + vz[i]*cz;
+    if (w < MIN_CEN_COS)
+      return -1;
+    px[i] = (vx[i]*e1x + vy[i]*e1y + vz[i]*e1z) / w;
+    py[i] = (vx[i]*e2x + vy[i]*e2y + vz[i]*e2z) / w;
+  }
+
+// Drop collinear vertices
+  vector<int> pg;
+  for (i=0; i<n; i++)
+    pg.push_back(i);
+
+  bool again = true;
+  while (again  &&  pg.size() >= 3) {
+    again = false;
+    int m = pg.size();
+    for (i=0; i<m; i++)
+      if (orient(px, py, pg[(i+m-1)%m], pg[i], pg[(i+1)%m]) == 0) {
+        pg.erase(pg.begin() + i);
+        again = true;
+        break;
+      }
+  }
+  if (pg.size() < 3)
+    return -1;
+
+// Reject self-intersecting polygons
+  int m = pg.size();
+  for (i=0; i<m; i++)
+    for (j=i+2; j<m; j++) {
+      if (i == 0  &&  j == m-1)
+        continue;   // adjacent edges
+      if (segCross(px, py, pg[i], pg[(i+1)%m], pg[j], pg[(j+1)%m]))
+        return -1;
+    }
+
+// Counter-clockwise order
+  double area = 0.;
+  for (i=0; i<m; i++) {
+    int a = pg[i], b = pg[(i+1)%m];
+    area += px[a]*py[b] - px[b]*py[a];
+  }
+  if (area < 0.)
+    reverse(pg.begin(), pg.end());
+
+  vector<vector<int> > pcs;
+
+  if (isConvex(px, py, pg))
+    pcs.push_back(pg);
+
+  else {
+// Ear clipping
+    vector<int> rem(pg);
+    while (rem.size() > 3) {
+      int r = rem.size();
+      bool found = false;
+      for (i=0; i<r  &&  ! found; i++) {
+        int a = rem[(i+r-1)%r], b = rem[i], c = rem[(i+1)%r];
+        if (orient(px, py, a, b, c) <= 0)
+          continue;
+
+        bool ear = true;
+        for (j=0; j<r  &&  ear; j++) {
+          int q = rem[j];
+          if (q == a  ||  q == b  ||  q == c)
+            continue;
+          if (orient(px, py, a, b, q) >= 0  &&
+              orient(px, py, b, c, q) >= 0  &&
+              orient(px, py, c, a, q) >= 0)
+            ear = false;
+        }
+        if (! ear)
+          continue;
+
+        vector<int> t(3);
+        t[0] = a;  t[1] = b;  t[2] = c;
+        pcs.push_back(t);
+        rem.erase(rem.begin() + i);
+        found = true;
+      }
+      if (! found)
+        return -1;
+    }
+    pcs.push_back(rem);
+
+// Merge pieces sharing an edge while the result is convex
+    again = true;
+    while (again) {
+      again = false;
+      for (unsigned int p1=0; p1<pcs.size()  &&  ! again; p1++)
+        for (unsigned int p2=p1+1; p2<pcs.size()  &&  ! again; p2++) {
+          vector<int>& P = pcs[p1];
+          vector<int>& Q = pcs[p2];
+          int np = P.size(), nq = Q.size();
+          for (i=0; i<np  &&  ! again; i++)
+            for (j=0; j<nq  &&  ! again; j++) {
+              // edge a->b in P, b->a in Q
+              if (P[i] != Q[(j+1)%nq]  ||  P[(i+1)%np] != Q[j])
+                continue;
+              vector<int> mg;
+              for (int k=1; k<=np; k++)
+                mg.push_back(P[(i+k)%np]);       // b ... a
+              for (int k=2; k<nq; k++)
+                mg.push_back(Q[(j+k)%nq]);       // after a, before b
+              if (isConvex(px, py, mg)) {
+                pcs[p1] = mg;
+                pcs.erase(pcs.begin() + p2);
+                again = true;
+              }
+            }
+        }
+    }
+  }
+
+// Pieces: vertex indexes and inward edge normals
+  for (unsigned int k=0; k<pcs.size(); k++) {
+    DIF_PolyPiece pp;
+    int np = pcs[k].size();
+    double gx = 0., gy = 0., gz = 0.;
+
+    for (i=0; i<np; i++) {
+      int a = pcs[k][i];
+      pp.vtx.push_back(idx[a]);
+      gx += vx[a];  gy += vy[a];  gz += vz[a];
+    }
+
+    for (i=0; i<np; i++) {
+      int a = pcs[k][i], b = pcs[k][(i+1)%np];
+      double nx = vy[a]*vz[b] - vz[a]*vy[b];
+      double ny = vz[a]*vx[b] - vx[a]*vz[b];
+      double nz = vx[a]*vy[b] - vy[a]*vx[b];
+      double nn = sqrt(nx*nx + ny*ny + nz*nz);
+      if (nx*gx + ny*gy + nz*gz < 0.)
+        nn = -nn;
+      pp.nrm.push_back(nx/nn);
+      pp.nrm.push_back(ny/nn);
+      pp.nrm.push_back(nz/nn);
+    }
+    pg_piece.push_back(pp);
+  }
+
+  return pg_piece.size();
+}
@@ -0,0 +1,231 @@
+/*
+  Name:  DIF_planPrepare, DIF_planRelease, DIF_Region::usePlan,
+         DIF_Region::go_prepared, DIF_Region::keep_prepared
+
+  Description:
+   Prepared regions (DIF_Prepare, DIF_UsePrepared, DIF_Unprepare), kept by
+   the server for all the connections.
+   A prepared region is a region expression (see DIFexpr.cpp) or a MOC
+   (ASCII or binary, see DIFmoc.cpp), registered once with a handle. Its
+   pixels are computed by the first search at each schema and set of
+   depths/orders, then stored (as DIF_PixelSet) with the region: the next
+   searches with the same schema and params, by any connection, copy them
+   instead of computing them again.
+   A region defined by usePlan is a copy of the prepared one (the
+   expression is parsed again, DIF_FineSearch then works as for
+   DIF_RegionExpr and DIF_MOC): only the pixel lists are shared.
+   The registry is protected by a mutex, the pixels are computed without
+   holding it: two connections may then compute the same pixels, the
+   first one stored is kept.
+
+  Note:
+   Handles are never reused. A region released while in use by a search
+   is computed by it as a region not prepared.
+
+  Return (DIF_planPrepare) the handle (> 0), -1 if the region is not
+  valid, -2 if DIF_PLAN_MAX regions are prepared.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <algorithm>
+#include <map>
+#include <pthread.h>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* Pixels of a prepared region at a schema and (sorted) params */
+struct DIF_PlanPixels {
+  enum DIF_Schema schema;
+  vector<int> params;
+  vector<DIF_PixelSet> fset, pset;
+};
+
+/* Prepared region */
+struct DIF_Plan {
+  string spec;
+  vector<DIF_PlanPixels> pix;
+};
+
+
+static pthread_mutex_t plan_mutex = PTHREAD_MUTEX_INITIALIZER;
+static map<long long int, DIF_Plan> plans;
+static long long int plan_last = 0;
+
+
+// Define the region from the expression or MOC: the number of regions of
+// the expression or of MOC ranges, -1 if not valid
+static int planDefine(DIF_Region& r, const string& spec)
+{
+  int n = r.setExpr(spec.data(), spec.size());
+
+  if (n > 0) {
+    r.regtype = DIF_REG_EXPR;
+    return n;
+  }
+
+  r.clear_moc();
+  if (n == -1  &&  (n = r.setMOC(spec.data(), spec.size())) >= 0) {
+    r.regtype = DIF_REG_MOC;
+    return n;
+  }
+
+  return -1;
+}
+
+
+// Pixels of the plan at schema and params, NULL if not computed yet
+static DIF_PlanPixels* planPixels(DIF_Plan& pl, enum DIF_Schema schema,
+                                  const vector<int>& params)
+{
+  for (unsigned int i=0; i<pl.pix.size(); i++)
+    if (pl.pix[i].schema == schema  &&  pl.pix[i].params == params)
+      return &pl.pix[i];
+  return NULL;
+}
+
+
+
+long long int DIF_planPrepare(const char* spec, unsigned long len)
+{
+  DIF_Region r;
+  string s(spec, len);
+  long long int h = -2;
+  map<long long int, DIF_Plan>::iterator it;
+
+  if (planDefine(r, s) < 0)
+    return -1;
+
+  pthread_mutex_lock(&plan_mutex);
+  for (it=plans.begin(); it!=plans.end(); it++)
+    if (it->second.spec == s)
+      break;
+
+  if (it != plans.end())
+    h = it->first;
+  else if (plans.size() < DIF_PLAN_MAX) {
+    h = ++plan_last;
+    plans[h].spec = s;
+  }
+  pthread_mutex_unlock(&plan_mutex);
+
+  return h;
+}
+
+
+int DIF_planRelease(long long int handle)
+{
+  pthread_mutex_lock(&plan_mutex);
+  int ret = plans.erase(handle);
+  pthread_mutex_unlock(&plan_mutex);
+
+  return ret;
+}
+
+
+
+int DIF_Region::usePlan(long long int handle)
+{
+  string spec;
+  int n = -1;
+
+  pl_handle = 0;
+  if (handle == 0)
+    return 0;
+
+  pthread_mutex_lock(&plan_mutex);
+  map<long long int, DIF_Plan>::iterator it = plans.find(handle);
+  if (it != plans.end()) {
+    spec = it->second.spec;
+    n = 0;
+  }
+  pthread_mutex_unlock(&plan_mutex);
+
+  if (n == 0  &&  (n = planDefine(*this, spec)) >= 0)
+    pl_handle = handle;
+
+  return n;
+}
+
+
+// Copy the stored pixels of the prepared region into the lists (the large
+// ones are kept compressed): return false if they are not stored yet
+bool DIF_Region::go_prepared()
+{
+  vector<DIF_PixelSet> fs, ps;
+  unsigned int i;
+
+  pthread_mutex_lock(&plan_mutex);
+  map<long long int, DIF_Plan>::iterator it = plans.find(pl_handle);
+  DIF_PlanPixels* px = (it != plans.end()  ?
+                        planPixels(it->second, schema, params)  :  NULL);
+  if (px) {
+    fs = px->fset;
+    ps = px->pset;
+  }
+  pthread_mutex_unlock(&plan_mutex);
+
+  if (! px)
+    return false;
+
+  for (i=0; i<params.size(); i++) {
+    pflist.push_back(newList());
+    pplist.push_back(newList());
+    if (fs[i].size() < DIF_COMPACT_MIN) {
+      fs[i].toVector(*pflist[i]);
+      fs[i].clear();
+    }
+    if (ps[i].size() < DIF_COMPACT_MIN) {
+      ps[i].toVector(*pplist[i]);
+      ps[i].clear();
+    }
+  }
+  pfset.swap(fs);
+  ppset.swap(ps);
+
+  return true;
+}
+
+
+// Store the pixels computed by go() with the prepared region, unless
+// already stored by another search
+void DIF_Region::keep_prepared()
+{
+  DIF_PlanPixels px;
+  vector<long long int> l;
+  unsigned int i;
+
+  px.schema = schema;
+  px.params = params;
+  px.fset.resize(params.size());
+  px.pset.resize(params.size());
+  for (i=0; i<params.size(); i++) {
+    l = *pflist[i];
+    sort(l.begin(), l.end());
+    l.erase(unique(l.begin(), l.end()), l.end());
+    px.fset[i].assign(l);
+
+    l = *pplist[i];
+    sort(l.begin(), l.end());
+    l.erase(unique(l.begin(), l.end()), l.end());
+    px.pset[i].assign(l);
+  }
+
+  pthread_mutex_lock(&plan_mutex);
+  map<long long int, DIF_Plan>::iterator it = plans.find(pl_handle);
+  if (it != plans.end()  &&  ! planPixels(it->second, schema, params)) {
+    it->second.pix.push_back(DIF_PlanPixels());
+    DIF_PlanPixels& p = it->second.pix.back();
+    p.schema = px.schema;
+    p.params.swap(px.params);
+    p.fset.swap(px.fset);
+    p.pset.swap(px.pset);
+  }
+  pthread_mutex_unlock(&plan_mutex);
+}
@@ -0,0 +1,214 @@
+/*
+  Name:  DIF_setUnion, DIF_setIntersection, DIF_setDifference,
+         DIF_setDropCovered, DIF_setParents, DIF_setChildren,
+         DIF_rangeUnion, DIF_rangeIntersection, DIF_rangeDifference,
+         DIF_Region::dropCovered
+
+  Description:
+   Set algebra on pixel ID lists sorted in ascending order, without
+   duplicates. The merge loops advance both lists without branches on the
+   comparison results, the output is sized once to its maximum length and
+   then cut.
+   Across depths/orders (HTM and HEALPix NESTED): the ancestor of an ID at
+   a level lower by l is ID >> 2l (shift = 2l), its descendants are the
+   range [ID << 2l, (ID+1) << 2l).
+    - DIF_setDropCovered: IDs of a whose ancestor is not in b;
+    - DIF_setParents:     ancestors of the IDs of a;
+    - DIF_setChildren:    descendants of the IDs of a;
+    - DIF_range*: the same set operations on sets of ID ranges
+      (DIF_Ranges), sweeping the ranges bounds of both sets in order;
+    - DIF_Region::dropCovered: removes from the lists of each param the IDs
+      covered by a full pixel of a lower param, as when the full and
+      partial pixels of several regions (DIF_Cones, polygon pieces) are
+      merged; nothing is done in the HEALPix RING scheme.
+
+  Note:
+   The output list must be different from the input ones.
+   Ancestors and descendants are those of the NESTED scheme, they are not
+   defined for RING IDs.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <limits.h>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+void DIF_setUnion(const vector<long long int>& a,
+                  const vector<long long int>& b, vector<long long int>& out)
+{
+  unsigned long i = 0, j = 0, k = 0, na = a.size(), nb = b.size();
+
+  out.resize(na + nb);
+  while (i < na  &&  j < nb) {
+    long long int x = a[i], y = b[j];
+    out[k++] = (x < y  ?  x  :  y);
+    i += (x <= y);
+    j += (y <= x);
+  }
+  while (i < na) out[k++] = a[i++];
+  while (j < nb) out[k++] = b[j++];
+  out.resize(k);
+}
+
+
+void DIF_setIntersection(const vector<long long int>& a,
+                         const vector<long long int>& b,
+                         vector<long long int>& out)
+{
+  unsigned long i = 0, j = 0, k = 0, na = a.size(), nb = b.size();
+
+  out.resize(na < nb  ?  na  :  nb);
+  while (i < na  &&  j < nb) {
+    long long int x = a[i], y = b[j];
+    out[k] = x;
+    k += (x == y);
+    i += (x <= y);
+    j += (y <= x);
+  }
+  out.resize(k);
+}
+
+
+void DIF_setDifference(const vector<long long int>& a,
+                       const vector<long long int>& b,
+                       vector<long long int>& out)
+{
+  unsigned long i = 0, j = 0, k = 0, na = a.size(), nb = b.size();
+
+  out.resize(na);
+  while (i < na  &&  j < nb) {
+    long long int x = a[i], y = b[j];
+    out[k] = x;
+    k += (x < y);
+    i += (x <= y);
+    j += (y <= x);
+  }
+  while (i < na) out[k++] = a[i++];
+  out.resize(k);
+}
+
+
+void DIF_setDropCovered(const vector<long long int>& a,
+                        const vector<long long int>& b, int shift,
+                        vector<long long int>& out)
+{
+  unsigned long i, j = 0, k = 0, na = a.size(), nb = b.size();
+
+  out.resize(na);
+  for (i=0; i<na; i++) {
+    long long int x = a[i], p = x >> shift;
+    while (j < nb  &&  b[j] < p)
+      j++;
+    out[k] = x;
+    k += (j == nb  ||  b[j] != p);
+  }
+  out.resize(k);
+}
+
+
+void DIF_setParents(const vector<long long int>& a, int shift,
+                    vector<long long int>& out)
+{
+  unsigned long i, k = 0, na = a.size();
+
+  out.resize(na);
+  for (i=0; i<na; i++) {
+    long long int p = a[i] >> shift;
+    out[k] = p;
+    k += (k == 0  ||  out[k-1] != p);
+  }
+  out.resize(k);
+}
+
+
+void DIF_setChildren(const vector<long long int>& a, int shift,
+                     vector<long long int>& out)
+{
+  unsigned long i, k = 0, na = a.size();
+
+  out.resize(na << shift);
+  for (i=0; i<na; i++)
+    for (long long int c = a[i] << shift; c < ((a[i]+1) << shift); c++)
+      out[k++] = c;
+}
+
+
+// op: 0 union, 1 intersection, 2 difference
+static void rangeCombine(const DIF_Ranges& a, const DIF_Ranges& b, int op,
+                         DIF_Ranges& out)
+{
+  unsigned long i = 0, j = 0, na = a.size(), nb = b.size();
+  bool ina = false, inb = false, in = false;
+
+  out.clear();
+  out.lo.reserve(na + nb);
+  out.hi.reserve(na + nb);
+
+  while (i < na  ||  j < nb) {
+    long long int xa = (i < na  ?  (ina ? a.hi[i] : a.lo[i])  :  LLONG_MAX);
+    long long int xb = (j < nb  ?  (inb ? b.hi[j] : b.lo[j])  :  LLONG_MAX);
+    long long int x = (xa < xb  ?  xa  :  xb);
+
+    if (xa == x) {
+      i += ina;
+      ina = ! ina;
+    }
+    if (xb == x) {
+      j += inb;
+      inb = ! inb;
+    }
+
+    bool now = (op == 0  ?  (ina || inb)  :
+                (op == 1  ?  (ina && inb)  :  (ina && ! inb)));
+    if (now != in) {
+      (now  ?  out.lo  :  out.hi).push_back(x);
+      in = now;
+    }
+  }
+}
+
+
+void DIF_rangeUnion(const DIF_Ranges& a, const DIF_Ranges& b,
+                    DIF_Ranges& out)
+{ rangeCombine(a, b, 0, out); }
+
+
+void DIF_rangeIntersection(const DIF_Ranges& a, const DIF_Ranges& b,
+                           DIF_Ranges& out)
+{ rangeCombine(a, b, 1, out); }
+
+
+void DIF_rangeDifference(const DIF_Ranges& a, const DIF_Ranges& b,
+                         DIF_Ranges& out)
+{ rangeCombine(a, b, 2, out); }
+
+
+
+void DIF_Region::dropCovered()
+{
+  vector<long long int> tmp;
+  unsigned int i, j;
+
+  if (schema == DIF_HEALP_RING)
+    return;
+
+  for (i=0; i<params.size(); i++) {
+    vector<long long int>& cover = *pflist[i];
+    if (cover.size() == 0)
+      continue;
+
+    for (j=i+1; j<params.size(); j++) {
+      int shift = 2*(params[j] - params[i]);
+      DIF_setDropCovered(*pflist[j], cover, shift, tmp);
+      pflist[j]->swap(tmp);
+      DIF_setDropCovered(*pplist[j], cover, shift, tmp);
+      pplist[j]->swap(tmp);
+    }
+  }
+}
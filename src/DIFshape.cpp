@@ -0,0 +1,330 @@
+/*
+  Name:  DIF_Region::makeShape, DIF_Region::inShape, DIF_Region::classifyShape
+
+  Description:
+   Geometry of the annulus, ellipse and great circle strip regions, used by
+   DIFhtmShape, DIFmyHealPShape and by the fine search.
+
+   Annulus and strip are exactly convexes of two spherical caps n.v >= d:
+    - annulus: c.v >= cos(Rout) and -c.v >= -cos(Rin), c the center;
+    - strip:  |n.v| <= sin(W), n the pole of the great circle through the
+      two given points and W the half width.
+   The ellipse is defined in the gnomonic projection centered on (ra1, de1),
+   with semi-axes tan(rad) and tan(rad2) and the major axis at position
+   angle pa (east of north). It is bracketed by the inscribed (sh_in) and
+   circumscribed (sh_out) 36-sided polygons.
+   The longitude/latitude box in the Galactic or Ecliptic frame is the
+   convex of two latitude caps around the frame pole and two half-spaces
+   bounded by the meridians, with normals rotated to equatorial.
+   Circles and RA/Dec rectangles (as equatorial boxes) are set up as well
+   for the streamed decomposition (see DIFstream.cpp).
+
+  Note:
+   The ellipse semi-major axis must be < 90 deg, the strip half width
+   < 90 deg, the box longitude range <= 180 deg (or all the 360 deg).
+
+  Return (makeShape) the number of caps of sh_out, -1 if the region
+  parameters are not valid.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <math.h>
+#include <vector>
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* Number of sides of the polygons bracketing an ellipse */
+static const int ELL_NSIDES = 36;
+
+
+static void unitVec(double ra, double de, double* v)
+{
+  double r = ra*DEG2RAD, d = de*DEG2RAD;
+  v[0] = cos(d)*cos(r);
+  v[1] = cos(d)*sin(r);
+  v[2] = sin(d);
+}
+
+
+static void addCap(DIF_Convex& cvx, double x, double y, double z, double d)
+{
+  cvx.nrm.push_back(x);
+  cvx.nrm.push_back(y);
+  cvx.nrm.push_back(z);
+  cvx.d.push_back(d);
+}
+
+
+// Convex polygon inscribed in (or circumscribed to) the ellipse
+static void addEllPolygon(DIF_Convex& cvx, const double* c, const double* u,
+                          const double* w, double A, double B, bool outer)
+{
+  double v[ELL_NSIDES][3];
+  int i, k;
+
+  for (i=0; i<ELL_NSIDES; i++) {
+    double t = 2.*M_PI*i/ELL_NSIDES, f = 1.;
+    if (outer) {   // tangents intersection
+      t += M_PI/ELL_NSIDES;
+      f = 1./cos(M_PI/ELL_NSIDES);
+    }
+    double X = f*A*cos(t), Y = f*B*sin(t);
+    double n = 0.;
+    for (k=0; k<3; k++) {
+      v[i][k] = c[k] + X*u[k] + Y*w[k];
+      n += v[i][k]*v[i][k];
+    }
+    n = sqrt(n);
+    for (k=0; k<3; k++)
+      v[i][k] /= n;
+  }
+
+// Inward edge normals
+  for (i=0; i<ELL_NSIDES; i++) {
+    double* a = v[i];
+    double* b = v[(i+1) % ELL_NSIDES];
+    double nx = a[1]*b[2] - a[2]*b[1];
+    double ny = a[2]*b[0] - a[0]*b[2];
+    double nz = a[0]*b[1] - a[1]*b[0];
+    double nn = sqrt(nx*nx + ny*ny + nz*nz);
+    if (nx*c[0] + ny*c[1] + nz*c[2] < 0.)
+      nn = -nn;
+    addCap(cvx, nx/nn, ny/nn, nz/nn, 0.);
+  }
+}
+
+
+int DIF_Region::makeShape()
+{
+  double c[3], v[3];
+  int k;
+
+  clear_shape();
+
+  switch (regtype) {
+    case DIF_REG_CIRCLE: {
+      double r = rad/60.*DEG2RAD;
+      if (! (0. < r  &&  r <= M_PI))
+        return -1;
+      unitVec(ra1, de1, c);
+      addCap(sh_in, c[0], c[1], c[2], cos(r));
+      break;
+    }
+
+    case DIF_REG_ANNULUS: {
+      double rin = rad2/60.*DEG2RAD, rout = rad/60.*DEG2RAD;
+      if (! (0. <= rin  &&  rin < rout  &&  rout <= M_PI))
+        return -1;
+      unitVec(ra1, de1, c);
+      addCap(sh_in, c[0], c[1], c[2], cos(rout));
+      if (rin > 0.)
+        addCap(sh_in, -c[0], -c[1], -c[2], -cos(rin));
+      break;
+    }
+
+    case DIF_REG_STRIP: {
+      double hw = rad/60.*DEG2RAD;
+      if (! (0. < hw  &&  hw < M_PI/2.))
+        return -1;
+      unitVec(ra1, de1, c);
+      unitVec(ra2, de2, v);
+      double nx = c[1]*v[2] - c[2]*v[1];
+      double ny = c[2]*v[0] - c[0]*v[2];
+      double nz = c[0]*v[1] - c[1]*v[0];
+      double nn = sqrt(nx*nx + ny*ny + nz*nz);
+      if (nn < 1e-12)   // coincident or antipodal points
+        return -1;
+      nx /= nn;  ny /= nn;  nz /= nn;
+      addCap(sh_in,  nx,  ny,  nz, -sin(hw));
+      addCap(sh_in, -nx, -ny, -nz, -sin(hw));
+      break;
+    }
+
+    case DIF_REG_ELLIPSE: {
+      double a = rad/60.*DEG2RAD, b = rad2/60.*DEG2RAD;
+      if (! (0. < b  &&  b <= a  &&  a < M_PI/2.))
+        return -1;
+      unitVec(ra1, de1, el_c);
+
+// East and north at the center
+      double e[3] = {-el_c[1], el_c[0], 0.};
+      double en = sqrt(e[0]*e[0] + e[1]*e[1]);
+      if (en < 1e-12) {   // pole
+        e[0] = 0.;  e[1] = 1.;
+      } else {
+        e[0] /= en;  e[1] /= en;
+      }
+      double n[3] = {el_c[1]*e[2] - el_c[2]*e[1],
+                     el_c[2]*e[0] - el_c[0]*e[2],
+                     el_c[0]*e[1] - el_c[1]*e[0]};
+
+      double cp = cos(pa*DEG2RAD), sp = sin(pa*DEG2RAD);
+      for (k=0; k<3; k++) {
+        el_u[k] =  cp*n[k] + sp*e[k];
+        el_w[k] = -sp*n[k] + cp*e[k];
+      }
+      el_A = tan(a);
+      el_B = tan(b);
+      el_a = a;
+
+      addEllPolygon(sh_in,  el_c, el_u, el_w, el_A, el_B, false);
+      addEllPolygon(sh_out, el_c, el_u, el_w, el_A, el_B, true);
+      return sh_out.d.size();
+    }
+
+    case DIF_REG_4VERT:
+    case DIF_REG_LONLAT: {
+      double dl = fmod(ra3 - ra1 + 720., 360.);
+      if (! (-90. <= de1  &&  de1 < de2  &&  de2 <= 90.))
+        return -1;
+      if (dl > 180.  &&  dl < 359.99)
+        return -1;
+
+      double p[3] = {0., 0., 1.};
+      DIF_frameRotate(frame, p, c);
+      addCap(sh_in,  c[0],  c[1],  c[2],  sin(de1*DEG2RAD));
+      addCap(sh_in, -c[0], -c[1], -c[2], -sin(de2*DEG2RAD));
+
+// Meridians, unless the box is a whole latitude band
+      if (dl > 0.  &&  dl <= 180.) {
+        double l1 = ra1*DEG2RAD, l2 = ra3*DEG2RAD;
+        double m1[3] = {-sin(l1),  cos(l1), 0.};
+        double m2[3] = { sin(l2), -cos(l2), 0.};
+        DIF_frameRotate(frame, m1, v);
+        addCap(sh_in, v[0], v[1], v[2], 0.);
+        DIF_frameRotate(frame, m2, v);
+        addCap(sh_in, v[0], v[1], v[2], 0.);
+      }
+      break;
+    }
+
+    default:
+      return -1;
+  }
+
+  sh_out = sh_in;
+  return sh_out.d.size();
+}
+
+
+
+bool DIF_Region::inShape(double ra, double de)
+{
+  double v[3];
+  unitVec(ra, de, v);
+
+  if (regtype == DIF_REG_ELLIPSE) {
+    double cz = v[0]*el_c[0] + v[1]*el_c[1] + v[2]*el_c[2];
+    if (cz <= 0.)
+      return false;
+    double X = (v[0]*el_u[0] + v[1]*el_u[1] + v[2]*el_u[2]) / (cz*el_A);
+    double Y = (v[0]*el_w[0] + v[1]*el_w[1] + v[2]*el_w[2]) / (cz*el_B);
+    return (X*X + Y*Y <= 1.);
+  }
+
+  for (unsigned int i=0; i<sh_in.d.size(); i++)
+    if (sh_in.nrm[3*i]*v[0] + sh_in.nrm[3*i+1]*v[1] +
+        sh_in.nrm[3*i+2]*v[2] < sh_in.d[i])
+      return false;
+  return true;
+}
+
+
+
+// Distance of the point (x, y) from the border of the ellipse with semi-axes
+// A >= B along the axes, from the closest point (D. Eberly, "Distance from
+// a point to an ellipse", bisection for the root of its Lagrange equation)
+static double ellipseDist(double A, double B, double x, double y)
+{
+  x = fabs(x);
+  y = fabs(y);
+
+  if (y == 0.) {
+    double num = A*x, den = A*A - B*B;
+    if (num < den) {
+      double q = num / den;
+      return hypot(A*q - x, B*sqrt(1. - q*q));
+    }
+    return fabs(x - A);
+  }
+  if (x == 0.)
+    return fabs(B - y);
+
+  double z0 = x/A, z1 = y/B, g = z0*z0 + z1*z1 - 1.;
+  if (g == 0.)
+    return 0.;
+
+  double r0 = (A/B)*(A/B), n0 = r0*z0;
+  double s0 = z1 - 1., s1 = (g < 0.  ?  0.  :  hypot(n0, z1) - 1.), t = 0.;
+  for (int i=0; i<1100; i++) {
+    t = (s0 + s1) / 2.;
+    if (t == s0  ||  t == s1)
+      break;
+    double p0 = n0/(t + r0), p1 = z1/(t + 1.);
+    g = p0*p0 + p1*p1 - 1.;
+    if (g > 0.)
+      s0 = t;
+    else if (g < 0.)
+      s1 = t;
+    else
+      break;
+  }
+
+  return hypot(r0*x/(t + r0) - x, y/(t + 1.) - y);
+}
+
+
+int DIF_Region::classifyShape(double x, double y, double z, double r)
+{
+  if (regtype == DIF_REG_ELLIPSE) {
+    double cz = x*el_c[0] + y*el_c[1] + z*el_c[2];
+    if (cz > 1.) cz = 1.;
+    double rho = acos(cz);
+
+    if (rho - r > el_a)
+      return -1;
+    if (rho + r >= M_PI/2.)
+      return 0;
+
+// Bound of the disc radius in the gnomonic plane
+    double cm = cos(rho + r);
+    double s = tan(r) / (cm*cm);
+
+    double X = (x*el_u[0] + y*el_u[1] + z*el_u[2]) / cz;
+    double Y = (x*el_w[0] + y*el_w[1] + z*el_w[2]) / cz;
+
+// Inside the ellipse at a distance of at least s from its border
+    double qx = X/el_A, qy = Y/el_B;
+    if (qx*qx + qy*qy <= 1.  &&  ellipseDist(el_A, el_B, X, Y) >= s)
+      return 1;
+
+// Ellipse scaled by (1 + s/B) contains all the discs touching the ellipse
+    double f = 1. + s/el_B;
+    qx /= f;
+    qy /= f;
+    if (qx*qx + qy*qy > 1.)
+      return -1;
+    return 0;
+  }
+
+  int ret = 1;
+  for (unsigned int i=0; i<sh_in.d.size(); i++) {
+    double t = sh_in.nrm[3*i]*x + sh_in.nrm[3*i+1]*y + sh_in.nrm[3*i+2]*z;
+    if (t > 1.) t = 1.;
+    if (t < -1.) t = -1.;
+    double theta = acos(t), R = acos(sh_in.d[i]);
+    if (theta > R + r)
+      return -1;
+    if (theta > R - r)
+      ret = 0;
+  }
+  return ret;
+}
@@ -0,0 +1,224 @@
+/*
+  Name:  DIF_Region::streamable, DIF_Region::stream_reset,
+         DIF_Region::stream_next
+
+  Description:
+   Streamed decomposition of circles, rectangles, annuli, ellipses, strips
+   and longitude/latitude boxes: the pixels are computed while reading
+   DIF.dif, one at a time, instead of being stored in the full and partial
+   lists by go(). The first pixel is returned after a few classifications
+   and the memory used does not depend on the region size.
+   The pixel hierarchy (HTM trixels from the 8 base ones, HEALPix NESTED
+   pixels from the 12 base ones) is descended depth first with an explicit
+   stack: the disc around the pixel center containing the pixel is
+   classified against the region (see classifyShape), a pixel inside it is
+   full, outside it is skipped, otherwise its 4 children are checked up to
+   the highest depth (HTM) or the order (HEALPix), where it is partial.
+   HTM full trixels are returned at the lowest available depth not lower
+   than theirs, HEALPix full pixels at the (lowest available) order: the
+   IDs of their descendants are a contiguous range, read one at a time.
+   RING IDs are converted from the NESTED ones.
+
+  Note:
+   As in DIFmyHealPShape, returned partial pixels could be > real ones,
+   full pixels could be < real ones; pixels are not sorted by ID and full
+   and partial ones are mixed. Regions read by DIF.difm or DIF.difr, or in
+   chunks (see DIF_Chunk), still use the lists.
+
+  Return (streamable) 1 if the region can be streamed, 0 otherwise;
+  (stream_next) 0 on success, 1 on final EOF.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include <math.h>
+
+#include "arr.h"
+#include "geom_utils.h"
+#include "healpix_base.h"
+
+using namespace std;
+
+#include "dif.hh"
+
+
+/* Maximum HTM depth and HEALPix order */
+static const int HTM_MAX_DEPTH = 25;
+static const int HP_MAX_ORDER = 29;
+
+
+// HTM base trixels vertices: S0..S3 (IDs 8..11), N0..N3 (IDs 12..15)
+static const double htm_v[6][3] = {
+  {0., 0., 1.}, {1., 0., 0.}, {0., 1., 0.},
+  {-1., 0., 0.}, {0., -1., 0.}, {0., 0., -1.}
+};
+static const int htm_base[8][3] = {
+  {1, 5, 2}, {2, 5, 3}, {3, 5, 4}, {4, 5, 1},
+  {1, 0, 4}, {4, 0, 3}, {3, 0, 2}, {2, 0, 1}
+};
+
+
+static void midPoint(const double* a, const double* b, double* m)
+{
+  double x = a[0] + b[0], y = a[1] + b[1], z = a[2] + b[2];
+  double n = sqrt(x*x + y*y + z*z);
+  m[0] = x/n;  m[1] = y/n;  m[2] = z/n;
+}
+
+
+int DIF_Region::streamable()
+{
+  if (chunk_n > 1)
+    return 0;
+
+  int maxlev = (schema == DIF_HTM  ?  HTM_MAX_DEPTH  :  HP_MAX_ORDER);
+  if (params[0] < 0  ||  params.back() > maxlev)
+    return 0;
+
+  switch (regtype) {
+    case DIF_REG_CIRCLE:
+    case DIF_REG_4VERT:
+      return (makeShape() >= 0);
+
+    case DIF_REG_ANNULUS:
+    case DIF_REG_ELLIPSE:
+    case DIF_REG_STRIP:
+    case DIF_REG_LONLAT:
+      return 1;
+
+    default:
+      return 0;
+  }
+}
+
+
+void DIF_Region::stream_reset()
+{
+  int i, j;
+
+  st_stack.clear();
+  st_lo = st_hi = 0;
+
+  if (schema == DIF_HTM) {
+    for (i=7; i>=0; i--) {
+      DIF_StreamNode n;
+      n.id = 8 + i;
+      n.level = 0;
+      for (j=0; j<3; j++) {
+        const double* v = htm_v[htm_base[i][j]];
+        n.v[3*j] = v[0];  n.v[3*j+1] = v[1];  n.v[3*j+2] = v[2];
+      }
+      st_stack.push_back(n);
+    }
+  }
+  else
+    for (i=11; i>=0; i--) {
+      DIF_StreamNode n;
+      n.id = i;
+      n.level = 0;
+      st_stack.push_back(n);
+    }
+}
+
+
+int DIF_Region::stream_next(int& param, long long int& val, int& full)
+{
+  int nested = (schema != DIF_HEALP_RING);
+  int i, j;
+
+  while (true) {
+
+// Pending descendants of a full pixel
+    if (st_lo < st_hi) {
+      param = st_param;
+      val = st_lo++;
+      full = 1;
+      if (! nested)
+        val = getHealPBase(1, param)->nest2ring(val);
+      return 0;
+    }
+
+    if (st_stack.size() == 0)
+      return 1;
+
+    DIF_StreamNode n = st_stack.back();
+    st_stack.pop_back();
+
+// Center and radius of the disc containing the pixel
+    double c[3], r;
+    if (schema == DIF_HTM) {
+      double x = n.v[0] + n.v[3] + n.v[6];
+      double y = n.v[1] + n.v[4] + n.v[7];
+      double z = n.v[2] + n.v[5] + n.v[8];
+      double nn = sqrt(x*x + y*y + z*z);
+      c[0] = x/nn;  c[1] = y/nn;  c[2] = z/nn;
+      double cmin = 1.;
+      for (j=0; j<3; j++) {
+        double t = c[0]*n.v[3*j] + c[1]*n.v[3*j+1] + c[2]*n.v[3*j+2];
+        if (t < cmin) cmin = t;
+      }
+      r = acos(cmin) + 1e-12;
+    }
+    else {
+      const T_Healpix_Base<int64>* base = getHealPBase(1, n.level);
+      vec3 v = base->pix2vec(n.id);
+      c[0] = v.x;  c[1] = v.y;  c[2] = v.z;
+      r = base->max_pixrad();
+    }
+
+    int cl = classifyShape(c[0], c[1], c[2], r);
+
+    if (cl < 0)
+      continue;
+
+    if (cl > 0) {
+// HTM: lowest available depth not lower than the trixel one
+      int p = params[0];
+      for (i=0; p < n.level; i++)
+        p = params[i+1];
+      int sh = 2*(p - n.level);
+      st_param = p;
+      st_lo = n.id << sh;
+      st_hi = (n.id + 1) << sh;
+      continue;
+    }
+
+    int maxlev = (schema == DIF_HTM  ?  params.back()  :  params[0]);
+    if (n.level == maxlev) {
+      param = maxlev;
+      val = (nested  ?  n.id  :  getHealPBase(1, maxlev)->nest2ring(n.id));
+      full = 0;
+      return 0;
+    }
+
+// Children, the first one on top
+    DIF_StreamNode ch[4];
+    for (i=0; i<4; i++) {
+      ch[i].id = 4*n.id + i;
+      ch[i].level = n.level + 1;
+    }
+
+    if (schema == DIF_HTM) {
+      double w[9];
+      midPoint(n.v+3, n.v+6, w);
+      midPoint(n.v,   n.v+6, w+3);
+      midPoint(n.v,   n.v+3, w+6);
+      const double* cv[4][3] = {
+        {n.v,   w+6, w+3},
+        {n.v+3, w,   w+6},
+        {n.v+6, w+3, w  },
+        {w,     w+3, w+6}
+      };
+      for (i=0; i<4; i++)
+        for (j=0; j<3; j++) {
+          ch[i].v[3*j]   = cv[i][j][0];
+          ch[i].v[3*j+1] = cv[i][j][1];
+          ch[i].v[3*j+2] = cv[i][j][2];
+        }
+    }
+
+    for (i=3; i>=0; i--)
+      st_stack.push_back(ch[i]);
+  }
+}
@@ -0,0 +1,487 @@
+/*
+  Benchmark of the DIF_Region pixelization (DIF_Region::go()) without
+  any MySQL server.
+  The benchmark sweeps over schema (HTM, HEALPix RING and NESTED), region
+  type (circle, rectangle, neighbors by coords, higher depth neighbors),
+  region size, declination and depth/order parameter sets.
+  For each case it reports the go() latency percentiles, the number of
+  heap allocations and allocated bytes, the number of full and partial
+  pixels returned and the median latency of the first pixel of the
+  streamed decomposition used by DIF.dif (go(true), see DIFstream.cpp).
+  Results are written in JSON format (one case per line) and can be
+  compared against a previously saved run ("-b" option).
+  Use "benchMySearch -h" to see options.
+
+
+  LN @ INAF-OAS October 2026                        Last changed: 19/10/2026
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+using namespace std;
+
+#include <cstdlib>
+#include <cstdio>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+#include <new>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <algorithm>
+
+#include "dif.hh"
+
+// Progran name
+const char PROGNAME[] = "benchMySearch";
+
+// Version ID string
+static string VERID="Ver 1.0, 19-10-2026, LN@INAF-OAS";
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+
+// Heap allocation counters (only active around DIF_Region::go())
+static bool count_alloc = false;
+static unsigned long long n_alloc = 0;
+static unsigned long long n_bytes = 0;
+
+void* operator new(size_t sz)
+{
+  if (count_alloc) {
+    n_alloc++;
+    n_bytes += sz;
+  }
+  void *p = malloc(sz ? sz : 1);
+  if (! p) throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](size_t sz)
+{ return operator new(sz); }
+
+void operator delete(void *p) throw()
+{ free(p); }
+
+void operator delete[](void *p) throw()
+{ free(p); }
+
+void operator delete(void *p, size_t) throw()
+{ free(p); }
+
+void operator delete[](void *p, size_t) throw()
+{ free(p); }
+
+
+// One benchmark case
+struct BenchCase {
+  enum DIF_Schema schema;
+  enum DIF_RegionType regtype;
+  const char *regname;
+  double size;             //radius or side (arcmin)
+  double dec;              //center Dec (deg)
+  vector<int> params;      //depth/order list
+
+  //Results
+  double p50, p90, p99, pmax;  //latency (microsec)
+  double first;                //streamed first pixel latency (microsec)
+  unsigned long long allocs, bytes;
+  unsigned long long nfull, npart;
+
+  string key() const {
+    ostringstream s;
+    s << (schema == DIF_HTM ? "HTM" :
+          (schema == DIF_HEALP_RING ? "HEALP_RING" : "HEALP_NEST"))
+      << "/" << regname << "/size=" << size << "/dec=" << dec << "/p=";
+    for (unsigned int i=0; i<params.size(); i++)
+      s << (i ? "," : "") << params[i];
+    return s.str();
+  }
+};
+
+
+
+void
+usage() {
+
+  cout << PROGNAME << "  " << VERID << "\n" << endl
+       << "Usage:" << endl
+       << PROGNAME << " [OPTIONS]" << endl
+       << "Where OPTIONS are:\n" << endl
+       << "  -h: print this help" << endl
+       << "  -b File: compare results with the baseline JSON file 'File'" << endl
+       << "  -n Nrep: repeat each case 'Nrep' times (def. 50)" << endl
+       << "  -o File: write JSON results to 'File' (def. stdout)" << endl
+       << "  -q: quick run (reduced sweep)" << endl
+       << "  -T Tol: regression tolerance on median latency in % (def. 20)" << endl
+       << endl
+       << "Exit code is 2 if any case is slower than the baseline by more than"
+       << " 'Tol' %." << endl
+       << endl;
+  exit(0);
+
+}
+
+
+static double now_us()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e6 + ts.tv_nsec * 1e-3;
+}
+
+
+static double percentile(vector<double> &v, double pc)
+{
+  if (v.size() == 0) return 0.;
+  size_t i = (size_t) (pc / 100. * (v.size() - 1) + 0.5);
+  return v[i];
+}
+
+
+/*
+  Setup the region parameters as done by the DIF_* region UDFs
+  (see udf.cc: DIF_Circle_init, DIF_Rect_init, DIF_NeighbC_init,
+  DIF_sNeighb_init).
+*/
+static void setup_region(DIF_Region &ss, BenchCase &bc, double ra)
+{
+  unsigned int i;
+  double de = bc.dec;
+
+  ss.clear_region();
+  ss.setSchema(bc.schema);
+  for (i=0; i<bc.params.size(); i++)
+    ss.setAvailParam(bc.params[i]);
+
+  switch (bc.regtype) {
+    case DIF_REG_CIRCLE:
+      ss.regtype = DIF_REG_CIRCLE;
+      ss.ra1 = ra;
+      ss.de1 = de;
+      ss.rad = bc.size;
+      break;
+
+    case DIF_REG_4VERT: {
+      double hside_de = bc.size / 120.;
+      double hside_ra = hside_de / cos(de * DEG2RAD);
+      if (hside_ra > 180.) hside_ra = 180.;
+      double de1 = de - hside_de, de2 = de + hside_de;
+      if (de1 < -90.) de1 = -90. + 6e-4;
+      if (de2 >  90.) de2 =  90. - 6e-4;
+
+      ss.ra1 = ra - hside_ra;
+      ss.ra3 = ra + hside_ra;
+      if (ss.ra1 < 0.)   ss.ra1 += 360.;
+      if (ss.ra3 > 360.) ss.ra3 -= 360.;
+      ss.ra2 = ss.ra1;
+      ss.ra4 = ss.ra3;
+      ss.de1 = de1;
+      ss.de2 = de2;
+      ss.de3 = de2;
+      ss.de4 = de1;
+      ss.regtype = DIF_REG_4VERT;
+      break;
+    }
+
+    case DIF_REG_NEIGHBC:
+      ss.regtype = DIF_REG_NEIGHBC;
+      ss.ra1 = ra;
+      ss.de1 = de;
+      break;
+
+    case DIF_REG_SNEIGHB: {
+      char *saved = NULL;
+      unsigned long long int id;
+      ss.regtype = DIF_REG_SNEIGHB;
+      ss.outdepth = bc.params.back();
+      ss.indepth = ss.outdepth - 2;
+      getHTMid(saved, ss.indepth, ra, de, &id);
+      cleanHTMUval(saved);
+      ss.refpix = id;
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+
+static void run_case(BenchCase &bc, int nrep)
+{
+  DIF_Region ss;
+  vector<double> times, ftimes;
+  int i, param, full;
+  unsigned int j;
+  long long int val;
+  double t0;
+
+  bc.allocs = bc.bytes = bc.nfull = bc.npart = 0;
+
+  for (i=0; i<nrep; i++) {
+    // Move slightly the center at each repetition to avoid always hitting
+    // the same pixel boundaries
+    double ra = 10. + i * 0.37;
+    setup_region(ss, bc, ra);
+
+    n_alloc = n_bytes = 0;
+    count_alloc = true;
+    t0 = now_us();
+    ss.go();
+    times.push_back(now_us() - t0);
+    count_alloc = false;
+
+    if (i == 0) {
+      bc.allocs = n_alloc;
+      bc.bytes = n_bytes;
+      for (j=0; j<ss.params.size(); j++) {
+        bc.nfull += ss.flist(ss.params[j]).size();
+        bc.npart += ss.plist(ss.params[j]).size();
+      }
+    }
+
+    setup_region(ss, bc, ra);
+    t0 = now_us();
+    ss.go(true);
+    ss.read_next(param, val, full);
+    ftimes.push_back(now_us() - t0);
+  }
+  ss.clear_region();
+
+  sort(times.begin(), times.end());
+  bc.p50 = percentile(times, 50.);
+  bc.p90 = percentile(times, 90.);
+  bc.p99 = percentile(times, 99.);
+  bc.pmax = times.back();
+  sort(ftimes.begin(), ftimes.end());
+  bc.first = percentile(ftimes, 50.);
+}
+
+
+static void build_sweep(vector<BenchCase> &cases, bool quick)
+{
+  const enum DIF_Schema schemas[] = {DIF_HTM, DIF_HEALP_RING, DIF_HEALP_NEST};
+  const double sizes[]  = {1., 10., 60., 300.};
+  const double decs[]   = {0., 45., 85., -89.9};
+  const int nsizes = (quick ? 2 : 4), ndecs = (quick ? 2 : 4);
+  int is, ir, iz, id;
+  unsigned int ip;
+
+  vector<vector<int> > htm_p, healp_p;
+  htm_p.push_back(vector<int>(1, 6));
+  htm_p.push_back(vector<int>(1, 10));
+  if (! quick) {
+    vector<int> md;
+    md.push_back(6);
+    md.push_back(8);
+    md.push_back(10);
+    htm_p.push_back(md);
+  }
+  healp_p.push_back(vector<int>(1, 8));
+  healp_p.push_back(vector<int>(1, 12));
+
+  for (is=0; is<3; is++) {
+    vector<vector<int> > &plist = (schemas[is] == DIF_HTM ? htm_p : healp_p);
+
+    for (ir=0; ir<4; ir++) {
+      BenchCase bc = BenchCase();
+      bc.schema = schemas[is];
+      switch (ir) {
+        case 0: bc.regtype = DIF_REG_CIRCLE;  bc.regname = "circle";  break;
+        case 1: bc.regtype = DIF_REG_4VERT;   bc.regname = "rect";    break;
+        case 2: bc.regtype = DIF_REG_NEIGHBC; bc.regname = "neighbc"; break;
+        case 3: bc.regtype = DIF_REG_SNEIGHB; bc.regname = "sneighb"; break;
+      }
+
+      //Higher depth neighbors are available for HTM only
+      if (bc.regtype == DIF_REG_SNEIGHB  &&  bc.schema != DIF_HTM)
+        continue;
+
+      for (iz=0; iz<nsizes; iz++) {
+        //Neighbors do not depend on the region size
+        if ((bc.regtype == DIF_REG_NEIGHBC  ||  bc.regtype == DIF_REG_SNEIGHB)
+            &&  iz > 0)
+          break;
+        bc.size = sizes[iz];
+
+        for (id=0; id<ndecs; id++) {
+          bc.dec = decs[id];
+          for (ip=0; ip<plist.size(); ip++) {
+            bc.params = plist[ip];
+            cases.push_back(bc);
+          }
+        }
+      }
+    }
+  }
+}
+
+
+static void write_json(ostream &os, vector<BenchCase> &cases, int nrep)
+{
+  unsigned int i;
+  char buf[512];
+
+  os << "[" << endl;
+  for (i=0; i<cases.size(); i++) {
+    BenchCase &bc = cases[i];
+    sprintf(buf, "{\"case\": \"%s\", \"nrep\": %d, "
+                 "\"p50_us\": %.2f, \"p90_us\": %.2f, \"p99_us\": %.2f, "
+                 "\"max_us\": %.2f, \"allocs\": %llu, \"alloc_bytes\": %llu, "
+                 "\"nfull\": %llu, \"npart\": %llu, \"first_us\": %.2f}",
+            bc.key().c_str(), nrep, bc.p50, bc.p90, bc.p99, bc.pmax,
+            bc.allocs, bc.bytes, bc.nfull, bc.npart, bc.first);
+    os << "  " << buf << (i < cases.size()-1 ? "," : "") << endl;
+  }
+  os << "]" << endl;
+}
+
+
+/*
+  Read the median latency of each case from a JSON file written by
+  write_json(). Only the format produced by this program is understood.
+*/
+static int read_baseline(const char *fname, map<string, double> &base)
+{
+  ifstream in(fname);
+  string line;
+
+  if (! in.good())
+    return 1;
+
+  while (getline(in, line)) {
+    size_t c = line.find("\"case\": \"");
+    size_t m = line.find("\"p50_us\": ");
+    if (c == string::npos  ||  m == string::npos)
+      continue;
+    c += 9;
+    size_t e = line.find('"', c);
+    if (e == string::npos)
+      continue;
+    base[line.substr(c, e - c)] = atof(line.c_str() + m + 10);
+  }
+  return 0;
+}
+
+
+int
+main(int argc, char *argv[]){
+  unsigned short kwds=0;
+  char c;
+
+  unsigned int i;
+  int nrep=50, ret=0;
+  double tol=20.;
+  bool quick=false;
+  char outfile[256]="", basefile[256]="";
+
+
+/* Keywords section */
+  while (--argc > 0 && (*++argv)[0] == '-')
+  {
+    kwds=1;
+    while (kwds && (c = *++argv[0]))
+    {
+      switch (c)
+      {
+        case 'h':
+          usage();
+          break;
+        case 'b':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",basefile);
+          --argc;
+          kwds=0;
+          break;
+        case 'n':
+          if (argc < 2) usage();
+          nrep = atoi(*++argv);
+          --argc;
+          kwds=0;
+          break;
+        case 'o':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",outfile);
+          --argc;
+          kwds=0;
+          break;
+        case 'q':
+          quick = true;
+          break;
+        case 'T':
+          if (argc < 2) usage();
+          tol = atof(*++argv);
+          --argc;
+          kwds=0;
+          break;
+        default:
+          fprintf (stderr,"Illegal option `%c'.\n\n",c);
+          usage();
+      }
+    }
+  }
+
+  if (nrep < 1)
+    nrep = 1;
+
+  vector<BenchCase> cases;
+  build_sweep(cases, quick);
+
+  for (i=0; i<cases.size(); i++) {
+    run_case(cases[i], nrep);
+    cerr << cases[i].key() << ": p50 " << cases[i].p50 << " us" << endl;
+  }
+
+  if (outfile[0] != '\0') {
+    ofstream out(outfile);
+    if (! out.good()) {
+      cerr << PROGNAME << ": cannot write " << outfile << endl;
+      return 1;
+    }
+    write_json(out, cases, nrep);
+  }
+  else
+    write_json(cout, cases, nrep);
+
+
+// Compare with baseline
+  if (basefile[0] != '\0') {
+    map<string, double> base;
+    int nworse = 0, nmiss = 0;
+
+    if (read_baseline(basefile, base)) {
+      cerr << PROGNAME << ": cannot read baseline " << basefile << endl;
+      return 1;
+    }
+
+    cerr << endl << "Comparison with baseline " << basefile
+         << " (tolerance " << tol << " %):" << endl;
+    for (i=0; i<cases.size(); i++) {
+      map<string, double>::iterator it = base.find(cases[i].key());
+      if (it == base.end()) {
+        nmiss++;
+        continue;
+      }
+      double b = it->second, n = cases[i].p50;
+      double diff = (b > 0. ? (n - b) / b * 100. : 0.);
+      char buf[512];
+      sprintf(buf, "%-50s %10.2f %10.2f %+8.1f %%%s",
+              cases[i].key().c_str(), b, n, diff,
+              (diff > tol ? "  REGRESSION" : ""));
+      cerr << buf << endl;
+      if (diff > tol)
+        nworse++;
+    }
+    cerr << endl << "Regressions: " << nworse
+         << "  Cases not in baseline: " << nmiss << endl;
+    if (nworse)
+      ret = 2;
+  }
+
+  return ret;
+}
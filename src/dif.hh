@@ -34,7 +34,10 @@
 #undef VERSION
 
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
+#include <string>
 #include <vector>
 using namespace std;
 
@@ -145,6 +148,14 @@ enum DIF_RegionType {
   DIF_REG_4VERT     ,  //four-sided region (four corners)
   DIF_REG_NEIGHBC   ,  //IDs list of neighbors to a (coords) given one
   DIF_REG_SNEIGHB   ,  //IDs list of neighbors at higher depth/order given one
+  DIF_REG_CONES     ,  //multiple circles (targets list, common radius)
+  DIF_REG_POLYGON   ,  //spherical polygon (N vertices, great circle edges)
+  DIF_REG_MOC       ,  //Multi-Order Coverage map (HEALPix NESTED cells)
+  DIF_REG_ANNULUS   ,  //annulus (center, inner and outer radius)
+  DIF_REG_ELLIPSE   ,  //ellipse (center, semi-axes, position angle)
+  DIF_REG_STRIP     ,  //strip along a great circle (two points, half width)
+  DIF_REG_LONLAT    ,  //longitude/latitude box in the Galactic/Ecliptic frame
+  DIF_REG_EXPR      ,  //union/intersection/difference of regions (expression)
 };
 
 
@@ -163,42 +174,15 @@ enum DIF_Schema {
 };
 
 
+//Coordinate frame of the region parameters (indexed tables are equatorial)
+enum DIF_Frame {
+  DIF_FRAME_EQ      ,  //equatorial (ICRS, J2000)
+  DIF_FRAME_GAL     ,  //Galactic
+  DIF_FRAME_ECL        //Ecliptic (J2000)
+};
 
 
 
-//class atomRegion {
-//public:
-//  enum DIF_RegionType regtype;    //region type
-//  bool flagNOT;
-//
-//  atomRegion* child1;
-//  atomRegion* child2;
-//  atomRegion* parent;
-//
-//  atomRegion() {
-//    flagNOT = false;
-//    regtype = DIF_REG_NONE;
-//    child1 = NULL;
-//    child2 = NULL;
-//    parent = NULL;
-//  }
-//
-//  ~atomRegion() {
-//    if (child1) delete child1;
-//    if (child2) delete child2;
-//  }
-//};
-//
-//
-//class atomCircle : public atomRegion {
-//public:
-//  double ra, de, rad;
-//  
-//  atomCircle() : atomRegion() {
-//    regtype = DIF_REG_CIRCLE;
-//  }
-//};
-
 
 
 double skysep_h(double phi1, double theta1, double phi2, double theta2, short radians);
@@ -317,6 +301,309 @@ public:
 
 
 
+/*
+  class: DIF_PixelSet
+
+  Compressed set of pixel IDs (see DIFpixset.cpp). IDs are grouped in
+  blocks of 65536 by their high bits, each block stored in the smallest
+  of three encodings of its low 16 bits: varint deltas (sparse), varint
+  runs of consecutive IDs (ranges) or a 1024 words bitmap (dense). Union,
+  intersection and difference work block by block on the bitmaps, 64 IDs
+  per operation.
+ */
+class DIF_PixelSet {
+public:
+  enum { ENC_DELTA, ENC_RUN, ENC_BITMAP };
+
+  struct Block {
+    unsigned long long key;   //ID >> 16
+    unsigned int card;        //number of IDs
+    unsigned int off;         //offset in data (bytes) or words (bitmap)
+    unsigned int len;         //bytes or words
+    int enc;
+  };
+
+  //Sequential reader, optionally from the rank-th ID
+  class Cursor {
+    const DIF_PixelSet* set;
+    unsigned int ib;          //current block
+    unsigned int pos;         //next byte/word of the block
+    unsigned int left;        //IDs of the block not yet read into a run
+    unsigned int last;        //last low value read (deltas and runs)
+    unsigned long long bits;  //unread bits of the current bitmap word
+    long long int a, b;       //current run, a > b if empty
+
+    void openBlock();
+    bool fetch();             //next maximal run of the current block
+
+  public:
+    void begin(const DIF_PixelSet& s, unsigned long long rank = 0);
+
+    bool next(long long int& id) {
+      if (a > b  &&  ! fetch()) return false;
+      id = a++;
+      return true;
+    }
+
+    bool peek(long long int& id) {
+      if (a > b  &&  ! fetch()) return false;
+      id = a;
+      return true;
+    }
+
+    //Consecutive IDs from the next one, at most n: return their number
+    unsigned long long nextRun(long long int& lo, long long int& hi,
+                               unsigned long long n);
+  };
+
+private:
+  vector<Block> blk;
+  vector<unsigned char> data;
+  vector<unsigned long long> words;
+  unsigned long long card;
+
+  void addBlock(unsigned long long key, const unsigned short* low,
+                unsigned int n);
+  void copyBlock(const DIF_PixelSet& s, const Block& b);
+  void toBitmap(const Block& b, unsigned long long* w) const;
+  static void combine(const DIF_PixelSet& x, const DIF_PixelSet& y,
+                      int op, DIF_PixelSet& out);
+
+public:
+  DIF_PixelSet() : card(0) {}
+
+  void clear();
+
+  //Set from IDs sorted in ascending order, without duplicates
+  void assign(const vector<long long int>& ids);
+
+  //All the IDs, in ascending order
+  void toVector(vector<long long int>& ids) const;
+
+  unsigned long long size() const
+  { return card; }
+
+  //Memory used by the encoded IDs
+  unsigned long long bytes() const {
+    return blk.size()*sizeof(Block) + data.size() +
+      words.size()*sizeof(unsigned long long);
+  }
+
+  static void setUnion(const DIF_PixelSet& x, const DIF_PixelSet& y,
+                       DIF_PixelSet& out)
+  { combine(x, y, 0, out); }
+
+  static void setIntersection(const DIF_PixelSet& x, const DIF_PixelSet& y,
+                              DIF_PixelSet& out)
+  { combine(x, y, 1, out); }
+
+  static void setDifference(const DIF_PixelSet& x, const DIF_PixelSet& y,
+                            DIF_PixelSet& out)
+  { combine(x, y, 2, out); }
+};
+
+
+
+/*
+  struct: DIF_ListReader
+
+  Reads the IDs from pos to end (excluded) of a pixel list, stored as a
+  vector or, if s is not NULL, as a DIF_PixelSet.
+ */
+struct DIF_ListReader {
+  const vector<long long int>* v;
+  const DIF_PixelSet* s;
+  DIF_PixelSet::Cursor c;
+  unsigned long pos, end;
+
+  void begin(const vector<long long int>* lv, const DIF_PixelSet* ls,
+             unsigned long b, unsigned long e) {
+    v = lv;
+    s = ls;
+    pos = b;
+    end = e;
+    if (s) c.begin(*s, b);
+  }
+
+  bool next(long long int& id) {
+    if (pos >= end) return false;
+    pos++;
+    if (s) return c.next(id);
+    id = (*v)[pos-1];
+    return true;
+  }
+
+  bool peek(long long int& id) {
+    if (pos >= end) return false;
+    if (s) return c.peek(id);
+    id = (*v)[pos];
+    return true;
+  }
+
+  //Run of consecutive IDs from the next one (pos < end)
+  void nextRun(long long int& lo, long long int& hi) {
+    if (s) {
+      pos += c.nextRun(lo, hi, end - pos);
+      return;
+    }
+    lo = hi = (*v)[pos++];
+    while ((pos < end)  &&  ((*v)[pos] <= hi + 1)) {
+      if ((*v)[pos] > hi) hi = (*v)[pos];
+      pos++;
+    }
+  }
+};
+
+
+
+/*
+  struct: DIF_TargetPix
+
+  A pixel covered by one of the circles of a multi-region (DIF_REG_CONES)
+  search: index of the target in the DIF_Region targets list,
+  depth/order parameter, pixel ID and full flag.
+ */
+struct DIF_TargetPix {
+  long long int id;
+  int target;
+  int param;
+  int full;
+};
+
+
+
+/*
+  struct: DIF_StreamNode
+
+  Pixel of the streamed decomposition stack (see DIFstream.cpp): ID,
+  HTM depth or HEALPix NESTED order and, for HTM, the trixel vertices as
+  x, y, z unit vectors.
+ */
+struct DIF_StreamNode {
+  long long int id;
+  int level;
+  double v[9];
+};
+
+
+
+/*
+  struct: DIF_PolyPiece
+
+  Convex piece of a polygon (DIF_REG_POLYGON) region: indexes of its
+  vertices in the DIF_Region vertex list (counter-clockwise) and the inward
+  unit normals of its edges, as x, y, z triplets.
+ */
+struct DIF_PolyPiece {
+  vector<int> vtx;
+  vector<double> nrm;
+};
+
+
+
+/*
+  struct: DIF_Convex
+
+  Intersection of spherical caps n.v >= d, as the HTM SpatialConvex: unit
+  normals as x, y, z triplets and the corresponding d values. Used by the
+  annulus, ellipse and strip regions (see DIF_Region::makeShape).
+ */
+struct DIF_Convex {
+  vector<double> nrm;
+  vector<double> d;
+};
+
+
+
+/*
+  struct: DIF_Ranges
+
+  Set of pixel IDs as sorted, disjoint ranges [lo[i], hi[i]), e.g. the
+  full or partial pixels of a region at the highest depth/order (see
+  DIFexpr.cpp).
+ */
+struct DIF_Ranges {
+  vector<long long int> lo, hi;
+
+  void clear() {
+    lo.clear();
+    hi.clear();
+  }
+
+  unsigned long size() const
+  { return lo.size(); }
+
+  void swap(DIF_Ranges& r) {
+    lo.swap(r.lo);
+    hi.swap(r.hi);
+  }
+};
+
+
+
+
+/*
+  MOC (IVOA Multi-Order Coverage) serializations, see DIFmoc.cpp
+ */
+int DIF_MOCParse(const char* moc, unsigned long len,
+                 vector<unsigned long long>& lo,
+                 vector<unsigned long long>& hi);
+
+void DIF_MOCString(int order, vector<long long int>& ids, string& out);
+
+
+
+/*
+  Galactic and Ecliptic frames, see DIFframe.cpp
+ */
+int DIF_frameParse(const char* name, unsigned long len);
+
+void DIF_frameRotate(enum DIF_Frame frame, const double* v, double* w);
+
+void DIF_frameToEq(enum DIF_Frame frame, double lon, double lat,
+                   double* ra, double* de);
+
+double DIF_frameToEqPA(enum DIF_Frame frame, double lon, double lat,
+                       double pa);
+
+
+
+
+/*
+  Prepared regions (DIF_Prepare), shared by all the connections, see
+  DIFprepare.cpp: register the region expression or MOC and return its
+  handle (> 0), -1 if not valid, -2 if DIF_PLAN_MAX regions are prepared;
+  release it, return whether it was prepared
+ */
+#define DIF_PLAN_MAX 256
+
+long long int DIF_planPrepare(const char* spec, unsigned long len);
+
+int DIF_planRelease(long long int handle);
+
+
+
+
+/*
+  Pixel lists larger than this (IDs, 1 MB) are not kept for reuse by the
+  next statement
+ */
+#define DIF_LIST_MAXKEEP (1 << 17)
+
+/*
+  go() reserves no more than this (IDs) for each list: larger lists grow
+  as needed
+ */
+#define DIF_LIST_MAXRESERVE (DIF_LIST_MAXKEEP / 8)
+
+/*
+  Pixel lists with at least this number of IDs are compressed when read
+  by the DIF tables (see DIF_Region::compact)
+ */
+#define DIF_COMPACT_MIN (1 << 16)
+
+
+
 /*
   class: DIF_Region
  */
@@ -330,6 +617,21 @@ private:
 
   //vector of pointers to vectors of PARTIAL pixel IDs
   vector<vector<long long int>*> pplist;
+
+  //FULL and PARTIAL lists stored compressed, if not empty (see compact)
+  vector<DIF_PixelSet> pfset, ppset;
+
+  //Cleared pixel lists, reused with their capacity by the next go() of
+  //this (thread's) region: see newList and clear_pixel
+  vector<vector<long long int>*> lpool;
+
+  vector<long long int>* newList() {
+    if (lpool.size() == 0)
+      return new vector<long long int>;
+    vector<long long int>* l = lpool.back();
+    lpool.pop_back();
+    return l;
+  }
  
   //NULL vector
   static vector<long long int> nullvec;
@@ -363,16 +665,88 @@ private:
   int rn_iavail_param;
   int rn_param;
   int rn_full;
-  int rn_ipos;
-  vector<long long int>* rn_list;
+  DIF_ListReader rn_rd;
+  unsigned long rn_tpos, rn_tend;
   //-------------------
 
+  //Read_next_range interface
+  int rg_iavail_param;
+  bool rg_begin;
+  DIF_ListReader rg_f, rg_p;
+  //-------------------
+
+  //Streamed decomposition: pixels computed while reading (see
+  //DIFstream.cpp), the lists are not used
+  bool st_on;
+  vector<DIF_StreamNode> st_stack;
+  long long int st_lo, st_hi;    //pending full pixels [st_lo, st_hi)
+  int st_param;                  //and their param
+
+  int streamable();
+  void stream_reset();
+  int stream_next(int& param, long long int& val, int& full);
+  //-------------------
+
+  //Chunk k of n of the pixel lists to be read (see DIF_Chunk)
+  int chunk_k, chunk_n;
+
+  //Bounds [b, e) of the current chunk of a list of size elements
+  void chunkBounds(unsigned long size, unsigned long& b, unsigned long& e) {
+    b = (unsigned long) (((unsigned long long) size * chunk_k) / chunk_n);
+    e = (unsigned long) (((unsigned long long) size * (chunk_k+1)) / chunk_n);
+  }
+
+
+  //Multi-region targets: ID and coordinates (deg)
+  vector<long long int> tg_id;
+  vector<double> tg_ra, tg_de;
+
+  //Target indexes sorted by ID and by Dec (populated in ::go())
+  vector<int> tg_byid, tg_byde;
+
+  //Pixels of each target (populated in ::go())
+  vector<DIF_TargetPix> tpix;
+
+
+  //Polygon vertices (deg) and its convex pieces (see makePolygon)
+  vector<double> pg_ra, pg_de;
+  vector<DIF_PolyPiece> pg_piece;
+
+  //MOC: sorted, disjoint order 29 NESTED pixel ranges [lo, hi)
+  vector<unsigned long long> moc_lo, moc_hi;
+
+  //Annulus, ellipse, strip: convex inside (sh_in) and containing (sh_out)
+  //the region, equal but for the ellipse (see makeShape)
+  DIF_Convex sh_in, sh_out;
+
+  //Ellipse: center, major and minor axis directions (unit vectors), semi
+  //axes in the gnomonic projection and semi-major axis (rad)
+  double el_c[3], el_u[3], el_w[3];
+  double el_A, el_B, el_a;
+
+  //Expression: its regions (atoms) and the expression in postfix order,
+  //atom indexes (>= 0) or operators (< 0), see DIFexpr.cpp
+  vector<DIF_Region*> ex_atom;
+  vector<int> ex_code;
+  vector<char> ex_eval;   //evaluation stack of inExpr
+
+  //Handle of the prepared region this region is defined from (0 if none),
+  //see DIFprepare.cpp
+  long long int pl_handle;
+
 
 
   bool go_performed; //whether go() has already been executed
 
   enum DIF_Schema schema;         //pixelization schema
 
+  void go_cones();
+  void go_expr();
+  void exprSetup();
+  double estimateExpr();
+  bool go_prepared();
+  void keep_prepared();
+
 public:
   enum DIF_RegionType regtype;    //region type
 
@@ -380,6 +754,14 @@ public:
   double ra1, ra2, de1, de2, rad;
   double ra3, ra4, de3, de4;
 
+  //Annulus inner radius or ellipse semi-minor axis (arcmin), ellipse
+  //position angle (deg, east of north)
+  double rad2, pa;
+
+  //Frame of the DIF_REG_LONLAT box (other regions are converted to
+  //equatorial when defined)
+  enum DIF_Frame frame;
+
   //Reference pixel ID for which higher depth/order neighbors are requested
   long long int refpix;
 
@@ -404,12 +786,19 @@ public:
   void clear_pixel() {
     int i;
     for (i=0; i<pflist.size(); i++)
-      delete pflist[i];
+      keepList(pflist[i]);
     for (i=0; i<pplist.size(); i++)
-      delete pplist[i];
+      keepList(pplist[i]);
     
     pflist.clear();
     pplist.clear();
+    pfset.clear();
+    ppset.clear();
+    tpix.clear();
+    tg_byid.clear();
+    tg_byde.clear();
+    st_on = false;
+    st_stack.clear();
     go_performed = false;
     cputime = 0.;
 
@@ -419,9 +808,22 @@ public:
    }
 
 
+  //Put a list in the pool, unless it is too large to be kept
+  void keepList(vector<long long int>* l) {
+    if (l->capacity() > DIF_LIST_MAXKEEP) {
+      delete l;
+      return;
+    }
+    l->clear();
+    lpool.push_back(l);
+  }
+
+
   //Clear region and pixel
   void clear_region() {
     regtype = DIF_REG_NONE;
+    chunk_k = 0;
+    chunk_n = 1;
     ra1 = 0.;
     de1 = 0.;
     ra2 = 0.;
@@ -431,22 +833,285 @@ public:
     ra4 = 0.;
     de4 = 0.;
     rad = 0.;
+    rad2 = 0.;
+    pa = 0.;
+    frame = DIF_FRAME_EQ;
     indepth = 0;
     refpix = 0;
     outdepth = 0;
+    clear_targets();
+    clear_polygon();
+    clear_moc();
+    clear_shape();
+    clear_expr();
+    pl_handle = 0;
     clear_pixel();
   }
 
 
+  //Clear multi-region targets
+  void clear_targets() {
+    tg_id.clear();
+    tg_ra.clear();
+    tg_de.clear();
+    tpix.clear();
+    tg_byid.clear();
+    tg_byde.clear();
+  }
+
+
+  //Add a multi-region target, return the number of targets
+  int addTarget(long long int id, double ra, double de) {
+    tg_id.push_back(id);
+    tg_ra.push_back(ra);
+    tg_de.push_back(de);
+    return tg_id.size();
+  }
+
+  int ntargets()
+  { return tg_id.size(); }
+
+  double targetRa(int i)
+  { return tg_ra[i]; }
+
+  double targetDec(int i)
+  { return tg_de[i]; }
+
+  long long int targetId(int i)
+  { return tg_id[i]; }
+
+
+  //Add a pixel of the i-th target
+  void addTargetPix(int i, int param, long long int id, int full) {
+    DIF_TargetPix tp;
+    tp.id = id;
+    tp.target = i;
+    tp.param = param;
+    tp.full = full;
+    tpix.push_back(tp);
+  }
+
+
+  //Index of the target with the given ID, -1 if not found
+  int findTarget(long long int id) {
+    unsigned long lo = 0, hi = tg_byid.size();
+    while (lo < hi) {
+      unsigned long mid = (lo + hi) / 2;
+      if (tg_id[tg_byid[mid]] < id) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo < tg_byid.size()  &&  tg_id[tg_byid[lo]] == id)
+      return tg_byid[lo];
+    return -1;
+  }
+
+
+  //Whether (ra, de) is within 'rad' arcmin of any target
+  bool inTargets(double ra, double de) {
+    double drad = rad / 60.;
+    unsigned long lo = 0, hi = tg_byde.size();
+    while (lo < hi) {
+      unsigned long mid = (lo + hi) / 2;
+      if (tg_de[tg_byde[mid]] < de - drad) lo = mid + 1;
+      else hi = mid;
+    }
+    for (; lo < tg_byde.size(); lo++) {
+      int i = tg_byde[lo];
+      if (tg_de[i] > de + drad) break;
+      double sep = skysep_h(tg_ra[i], tg_de[i], ra, de, 0);
+      if (sep >= 0.  &&  sep <= rad)
+        return true;
+    }
+    return false;
+  }
+
+
+  //Clear polygon vertices and pieces
+  void clear_polygon() {
+    pg_ra.clear();
+    pg_de.clear();
+    pg_piece.clear();
+  }
+
+
+  //Add a polygon vertex, return the number of vertices
+  int addVertex(double ra, double de) {
+    pg_ra.push_back(ra);
+    pg_de.push_back(de);
+    return pg_ra.size();
+  }
+
+  int nvertices()
+  { return pg_ra.size(); }
+
+  double vertexRa(int i)
+  { return pg_ra[i]; }
+
+  double vertexDec(int i)
+  { return pg_de[i]; }
+
+
+  //Split the polygon into convex pieces: return their number, -1 if the
+  //polygon is degenerate, self-intersecting or not within an hemisphere
+  int makePolygon();
+
+  int npieces()
+  { return pg_piece.size(); }
+
+  const DIF_PolyPiece& piece(int k)
+  { return pg_piece[k]; }
+
+
+  //Whether the unit vector (x, y, z) is inside the k-th convex piece with
+  //a distance from its edges whose sine is at least 'margin'
+  bool inPiece(int k, double x, double y, double z, double margin = 0.) {
+    const vector<double>& n = pg_piece[k].nrm;
+    for (unsigned int i=0; i<n.size(); i+=3)
+      if (n[i]*x + n[i+1]*y + n[i+2]*z < margin)
+        return false;
+    return true;
+  }
+
+
+  //Whether (ra, de) is inside the polygon
+  bool inPolygon(double ra, double de) {
+    double r = ra * M_PI/180., d = de * M_PI/180.;
+    double x = cos(d)*cos(r), y = cos(d)*sin(r), z = sin(d);
+    for (unsigned int k=0; k<pg_piece.size(); k++)
+      if (inPiece(k, x, y, z))
+        return true;
+    return false;
+  }
+
+
+  //Clear MOC ranges
+  void clear_moc() {
+    moc_lo.clear();
+    moc_hi.clear();
+  }
+
+
+  //Set the MOC from its ASCII (e.g. "3/1-5 4/35,36") or binary (order 29
+  //ranges) serialization: return the number of ranges, -1 on error
+  int setMOC(const char* moc, unsigned long len)
+  { return DIF_MOCParse(moc, len, moc_lo, moc_hi); }
+
+  int nmocranges()
+  { return moc_lo.size(); }
+
+  unsigned long long mocLo(int i)
+  { return moc_lo[i]; }
+
+  unsigned long long mocHi(int i)
+  { return moc_hi[i]; }
+
+
+  //Whether (ra, de) is inside the MOC (see DIFmoc.cpp)
+  bool inMOC(double ra, double de);
+
+
+  //Clear annulus, ellipse and strip convexes
+  void clear_shape() {
+    sh_in.nrm.clear();
+    sh_in.d.clear();
+    sh_out.nrm.clear();
+    sh_out.d.clear();
+  }
+
+
+  //Set the convexes of the annulus, ellipse or strip region from ra1, de1,
+  //ra2, de2, rad, rad2 and pa, or of the DIF_REG_LONLAT box (longitude
+  //from ra1 to ra3, latitude from de1 to de2, in 'frame'): return the
+  //number of caps of sh_out, -1 if the parameters are not valid (see
+  //DIFshape.cpp)
+  int makeShape();
+
+  const DIF_Convex& shapeIn()
+  { return sh_in; }
+
+  const DIF_Convex& shapeOut()
+  { return sh_out; }
+
+  //Whether the shape is exactly the sh_in (and sh_out) convex
+  bool shapeExact()
+  { return (regtype != DIF_REG_ELLIPSE); }
+
+
+  //Whether (ra, de) is inside the annulus, ellipse or strip
+  bool inShape(double ra, double de);
+
+  //Whether the disc of radius r (rad) around the unit vector (x, y, z) is
+  //inside (1), outside (-1) or across (0) the region border
+  int classifyShape(double x, double y, double z, double r);
+
+
+  //Set the circle of center (ra, de) and radius r (arcmin), or the
+  //rectangle of corners (ra1, de1) and (ra2, de2) with ra1 <= ra2 and
+  //de1 <= de2 (deg), as DIF_Circle and DIF_Rectv
+  void setCircle(double ra, double de, double r);
+  void setRect(double r1, double d1, double r2, double d2);
+
+
+  //Clear the regions of an expression
+  void clear_expr() {
+    for (unsigned int i=0; i<ex_atom.size(); i++)
+      delete ex_atom[i];
+    ex_atom.clear();
+    ex_code.clear();
+  }
+
+
+  //Set the expression of circles, rectangles, polygons, annuli, ellipses
+  //and strips, e.g. "circle(10,20,30) - circle(10,20,5) | poly(...)", see
+  //DIFexpr.cpp: return the number of regions, -1 on syntax error, -2 if a
+  //region is not valid
+  int setExpr(const char* expr, unsigned long len);
+
+  int nexpratoms()
+  { return ex_atom.size(); }
+
+
+  //Whether (ra, de) is inside the expression region
+  bool inExpr(double ra, double de);
+
+
+  //Define the region from the prepared region 'handle', whose pixels are
+  //computed once for each schema and params and shared by all the
+  //connections (see DIFprepare.cpp): return the number of regions of the
+  //expression or of MOC ranges, -1 if the handle is not valid. The handle
+  //0 only stops using the prepared pixels.
+  int usePlan(long long int handle);
+
+  //Whether (ra, de) is inside the region, but for DIF_REG_CONES and the
+  //neighbors lists
+  bool inRegion(double ra, double de);
+
+
   //Constructor
   DIF_Region()
   { clear_region(); }
   
   //Destructor
-  ~DIF_Region() 
-  { clear_region(); }
+  ~DIF_Region() {
+    clear_region();
+    for (unsigned int i=0; i<lpool.size(); i++)
+      delete lpool[i];
+  }
   
 
+  //Read only the chunk k (0 <= k < n) of n disjoint chunks of each pixel
+  //list, until the next setChunk (by DIF_Chunk_deinit at the end of the
+  //statement) or clear_region
+  void setChunk(int k, int n) {
+    chunk_k = k;
+    chunk_n = n;
+    if (st_on  &&  n > 1)
+      go_performed = st_on = false;  //the lists are needed
+    else
+      read_reset();
+  }
+
+
   //Add available param
   void setAvailParam(int p) {
     if (locateAvailParam(p) == -1) {
@@ -488,7 +1153,7 @@ public:
 
   //Read interface
   void read_update_list() {
-    rn_list = &nullvec;
+    rn_rd.begin(&nullvec, NULL, 0, 0);
     
     if (avail_params.size() == 0)
       return;
@@ -496,26 +1161,42 @@ public:
     int i = locateParam(avail_params[rn_iavail_param]);
     if (i > -1) {
 	if (pflist.size() > i)
-	    rn_list = (rn_full ?   pflist[i]   :   pplist[i]);
-	else 
-	    rn_list = &nullvec;
+	    openList(rn_rd, i, rn_full);
+	rn_param = params[i];
     } 
-    rn_param = params[i];
-    rn_ipos = 0;
+  }
+
+
+  //Read the chunk of the full or partial list of the i-th param
+  void openList(DIF_ListReader& r, int i, int full) {
+    vector<long long int>* l = (full  ?  pflist[i]  :  pplist[i]);
+    DIF_PixelSet* s = NULL;
+    unsigned long b, e;
+
+    if ((unsigned long) i < pfset.size()  &&  (full ? pfset[i] : ppset[i]).size())
+      s = (full  ?  &pfset[i]  :  &ppset[i]);
+    chunkBounds((s  ?  s->size()  :  l->size()), b, e);
+    r.begin(l, s, b, e);
   }
   
   
   void read_reset() {
+    chunkBounds(tpix.size(), rn_tpos, rn_tend);
+    rg_iavail_param = 0;
+    rg_begin = true;
     rn_iavail_param = 0;
     rn_full = 1;
     read_update_list();
+    if (st_on)
+      stream_reset();
   }
   
   
   inline int read_next(int& param, long long int& val, int& full) {
-    if (rn_ipos < rn_list->size()) {
+    if (st_on)
+      return stream_next(param, val, full);
+    if (rn_rd.next(val)) {
       param = rn_param;
-      val = (*rn_list)[rn_ipos++];
       full = rn_full;
       return 0;
     }
@@ -540,10 +1221,109 @@ public:
   }
   
   
-  void go();
+  //Read interface for multi-region searches: also return the target ID
+  inline int read_next_target(long long int& target, int& param,
+                              long long int& val, int& full) {
+    if (regtype != DIF_REG_CONES) {
+      target = 0;
+      return read_next(param, val, full);
+    }
+    if (rn_tpos < rn_tend) {
+      DIF_TargetPix& tp = tpix[rn_tpos++];
+      target = tg_id[tp.target];
+      param = tp.param;
+      val = tp.id;
+      full = tp.full;
+      return 0;
+    }
+    return 1; //Final EOF
+  }
+
+
+  //Estimated number of pixels at all the available params, without
+  //computing them (see DIFestimate.cpp)
+  double estimatePixels();
+
+
+  //Store the lists of at least DIF_COMPACT_MIN IDs as DIF_PixelSet, in
+  //ID order and without duplicates: they are still read by read_next and
+  //read_next_range, while flist and plist return them empty
+  void compact();
+
+
+  //Remove from the lists of each param the IDs covered by a full pixel of
+  //a lower param, lists sorted by ID (NESTED IDs, see DIFsetops.cpp)
+  void dropCovered();
+
+
+  //Read interface for range-coalesced searches (DIF.difr): runs of
+  //consecutive IDs with the same full flag, in ID order for each param
+  int read_next_range(int& param, long long int& lo, long long int& hi,
+                      int& full);
+
+
+  //Compute the pixels of the region; with stream they may be computed
+  //while reading by read_next (DIF.dif) instead (see DIFstream.cpp)
+  void go(bool stream = false);
+};
+
+
+
+/*
+  class: DIF_RegionSet
+
+  Independent region contexts of one thread ("slots"). Slot 0 is the
+  default one, used by DIF.dif/DIF.difm and by region UDFs called without
+  the optional slot argument; slot k (k>0) is read by DIF.dif<k>/DIF.difm<k>.
+  Different slots can then be used in the same statement (e.g. self-joins).
+ */
+#define DIF_NSLOTS 8
+
+class DIF_RegionSet {
+  DIF_Region reg[DIF_NSLOTS];
+
+public:
+  DIF_Region& operator[](int k)
+  { return reg[(k >= 0  &&  k < DIF_NSLOTS)  ?  k  :  0]; }
 };
 
 
+/*
+  Slot read by a DIF table given its (path) name: "dif", "difm", "difr" -> 0,
+  "dif<k>", "difm<k>", "difr<k>" -> k. Unknown names map to slot 0.
+ */
+inline int DIF_tableSlot(const char* name)
+{
+  const char* p = strrchr(name, '/');
+  p = (p  ?  p+1  :  name);
+  if (strncmp(p, "dif", 3) != 0) return 0;
+  p += 3;
+  if (*p == 'm'  ||  *p == 'r') p++;
+  int k = atoi(p);
+  return (k > 0  &&  k < DIF_NSLOTS)  ?  k  :  0;
+}
+
+
+/*
+  Content of a DIF table given its (path) name
+ */
+enum DIF_TableKind {
+  DIF_TBL_PIX   ,  //dif<k>:  (param, id, full)
+  DIF_TBL_TARGET,  //difm<k>: (target, param, id, full)
+  DIF_TBL_RANGE    //difr<k>: (param, lo, hi, full), ranges of IDs
+};
+
+inline enum DIF_TableKind DIF_tableKind(const char* name)
+{
+  const char* p = strrchr(name, '/');
+  p = (p  ?  p+1  :  name);
+  if (strncmp(p, "dif", 3) != 0) return DIF_TBL_PIX;
+  if (p[3] == 'm') return DIF_TBL_TARGET;
+  if (p[3] == 'r') return DIF_TBL_RANGE;
+  return DIF_TBL_PIX;
+}
+
+
 
 
 
@@ -566,11 +1346,57 @@ int DIFgetHTMNeighbC1(DIF_Region &p);
 
 int DIFgetHTMsNeighb(char*& saved, char*& osaved, DIF_Region &p, int depth, unsigned long long int id, int odepth);
 int DIFgetHTMsNeighb1(DIF_Region &p);
+int DIFhtmCones(DIF_Region &p);
+int DIFhtmPolygon(DIF_Region &p);
+int DIFhtmShape(DIF_Region &p);
+
+// Append n IDs of an HTM intersection result list from the i-th one,
+// declared if the HTM headers are included
+#ifdef VARVEC_H
+inline void DIF_appendIds(vector<long long int>& list,
+                          const ValVec<uint64>& ids, size_t i, size_t n)
+{
+  if (n > 0)
+    list.insert(list.end(), &ids(i), &ids(i) + n);
+}
+#endif
+
+// Set algebra on ID lists sorted in ascending order, without duplicates;
+// out must be different from the input lists (see DIFsetops.cpp)
+void DIF_setUnion(const vector<long long int>& a,
+                  const vector<long long int>& b, vector<long long int>& out);
+void DIF_setIntersection(const vector<long long int>& a,
+                         const vector<long long int>& b,
+                         vector<long long int>& out);
+void DIF_setDifference(const vector<long long int>& a,
+                       const vector<long long int>& b,
+                       vector<long long int>& out);
+// IDs of a whose ancestor (ID >> shift) is not in b
+void DIF_setDropCovered(const vector<long long int>& a,
+                        const vector<long long int>& b, int shift,
+                        vector<long long int>& out);
+// Ancestors (ID >> shift) and descendants of the IDs of a
+void DIF_setParents(const vector<long long int>& a, int shift,
+                    vector<long long int>& out);
+void DIF_setChildren(const vector<long long int>& a, int shift,
+                     vector<long long int>& out);
+// Union, intersection and difference of ranges sets
+void DIF_rangeUnion(const DIF_Ranges& a, const DIF_Ranges& b,
+                    DIF_Ranges& out);
+void DIF_rangeIntersection(const DIF_Ranges& a, const DIF_Ranges& b,
+                           DIF_Ranges& out);
+void DIF_rangeDifference(const DIF_Ranges& a, const DIF_Ranges& b,
+                         DIF_Ranges& out);
 
 int getHTMnameById(char*& saved, unsigned long long int id, char *idname);
 int getHTMnameById1(unsigned long long int id, char *idname);
 int getHTMidByName(char*& saved, const char *idname, unsigned long long int* id);
 int getHTMid(char*& saved, int depth, double ra, double dec, unsigned long long int* id);
+int getHTMidBatch(const int* depths, int nd, long n, const double* ra,
+                  const double* dec, unsigned long long int* id);
+#ifdef _SpatialIndex_h
+const SpatialIndex* getHTMIndex(int depth);
+#endif
 
 void cleanHTMUval(char*& saved);
 void cleanHTMsUval(char*& saved, char*& osaved);
@@ -616,11 +1442,23 @@ double getHTMBaryDist1(int depth, unsigned long long int id,
 //HEALPix-related functions
 int DIFmyHealPRect4V(DIF_Region &p);
 int DIFmyHealPCone(DIF_Region &p);
+int DIFmyHealPCones(DIF_Region &p);
+int DIFmyHealPPolygon(DIF_Region &p);
+int DIFmyHealPMOC(DIF_Region &p);
+int DIFmyHealPShape(DIF_Region &p);
 
 int DIFgetHealPNeighbC(char*& saved, DIF_Region &p, double ra, double dec);
 int DIFgetHealPNeighbC1(DIF_Region &p);
 
 
+// Shared (read only) bases, declared if healpix_base.h is included
+#ifdef HEALPIX_BASE_H
+const T_Healpix_Base<int64>* getHealPBase(int nested, int order);
+#endif
+
+int getHealPidBatch(int nested, const int* orders, int nord, long n,
+                    const double* ra, const double* dec, long long int* id);
+
 int getHealPid(char*& saved, int nested, int order, double ra, double dec, long long int *id);
 void cleanHealPUval(char*& saved);
 
@@ -0,0 +1,486 @@
+/*
+  Rewrite a DIF indexed table physically ordered by pixel: coarse pixel ID,
+  then fine pixel ID, then RA, so that the rows of a pixel (and of nearby
+  pixels) are stored contiguously and region queries read few pages.
+  Use "dif_cluster -h" to see options. Normally run via "dif --cluster".
+
+  The table is streamed (mysql_use_result) and sorted by an external merge
+  sort: runs of at most "-m" MB are sorted in memory and written to binary
+  temporary files, which are then merged into a single "LOAD DATA" text
+  file. A copy of the table ("CREATE TABLE ... LIKE") is loaded from it and
+  swapped with the original one by an atomic "RENAME TABLE".
+
+  Note: the table must not be modified while it is clustered. Triggers stay
+  with the original table and are dropped with it, "dif --cluster" creates
+  them again.
+
+
+  LN @ INAF-OAS, Oct. 2026                          Last changed: 19/10/2026
+*/
+
+using namespace std;
+
+#include <cstdlib>
+#include <cstdio>
+#include <cerrno>
+#include <iostream>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <vector>
+
+// MySQL interface functions
+
+#include "my_stmt_db.h"
+
+// Progran name
+const char PROGNAME[] = "dif_cluster";
+
+// Version ID string
+static string VERID="Ver 1.0, 19-10-2026, LN@INAF-OAS";
+
+
+void
+usage() {
+
+  cout << PROGNAME << "  " << VERID << "\n" << endl
+       << "Usage:" << endl
+       << "  " << PROGNAME << " [OPTIONS] -d DBname -t Table -c Coarse -f Fine -r RA" << endl
+       << "Where OPTIONS are:\n" << endl
+       << "  -h: print this help" << endl
+       << "  -c Coarse: coarse pixel ID column (first sort key)" << endl
+       << "  -d DBname: database of the table" << endl
+       << "  -f Fine: fine pixel ID column (second sort key)" << endl
+       << "  -K: keep the original table as 'Table__difold'" << endl
+       << "  -m MB: memory to use for a sort run (def. 512)" << endl
+       << "  -p Password: MySQL user password is 'Password' (def. $MYSQL_PWD)" << endl
+       << "  -r RA: RA column or expression (third sort key)" << endl
+       << "  -s Server: send query to DB server 'Server' (def. localhost)" << endl
+       << "  -t Table: table to cluster" << endl
+       << "  -T Dir: directory for the temporary files (def. /tmp)" << endl
+       << "  -u User: MySQL user name is 'User' (def. root)" << endl
+       << endl;
+  exit(0);
+
+}
+
+
+// Sort key and position of a row in the run buffer. Rows with NULL IDs go
+// first, as in "ORDER BY"
+struct CL_Rec {
+  unsigned char null1, null2;
+  long long k1, k2;
+  double ra;
+  size_t off, len;
+};
+
+static bool cl_less(const CL_Rec &a, const CL_Rec &b)
+{
+  if (a.null1 != b.null1) return a.null1 > b.null1;
+  if (a.k1 != b.k1) return a.k1 < b.k1;
+  if (a.null2 != b.null2) return a.null2 > b.null2;
+  if (a.k2 != b.k2) return a.k2 < b.k2;
+  return a.ra < b.ra;
+}
+
+
+// A sorted run on disk and its current record
+struct CL_Run {
+  FILE *fp;
+  CL_Rec rec;
+  string line;
+};
+
+static bool cl_read(CL_Run &r)
+{
+  if (fread(&r.rec, sizeof(CL_Rec), 1, r.fp) != 1)
+    return false;
+  r.line.resize(r.rec.len);
+  if (r.rec.len  &&  fread(&r.line[0], 1, r.rec.len, r.fp) != r.rec.len)
+    return false;
+  return true;
+}
+
+struct CL_RunGreater {
+  vector<CL_Run> *runs;
+  bool operator()(int a, int b) const {
+    return cl_less((*runs)[b].rec, (*runs)[a].rec);
+  }
+};
+
+
+// Append a field escaped as expected by "LOAD DATA" (default ESCAPED BY)
+static void cl_escape(string &buf, const char *s, unsigned long len)
+{
+  if (! s) {
+    buf += "\\N";
+    return;
+  }
+  for (unsigned long i = 0; i < len; i++)
+    switch (s[i]) {
+      case '\\': buf += "\\\\"; break;
+      case '\t': buf += "\\t";  break;
+      case '\n': buf += "\\n";  break;
+      case '\r': buf += "\\r";  break;
+      case '\0': buf += "\\0";  break;
+      default:   buf += s[i];
+    }
+}
+
+
+static string cl_tmpfile(const string &dir, FILE **fp)
+{
+  string tmpl = dir + "/difcluXXXXXX";
+  vector<char> name(tmpl.begin(), tmpl.end());
+  name.push_back('\0');
+
+  int fd = mkstemp(&name[0]);
+  *fp = (fd < 0 ? NULL : fdopen(fd, "w+b"));
+  return string(&name[0]);
+}
+
+
+// Sort the buffered rows and write them to a new run file
+static int cl_flush(vector<CL_Rec> &recs, string &arena, const string &dir,
+                    vector<CL_Run> &runs, vector<string> &files)
+{
+  CL_Run r;
+  string fname = cl_tmpfile(dir, &r.fp);
+  if (! r.fp) {
+    cout << "Can't create temporary file in " << dir << ": "
+         << strerror(errno) << endl;
+    return -1;
+  }
+  files.push_back(fname);
+
+  sort(recs.begin(), recs.end(), cl_less);
+  for (size_t i = 0; i < recs.size(); i++) {
+    fwrite(&recs[i], sizeof(CL_Rec), 1, r.fp);
+    fwrite(arena.data() + recs[i].off, 1, recs[i].len, r.fp);
+  }
+  if (fflush(r.fp)) {
+    cout << "Error writing " << fname << ": " << strerror(errno) << endl;
+    fclose(r.fp);
+    return -1;
+  }
+  rewind(r.fp);
+  runs.push_back(r);
+
+  recs.clear();
+  arena.clear();
+  return 0;
+}
+
+
+static int cl_query(const string &q)
+{
+  if (! db_query(0, q.c_str())) {
+    cout << "DB error: " << db_error(0) << endl << "Query: " << q << endl;
+    return -1;
+  }
+  if (db_return_row(0))
+    db_free_result(0);
+  return 0;
+}
+
+
+static void cl_cleanup(vector<CL_Run> &runs, vector<string> &files)
+{
+  for (size_t i = 0; i < runs.size(); i++)
+    if (runs[i].fp) fclose(runs[i].fp);
+  for (size_t i = 0; i < files.size(); i++)
+    unlink(files[i].c_str());
+}
+
+
+int
+main(int argc, char *argv[]){
+  unsigned short kwds=0;
+  char c;
+
+  int ret, keep = 0;
+  long mem_mb = 512;
+  string ans, query, tmpdir = "/tmp";
+  char my_db[65]="", my_tab[65]="", my_user[33]="", my_passw[65]="",
+       my_host[65]="", my_coarse[65]="", my_fine[65]="", my_ra[256]="",
+       hostn[65]="localhost", usern[33]="root";
+
+
+/* Keywords section */
+  while (--argc > 0 && (*++argv)[0] == '-')
+  {
+    kwds=1;
+    while (kwds && (c = *++argv[0]))
+    {
+      switch (c)
+      {
+        case 'h':
+          usage();
+          break;
+        case 'c':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_coarse);
+          --argc;
+          kwds=0;
+          break;
+        case 'd':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_db);
+          --argc;
+          kwds=0;
+          break;
+        case 'f':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_fine);
+          --argc;
+          kwds=0;
+          break;
+        case 'K':
+          keep = 1;
+          kwds=0;
+          break;
+        case 'm':
+          if (argc < 2) usage();
+          mem_mb = atol(*++argv);
+          --argc;
+          kwds=0;
+          break;
+        case 'p':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_passw);
+          --argc;
+          kwds=0;
+          break;
+        case 'r':
+          if (argc < 2) usage();
+          strncpy(my_ra, *++argv, 255);
+          --argc;
+          kwds=0;
+          break;
+        case 's':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_host);
+          --argc;
+          kwds=0;
+          break;
+        case 't':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%64s",my_tab);
+          --argc;
+          kwds=0;
+          break;
+        case 'T':
+          if (argc < 2) usage();
+          tmpdir = *++argv;
+          --argc;
+          kwds=0;
+          break;
+        case 'u':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%32s",my_user);
+          --argc;
+          kwds=0;
+          break;
+        default:
+          fprintf (stderr,"Illegal option `%c'.\n\n",c);
+          usage();
+      }
+    }
+  }
+
+  if (! my_db[0]  ||  ! my_tab[0]  ||  ! my_coarse[0]  ||  ! my_fine[0]  ||
+      ! my_ra[0])
+    usage();
+
+  if (my_host[0] != '\0')
+    strcpy(hostn,my_host);
+
+  if (my_user[0] != '\0')
+    strcpy(usern,my_user);
+
+  if (mem_mb < 1) mem_mb = 1;
+  size_t mem_max = (size_t) mem_mb << 20;
+
+  string tab  = string(my_db) + "." + my_tab;
+  string ntab = string(my_db) + "." + my_tab + "__difclu";
+  string otab = string(my_db) + "." + my_tab + "__difold";
+
+
+  if (my_passw[0] == '\0') {
+    if (getenv("MYSQL_PWD"))
+      strncpy(my_passw, getenv("MYSQL_PWD"), 64);
+    else {
+      cout << "Enter " << usern << " password: ";
+      getline(cin, ans);
+      strncpy(my_passw, ans.c_str(), 64);
+    }
+  }
+
+
+/* Connect to the DB */
+  ret = db_init(0);
+  if (!ret)
+  {
+    cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
+    return(1);
+  }
+  if (!db_local_infile(0))
+    cout << "Can't enable LOCAL INFILE for MySQL connection." << endl;
+
+  ret = db_connect(0, hostn, usern, my_passw, my_db);
+
+  if (!ret) {
+    cout << "DB error: " << db_error(0) << endl;
+    return(1);
+  }
+
+
+// Read phase: stream the rows, sort runs of mem_max bytes
+  vector<CL_Rec> recs;
+  vector<CL_Run> runs;
+  vector<string> files;
+  string arena;
+  unsigned long long nrows = 0;
+
+  query = string("SELECT ") + my_coarse + ", " + my_fine + ", (" + my_ra +
+          "), t.* FROM " + tab + " AS t";
+  cout << "Reading table " << tab << " ..." << endl;
+  if (! db_uquery(0, query.c_str())  ||  ! db_return_row(0)) {
+    cout << "DB error: " << db_error(0) << endl << "Query: " << query << endl;
+    return(1);
+  }
+
+  unsigned int nf = db_num_fields(0);
+  char **row;
+  unsigned long *len;
+
+  while ((row = db_next_row(0, &len))) {
+    CL_Rec r;
+    r.null1 = (row[0] == NULL);
+    r.null2 = (row[1] == NULL);
+    r.k1 = (row[0] ? strtoll(row[0], NULL, 10) : 0);
+    r.k2 = (row[1] ? strtoll(row[1], NULL, 10) : 0);
+    r.ra = (row[2] ? strtod(row[2], NULL) : 0.);
+    r.off = arena.size();
+
+    for (unsigned int i = 3; i < nf; i++) {
+      if (i > 3) arena += '\t';
+      cl_escape(arena, row[i], len[i]);
+    }
+    arena += '\n';
+    r.len = arena.size() - r.off;
+    recs.push_back(r);
+    nrows++;
+
+    if (arena.size() + recs.size()*sizeof(CL_Rec) >= mem_max)
+      if (cl_flush(recs, arena, tmpdir, runs, files)) {
+        db_free_result(0);
+        cl_cleanup(runs, files);
+        return(1);
+      }
+  }
+  if (*db_error(0)) {
+    cout << "DB error: " << db_error(0) << endl;
+    db_free_result(0);
+    cl_cleanup(runs, files);
+    return(1);
+  }
+  db_free_result(0);
+
+  if (runs.size()  &&  recs.size())
+    if (cl_flush(recs, arena, tmpdir, runs, files)) {
+      cl_cleanup(runs, files);
+      return(1);
+    }
+  cout << nrows << " rows read, " << (runs.size() ? runs.size() : 1)
+       << " sorted run(s)." << endl;
+
+
+// Merge phase: write the rows in order to the "LOAD DATA" file
+  FILE *out;
+  string outname = cl_tmpfile(tmpdir, &out);
+  if (! out) {
+    cout << "Can't create temporary file in " << tmpdir << ": "
+         << strerror(errno) << endl;
+    cl_cleanup(runs, files);
+    return(1);
+  }
+  files.push_back(outname);
+
+  if (runs.size() == 0) {   // all the rows fit in memory
+    sort(recs.begin(), recs.end(), cl_less);
+    for (size_t i = 0; i < recs.size(); i++)
+      fwrite(arena.data() + recs[i].off, 1, recs[i].len, out);
+    vector<CL_Rec>().swap(recs);
+    string().swap(arena);
+  }
+  else {
+    CL_RunGreater gt;
+    gt.runs = &runs;
+    priority_queue<int, vector<int>, CL_RunGreater> pq(gt);
+
+    for (size_t i = 0; i < runs.size(); i++)
+      if (cl_read(runs[i]))
+        pq.push(i);
+
+    while (! pq.empty()) {
+      int i = pq.top();
+      pq.pop();
+      fwrite(runs[i].line.data(), 1, runs[i].line.size(), out);
+      if (cl_read(runs[i]))
+        pq.push(i);
+    }
+  }
+
+  if (fclose(out)) {
+    cout << "Error writing " << outname << ": " << strerror(errno) << endl;
+    cl_cleanup(runs, files);
+    return(1);
+  }
+
+
+// Load phase: fill a copy of the table, check it and swap
+  cout << "Loading " << ntab << " ..." << endl;
+  ret = 1;
+  if (! cl_query("DROP TABLE IF EXISTS " + ntab)  &&
+      ! cl_query("CREATE TABLE " + ntab + " LIKE " + tab)  &&
+      ! cl_query("SET unique_checks=0, foreign_key_checks=0")  &&
+      ! cl_query("ALTER TABLE " + ntab + " DISABLE KEYS")  &&
+      ! cl_query("LOAD DATA LOCAL INFILE '" + outname + "' INTO TABLE " +
+                 ntab + " CHARACTER SET binary")  &&
+      ! cl_query("ALTER TABLE " + ntab + " ENABLE KEYS")) {
+
+    query = "SELECT COUNT(*) FROM " + ntab;
+    if (db_query(0, query.c_str())  &&  db_return_row(0)) {
+      unsigned long long nload = strtoull(db_data(0, 0, 0), NULL, 10);
+      db_free_result(0);
+
+      if (nload != nrows)
+        cout << "Loaded " << nload << " rows instead of " << nrows
+             << ": table " << tab << " left unchanged." << endl;
+      else if (! cl_query("DROP TABLE IF EXISTS " + otab)  &&
+               ! cl_query("RENAME TABLE " + tab + " TO " + otab + ", " +
+                          ntab + " TO " + tab)) {
+        ret = 0;
+        if (! keep)
+          cl_query("DROP TABLE " + otab);
+      }
+    }
+    else
+      cout << "DB error: " << db_error(0) << endl;
+  }
+
+  if (ret)
+    cl_query("DROP TABLE IF EXISTS " + ntab);
+  else
+    cout << "Table " << tab << " clustered by " << my_coarse << ", "
+         << my_fine << ", " << my_ra << "." << endl;
+
+  cl_cleanup(runs, files);
+  db_close(0);
+
+  return(ret);
+}
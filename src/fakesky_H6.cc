@@ -3,7 +3,7 @@
   Use "fakesky_H6 -h" to see options.
 
 
-  LN @ INAF-OAS March 2009                         Last changed: 17/11/2018
+  LN @ INAF-OAS March 2009                         Last changed: 19/10/2026
 */
 
 #include <iostream>
@@ -21,12 +21,13 @@ int getHTMid(char*& saved, int depth, double ra, double dec,
              unsigned long long int *id);
 int getHTMBary1(int depth, unsigned long long int id,
                 double *bc_ra, double *bc_dec);
+void cleanHTMUval(char*& saved);
 
 // Progran name
 const char PROGNAME[] = "fakesky_H6";
 
 // Version ID string
-static string VERID="Ver 1.0b, 25-10-2015, LN@IASF-INAF";
+static string VERID="Ver 1.1, 19-10-2026, LN@INAF-OAS";
 
 /* degrees to milli-arcsec */
 static double DEG2MAS = 3.6E6;
@@ -42,6 +43,10 @@ static const double ARCSEC_RAD = 4.848136811095359935899141;
 
 #include <my_stmt_db.h>
 
+// Counter based RNG, parallel blocks and bulk output
+
+#include "fakesky_utils.hh"
+
 // --
 
 
@@ -53,31 +58,100 @@ usage() {
        << PROGNAME << " [OPTIONS]" << endl
        << "Where OPTIONS are:\n" << endl
        << "  -h: print this help" << endl
+       << "  -b File: write binary records to 'File' instead of the DB" << endl
        << "  -D Dens: Nr of objects per arcmin^2 will be 'Dens' (def. 0.1)" << endl
        << "  -d DBnane: use 'DBnane' as MySQL databse name (def. TEST)" << endl
+       << "  -f File: write tab separated text to 'File' instead of the DB" << endl
+       << "  -I d1,d2,..: add htmID_d1, htmID_d2,... columns (depths 0-25)" << endl
+       << "  -j Nthr: use 'Nthr' threads (def. Nr of CPUs)" << endl
        << "  -p Password: MySQL user password is 'Password'" << endl
+       << "  -S Seed: random generator seed (def. 284537612)" << endl
        << "  -s Server: send query to DB server 'Server' (def. localhost)" << endl
        << "  -t Table: produced table name will be 'Table' (def. fakeskyH6)" << endl
        << "  -u User: MySQL user name is 'User' (def. root)" << endl
+       << "  -y: do not ask for confirmation" << endl
+       << "\nThe output only depends on 'Dens' and 'Seed', not on 'Nthr'." << endl
        << endl;
   exit(0);
 
 }
 
 
+// Generation parameters shared by all threads
+struct H6_Gen {
+  int depth, dmax, nid;
+  unsigned long long npix, seed;
+  long long n_epp;
+  vector<int> depths;           // depth of each ID column
+  vector<double> bc_ra, bc_dec; // trixel barycenters (getHTMBary not MT-safe)
+  vector<char*> saved;          // per thread SpatialIndex at depth 'dmax'
+  FS_Format fmt;
+};
+
+
+// Random entries in the trixel 'blk' (relative to the first at 'depth')
+unsigned long long
+gen_trixel(unsigned long long blk, string &buf, int thr, void *arg)
+{
+  H6_Gen *g = (H6_Gen*) arg;
+  unsigned long long id = g->npix + blk, cur_id, ids[FS_MAXID], n_in = 0;
+  long long int one = 1, i;
+  double bc_ra, bc_dec, phi, lat, x, y;
+  long int RAmas, DECmas;
+
+  FS_Rng rng(g->seed, id);
+
+  bc_ra = g->bc_ra[blk];
+  bc_dec = g->bc_dec[blk];
+  double lat_fac = 1./cos(bc_dec/RAD2DEG);
+  double max_rad2 = 1.7 * M_PI/2. * M_PI/(one << (g->depth+1)) * RAD2DEG;
+  double max_rad = max_rad2 / 2.;
+  double max_rad2_ra = max_rad2 * lat_fac;
+  double max_rad_ra = max_rad * lat_fac;
+
+// Loop on events/trixel
+  for (i=0; i< g->n_epp; i++) {
+    x = rng.uni();
+    y = rng.uni();
+    if (sqrt (x*x + y*y) <= 1.) {
+      lat = bc_dec - max_rad + max_rad2 *  x;
+      phi = bc_ra  - max_rad_ra + max_rad2_ra * y;
+
+      if ((phi >= 0.) && (phi < 360.) && (lat > -90.) && lat < 90.) {
+
+// Deepest ID only, coarser ones by shifting
+        getHTMid(g->saved[thr], g->dmax, phi, lat, &cur_id);
+
+        if ((cur_id >> 2*(g->dmax - g->depth)) == id) {
+          RAmas  = (long int)(phi*DEG2MAS);
+          DECmas = (long int)(lat*DEG2MAS);
+          for (int k = 0; k < g->nid; k++)
+            ids[k] = cur_id >> 2*(g->dmax - g->depths[k]);
+          fs_put(buf, g->fmt, RAmas, DECmas, phi, lat, ids, g->nid);
+          n_in++;
+        }
+      }
+    }
+  }
+
+  return n_in;
+}
+
+
 int
 main(int argc, char *argv[]){
   unsigned short kwds=0;
   char c;
 
-  int ret;
-  string ans;
-  char ins_comm[400];
+  int ret, nthr = fs_ncpu(), ask = 1;
+  string ans, ins_comm;
   double dens=0.1;
   char my_db[33]="", my_tab[33]="", my_user[33]="", my_passw[33]="",
-       my_host[33]="",
+       my_host[33]="", my_depths[100]="", out_file[256]="",
        hostn[33]="localhost", dbname[33]="test", tablen[33]="fakeskyH6",
        usern[33]="root";
+  FS_Format fmt = FS_OUT_DB;
+  unsigned long long seed = 284537612;
 
 
 /* Keywords section */
@@ -91,6 +165,13 @@ main(int argc, char *argv[]){
         case 'h':
           usage();
           break;
+        case 'b':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_BIN;
+          --argc;
+          kwds=0;
+          break;
         case 'D':
           if (argc < 2) usage();
           dens = atof(*++argv);
@@ -103,12 +184,37 @@ main(int argc, char *argv[]){
           --argc;
           kwds=0;
           break;
+        case 'f':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_TXT;
+          --argc;
+          kwds=0;
+          break;
+        case 'I':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%99s",my_depths);
+          --argc;
+          kwds=0;
+          break;
+        case 'j':
+          if (argc < 2) usage();
+          nthr = atoi(*++argv);
+          --argc;
+          kwds=0;
+          break;
         case 'p':
           if (argc < 2) usage();
           sscanf(*++argv,"%s",my_passw);
           --argc;
           kwds=0;
           break;
+        case 'S':
+          if (argc < 2) usage();
+          seed = strtoull(*++argv, NULL, 10);
+          --argc;
+          kwds=0;
+          break;
         case 's':
           if (argc < 2) usage();
           sscanf(*++argv,"%s",my_host);
@@ -127,6 +233,9 @@ main(int argc, char *argv[]){
           --argc;
           kwds=0;
           break;
+        case 'y':
+          ask = 0;
+          break;
         default:
           fprintf (stderr,"Illegal option `%c'.\n\n",c);
           usage();
@@ -146,164 +255,144 @@ main(int argc, char *argv[]){
   if (my_tab[0] != '\0')
     strcpy(tablen,my_tab);
 
+  if (nthr < 1) nthr = 1;
 
-// Density related parametrs
-  double sky_area = (4*M_PI) * (RAD2DEG * RAD2DEG);
-  long long int i, n_e, n_epp;
 
 // Depth 6 HTM grid
 // Mean area=2PI/4^(d+1), Min side = PI/2^(d+1), Max side -> Min_side * PI/2
-  int depth = 6;
-  long long int one = 1;
-  unsigned long long int id, cur_id, npix = ( one << (2*depth+3) );
-  double m_area = 2*M_PI/( one << (2*(depth+1)) ) * (RAD2DEG * RAD2DEG);
-
-  n_e = (long long int) (dens*3600. * sky_area);
-
-  cout << "There will be approx " << n_e << " entries in the table '"
-       << tablen << "'." << endl
-       << "<Return> to continue. ";
-  getline(cin, ans);
-
-  
-//  n_epp = 2000; //-> 5,850 million entries, 175 MB (with HTM6 and HEAL8)
-//                                           + 60 MB index (HEAL8)
-//  n_epp = 1000000;  //-> 2.9 billion entries, 85 GB () + 30 GB index (HEAL8)
-
-  n_epp = (long long int) (dens*3600. * m_area);
-
-// Must account for spread of circular region
-  n_epp *= 10;
-cout << "Nepp*10: " << n_epp << endl;
+  H6_Gen g;
+  g.depth = 6;
+  g.depths.push_back(g.depth);
 
-/* Connect to the DB */
-  ret = db_init(0);
-  if (!ret)
-  {
-    cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
+  vector<int> extra;
+  if (fs_parse_depths(my_depths, 0, 25, extra) < 0) {
+    cout << "Invalid depth list '" << my_depths << "'." << endl;
     return(1);
   }
-
-
-  if (my_passw[0] == '\0') {
-    cout << "Enter " << usern << " password: ";
-    getline(cin, ans);
-    strcpy(my_passw,ans.c_str());
+  g.dmax = g.depth;
+  for (size_t k = 0; k < extra.size(); k++) {
+    if (extra[k] == g.depth) continue;
+    g.depths.push_back(extra[k]);
+    if (extra[k] > g.dmax) g.dmax = extra[k];
   }
+  g.nid = g.depths.size();
 
-  ret = db_connect(0, hostn, usern, my_passw, dbname);
-
-  if (!ret) {
-    cout << "DB error: " << db_error(0);
-    return(1);
-  }
 
-// Create table in case it is not there: ignore error
-  strcpy(ins_comm, "CREATE TABLE ");
-  strcat(ins_comm, tablen);
-  strcat(ins_comm, " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0, htmID_6 smallint unsigned not null default 0)");
-  ret = db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl
-         << "... continue." << endl;
-  }
+// Density related parametrs
+  double sky_area = (4*M_PI) * (RAD2DEG * RAD2DEG);
+  long long int n_e;
+  long long int one = 1;
+  g.npix = ( one << (2*g.depth+3) );
+  double m_area = 2*M_PI/( one << (2*(g.depth+1)) ) * (RAD2DEG * RAD2DEG);
 
-  cout << "Table creation start time: ";
-  ret = system("date");
+  n_e = (long long int) (dens*3600. * sky_area);
 
-/* First lock the table */
-  strcpy(ins_comm, "LOCK TABLES ");
-  strcat(ins_comm, tablen);
-  strcat(ins_comm, " WRITE");
-  ret=db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
-    return(1);
+  cout << "There will be approx " << n_e << " entries in ";
+  if (fmt == FS_OUT_DB)
+    cout << "the table '" << tablen << "'." << endl;
+  else
+    cout << "the file '" << out_file << "'." << endl;
+  if (ask) {
+    cout << "<Return> to continue. ";
+    getline(cin, ans);
   }
 
 
+//  n_epp = 2000; //-> 5,850 million entries, 175 MB (with HTM6 and HEAL8)
+//                                           + 60 MB index (HEAL8)
+//  n_epp = 1000000;  //-> 2.9 billion entries, 85 GB () + 30 GB index (HEAL8)
 
-  double bc_ra, bc_dec, phi, lat;
-  long int RAmas, DECmas;
-  double max_rad2, max_rad, max_rad2_ra, max_rad_ra, lat_fac;
-
-  double d_rand_max = (double) RAND_MAX;
+  g.n_epp = (long long int) (dens*3600. * m_area);
 
-  double x, y;
+// Must account for spread of circular region
+  g.n_epp *= 10;
+cout << "Nepp*10: " << g.n_epp << endl;
 
-  char* saved = NULL;  // dummy for HTM id calc.
+  g.seed = seed;
+  g.fmt = (fmt == FS_OUT_BIN) ? FS_OUT_BIN : FS_OUT_TXT;
+  g.saved.assign(nthr, (char*) NULL);
 
-  cout << "Be patient while creating the catalogue..."<<endl;
+  g.bc_ra.resize(g.npix);
+  g.bc_dec.resize(g.npix);
+  for (unsigned long long k = 0; k < g.npix; k++)
+    getHTMBary1(g.depth, g.npix + k, &g.bc_ra[k], &g.bc_dec[k]);
 
-// Loop on trixels
-  for (id = npix; id < 2*npix; id++) {
-//  for (id = 2*npix-1; id >= npix; id--) {
-//  for (id = npix; id < (npix+100); id++) {
+  if (fmt == FS_OUT_DB) {
 
-/* Random No. generator init. */
-    srand(284537612 + id);  // Initialization: any large integer would be OK
+/* Connect to the DB */
+    ret = db_init(0);
+    if (!ret)
+    {
+      cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
+      return(1);
+    }
+    if (!db_local_infile(0))
+      cout << "Can't enable LOCAL INFILE for MySQL connection." << endl;
 
-    getHTMBary1(depth, id, &bc_ra, &bc_dec);
-//- cout << "ID: " << id << endl;
-//- cout << "Center RA, Dec: " << bc_ra <<"  "<< bc_dec << endl;
-    lat_fac = 1./cos(bc_dec/RAD2DEG);
-    max_rad2 = 1.7 * M_PI/2. * M_PI/(one << (depth+1)) * RAD2DEG;
-    max_rad = max_rad2 / 2.;
-    max_rad2_ra = max_rad2 * lat_fac;
-    max_rad_ra = max_rad * lat_fac;
 
-//- cout << "Lat fac.: " << lat_fac << "  Max radius used: " << max_rad << endl;
+    if (my_passw[0] == '\0') {
+      cout << "Enter " << usern << " password: ";
+      getline(cin, ans);
+      strcpy(my_passw,ans.c_str());
+    }
 
-    int n_in=0, n_out=0;
-// Loop on events/trixel
-    for (i=0; i< n_epp; i++) {
-/* Random Theta and Phi */
-//    lat = asin( (2* (double) rand() / (double) RAND_MAX - 1.) ) * RAD2DEG
-//    phi = (double) rand() / (double) RAND_MAX * 360.;
-
-      x = ( (double) rand() / d_rand_max );
-      y = ( (double) rand() / d_rand_max );
-      if (sqrt (x*x + y*y) <= 1.) {
-        lat = bc_dec - max_rad + max_rad2 *  x;
-        phi = bc_ra  - max_rad_ra + max_rad2_ra * y; 
-
-        if ((phi >= 0.) && (phi < 360.) && (lat > -90.) && lat < 90.) {
-          RAmas  = (long int)(phi*DEG2MAS);
-          DECmas = (long int)(lat*DEG2MAS);
+    ret = db_connect(0, hostn, usern, my_passw, dbname);
 
-          getHTMid(saved, depth, phi, lat, &cur_id);
+    if (!ret) {
+      cout << "DB error: " << db_error(0);
+      return(1);
+    }
 
-          if (cur_id == id) {
-            n_in++;
-            sprintf(ins_comm, "INSERT INTO %s VALUES (%ld, %ld, %lf, %lf, %lld)",
-                    tablen, RAmas, DECmas, phi, lat, cur_id);
-//cout << ins_comm << endl;
+// Create table in case it is not there: ignore error
+    ins_comm = "CREATE TABLE ";
+    ins_comm += tablen;
+    ins_comm += " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0";
+    for (int k = 0; k < g.nid; k++) {
+      ins_comm += ", htmID_" + to_string(g.depths[k]);
+      if (g.depths[k] <= 6)
+        ins_comm += " smallint unsigned not null default 0";
+      else if (g.depths[k] <= 14)
+        ins_comm += " int unsigned not null default 0";
+      else
+        ins_comm += " bigint unsigned not null default 0";
+    }
+    ins_comm += ")";
+    ret = db_query(0, ins_comm.c_str());
+    if (!ret) {
+      cout << "DB error: " << db_error(0) << endl
+           << "... continue." << endl;
+    }
+  }
 
-            ret = db_query(0, ins_comm);
-            if (!ret)
-              cout << "DB error: " << db_error(0) << endl;
+  FS_Output out;
+  if (! out.open(fmt, out_file, tablen)) {
+    cout << "Can't open output file." << endl;
+    return(1);
+  }
 
-          } else
-            n_out++;
+  cout << "Table creation start time: ";
+  ret = system("date");
 
-        }
-      }
-    }
+  cout << "Be patient while creating the catalogue (" << nthr
+       << " threads)..." << endl;
 
-//- cout << "N_objs IN: " << n_in  << "  N_objs OUT: " << n_out << endl;
+// Loop on trixels, 64 per thread and round
+  ret = fs_run(g.npix, nthr, 64, gen_trixel, &g, out);
+  ret = out.close() && ret;
 
-  }  // End loop on trixels
+  for (int t = 0; t < nthr; t++)
+    cleanHTMUval(g.saved[t]);
 
-  strcpy(ins_comm, "UNLOCK TABLES");
-  ret = db_query(0, ins_comm);
   if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
+    cout << "Error writing the catalogue." << endl;
     return(1);
   }
 
-  db_close(0);
+  if (fmt == FS_OUT_DB)
+    db_close(0);
 
 
+  cout << out.rows() << " entries written." << endl;
   cout << "Table creation end time: ";
   ret = system("date");
   cout << "done!" << endl;
@@ -4,7 +4,7 @@
   Use "fakesky_HPx -h" to see options.
 
 
-  LN @ IASF-INAF March 2009                         Last changed: 28/01/2023
+  LN @ IASF-INAF March 2009                         Last changed: 19/10/2026
 */
 
 using namespace std;
@@ -28,11 +28,14 @@ using namespace std;
 //int getHealPid(int nested, char*& saved, int k, double ra, double dec,
 //               long long int *id);
 
+// Shared (read only) HEALPix bases, see getHealPBase.cpp
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
+
 // Progran name
 const char PROGNAME[] = "fakesky_HPx";
 
 // Version ID string
-static string VERID="Ver 1.0b, 16-05-2016, LN@IASF-INAF";
+static string VERID="Ver 1.1, 19-10-2026, LN@INAF-OAS";
 
 /* degrees to centi-arcsec */
 static double DEG2MAS = 3.6E6;
@@ -48,6 +51,10 @@ static const double ARCSEC_RAD = 4.848136811095359935899141;
 
 #include "my_stmt_db.h"
 
+// Parallel blocks and bulk output
+
+#include "fakesky_utils.hh"
+
 // --
 
 
@@ -59,7 +66,11 @@ usage() {
        << "  " << PROGNAME << " [OPTIONS]" << endl
        << "Where OPTIONS are:\n" << endl
        << "  -h: print this help" << endl
+       << "  -b File: write binary records to 'File' instead of the DB" << endl
        << "  -d DBnane: use 'DBnane' as MySQL databse name (def. TEST)" << endl
+       << "  -f File: write tab separated text to 'File' instead of the DB" << endl
+       << "  -I o1,o2,..: add healpID_S_o1, ... columns (orders 0-Order)" << endl
+       << "  -j Nthr: use 'Nthr' threads (def. Nr of CPUs)" << endl
        << "  -o Order: HEALPix pixelization order to use is 'Order' (def. 10)" << endl
        << "  -p Password: MySQL user password is 'Password'" << endl
        << "  -s Server: send query to DB server 'Server' (def. localhost)" << endl
@@ -71,23 +82,71 @@ usage() {
 
 }
 
+// Generation parameters shared by all threads (HEALPix bases are read only)
+struct HPx_Gen {
+  int nested, nid;
+  long long nside_diff;
+  vector<int> orders;                       // order of each ID column
+  const T_Healpix_Base<int64>* base_mainp;        // RING, order 6
+  const T_Healpix_Base<int64>* base_finep;        // NEST, fine order
+  vector<const T_Healpix_Base<int64>*> base_ring; // RING, per column (if ! nested)
+  FS_Format fmt;
+};
+
+
+// Fine pixel centers within the RING main pixel 'blk'
+unsigned long long
+gen_mainpix(unsigned long long blk, string &buf, int thr, void *arg)
+{
+  HPx_Gen *g = (HPx_Gen*) arg;
+  unsigned long long ids[FS_MAXID];
+  long long int id, id_min, id_max;
+  double bc_ra, bc_dec, sth;
+  bool have_sth;
+  long int RAmas, DECmas;
+  int fine = g->orders[0];
+
+  id_min = g->base_mainp->ring2nest(blk) * g->nside_diff;
+  id_max = id_min + g->nside_diff - 1;
+
+// Loop on Fine pixels (nested)
+  for (id = id_min; id <= id_max; id++) {
+    g->base_finep->pix2loc(id, bc_dec, bc_ra, sth, have_sth);
+    bc_ra *= RAD2DEG;
+    have_sth ? bc_dec = 90. - atan2(sth,bc_dec)*RAD2DEG :
+               bc_dec = asin(bc_dec) * RAD2DEG;
+
+    RAmas  = (long int)(bc_ra*DEG2MAS);
+    DECmas = (long int)(bc_dec*DEG2MAS);
+
+// Coarser nested IDs by shifting
+    for (int k = 0; k < g->nid; k++) {
+      int64 idk = id >> 2*(fine - g->orders[k]);
+      ids[k] = g->nested ? idk : g->base_ring[k]->nest2ring(idk);
+    }
+    fs_put(buf, g->fmt, RAmas, DECmas, bc_ra, bc_dec, ids, g->nid);
+  }
+
+  return g->nside_diff;
+}
+
+
 int
 main(int argc, char *argv[]){
   unsigned short kwds=0;
   char c;
 
-  int ret;
-  string ans, fld_name;
-  char db_tabname[40], ins_comm[400];
+  int ret, nthr = fs_ncpu();
+  string ans, fld_name, ins_comm;
   char my_db[33]="", my_tab[33]="", my_user[33]="", my_passw[33]="",
-       my_host[33]="", my_order[3]="",
+       my_host[33]="", my_order[3]="", my_orders[100]="", out_file[256]="",
        hostn[33]="localhost", dbname[33]="TEST", tablen[33]="fakeskyHPx",
        usern[33]="root", order_s[3]="10";
+  FS_Format fmt = FS_OUT_DB;
 
   long long int nside_mainp, nside_finep, npix_main, npix_fine;
   int nested = 1, order_mainp = 6, order_finep;
-  T_Healpix_Base<int64>* base_mainp;
-  T_Healpix_Base<int64>* base_finep;
+  HPx_Gen g;
 
 
 //  if (argc < 2) usage();
@@ -103,9 +162,16 @@ main(int argc, char *argv[]){
         case 'h':
           usage();
           break;
+        case 'b':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_BIN;
+          --argc;
+          kwds=0;
+          break;
         case 'o':
           if (argc < 2) usage();
-          sscanf(*++argv,"%s",my_order);
+          sscanf(*++argv,"%2s",my_order);
           --argc;
           kwds=0;
           break;
@@ -115,6 +181,25 @@ main(int argc, char *argv[]){
           --argc;
           kwds=0;
           break;
+        case 'f':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_TXT;
+          --argc;
+          kwds=0;
+          break;
+        case 'I':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%99s",my_orders);
+          --argc;
+          kwds=0;
+          break;
+        case 'j':
+          if (argc < 2) usage();
+          nthr = atoi(*++argv);
+          --argc;
+          kwds=0;
+          break;
         case 'p':
           if (argc < 2) usage();
           sscanf(*++argv,"%s",my_passw);
@@ -169,157 +254,134 @@ main(int argc, char *argv[]){
     strcat(tablen,"R");
   strcat(tablen,order_s);
 
+  if (nthr < 1) nthr = 1;
+
   order_finep = atoi(order_s);
+  if (order_finep < order_mainp || order_finep > 29) {
+    cout << "Order must be in the range [" << order_mainp << ", 29]." << endl;
+    return(1);
+  }
+
+  g.orders.push_back(order_finep);
+  vector<int> extra;
+  if (fs_parse_depths(my_orders, 0, order_finep, extra) < 0) {
+    cout << "Invalid order list '" << my_orders << "'." << endl;
+    return(1);
+  }
+  for (size_t k = 0; k < extra.size(); k++)
+    if (extra[k] != order_finep) g.orders.push_back(extra[k]);
+  g.nid = g.orders.size();
 
   nside_mainp = 1 << order_mainp;
   npix_main = 12 * nside_mainp*nside_mainp;
-  nside_finep = 1 << order_finep;
+  nside_finep = 1LL << order_finep;
   npix_fine = 12 * nside_finep*nside_finep;
-  int nside_diff = 1 << 2*(order_finep - order_mainp);
+  long long nside_diff = 1LL << 2*(order_finep - order_mainp);
 
-  cout << "There will be " << npix_fine << " entries in the table '"
-       << tablen << "'." << endl
-       << "Aggregate pixel order is 6. Given input order " << order_finep
-       << " gives " << nside_diff << " entries per pix." << endl
-       << "<Return> to continue. ";
+  cout << "There will be " << npix_fine << " entries in ";
+  if (fmt == FS_OUT_DB)
+    cout << "the table '" << tablen << "'." << endl;
+  else
+    cout << "the file '" << out_file << "'." << endl;
+  cout << "Aggregate pixel order is 6. Given input order " << order_finep
+       << " gives " << nside_diff << " entries per pix." << endl;
+//       << "<Return> to continue. ";
 //  getline(cin, ans);
 
 
-  if (my_passw[0] == '\0') {
-    cout << "Enter " << usern << " password: ";
-    getline(cin, ans);
-    strcpy(my_passw,ans.c_str());
-  }
+  if (fmt == FS_OUT_DB) {
+    if (my_passw[0] == '\0') {
+      cout << "Enter " << usern << " password: ";
+      getline(cin, ans);
+      strcpy(my_passw,ans.c_str());
+    }
 
 
 /* Connect to the DB */
-  ret = db_init(0);
-  if (!ret)
-  {
-    cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
-    return(1);
-  }
+    ret = db_init(0);
+    if (!ret)
+    {
+      cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
+      return(1);
+    }
+    if (!db_local_infile(0))
+      cout << "Can't enable LOCAL INFILE for MySQL connection." << endl;
 
-  ret = db_connect(0, hostn, usern, my_passw, dbname);
+    ret = db_connect(0, hostn, usern, my_passw, dbname);
 
-  if (!ret) {
-    cout << "DB error: " << db_error(0);
-    return(1);
-  }
+    if (!ret) {
+      cout << "DB error: " << db_error(0);
+      return(1);
+    }
 
 // Create table in case it is not there: ignore error
-  fld_name = "healpID_";
-  if (nested)
-    fld_name += "1_";
-  else
-    fld_name += "0_";
-  fld_name += order_s;
-
-  strcpy(ins_comm, "CREATE TABLE ");
-  strcat(ins_comm, tablen);
-  strcat(ins_comm, " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0, ");
-  strcat(ins_comm, fld_name.c_str());
-
-  if (order_finep > 14)
-    strcat(ins_comm, " bigint unsigned not null default 0)");
-  else
-    strcat(ins_comm, " int unsigned not null default 0)");
+    ins_comm = "CREATE TABLE ";
+    ins_comm += tablen;
+    ins_comm += " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0";
+
+    for (int k = 0; k < g.nid; k++) {
+      fld_name = "healpID_";
+      if (nested)
+        fld_name += "1_";
+      else
+        fld_name += "0_";
+      fld_name += to_string(g.orders[k]);
+
+      ins_comm += ", " + fld_name;
+      if (g.orders[k] > 14)
+        ins_comm += " bigint unsigned not null default 0";
+      else
+        ins_comm += " int unsigned not null default 0";
+    }
+    ins_comm += ")";
 
-  ret = db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl
-         << "... continue." << endl;
+    ret = db_query(0, ins_comm.c_str());
+    if (!ret) {
+      cout << "DB error: " << db_error(0) << endl
+           << "... continue." << endl;
+    }
   }
 
-  ret = system("date");
-/* First lock the table */
-  strcpy(ins_comm, "LOCK TABLES ");
-  strcat(ins_comm, tablen);
-  strcat(ins_comm, " WRITE");
-  ret=db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
+  FS_Output out;
+  if (! out.open(fmt, out_file, tablen)) {
+    cout << "Can't open output file." << endl;
     return(1);
   }
 
+  ret = system("date");
 
-  base_mainp = new T_Healpix_Base<int64>(nside_mainp, RING, SET_NSIDE);
-
-  if (nested)
-    base_finep = new T_Healpix_Base<int64>(nside_finep, NEST, SET_NSIDE);
-  else
-    base_finep = new T_Healpix_Base<int64>(nside_finep, RING, SET_NSIDE);
-
-int64 startpix, ringpix;
-double costheta, sintheta;
-bool shifted;
-
-//base_mainp->get_ring_info(0, startpix, ringpix, costheta, sintheta, shifted);
-//cout << startpix << " " << ringpix << " " << costheta << " " << sintheta << endl;
-//
-//base_mainp->get_ring_info(1, startpix, ringpix, costheta, sintheta, shifted);
-//cout << startpix << " " << ringpix << " " << costheta << " " << sintheta << endl;
-
-//  double sky_area = (4*M_PI) * (RAD2DEG * RAD2DEG);
-  double bc_ra, bc_dec;
-  long int RAmas, DECmas;
+  g.nested = nested;
+  g.nside_diff = nside_diff;
+  g.fmt = (fmt == FS_OUT_BIN) ? FS_OUT_BIN : FS_OUT_TXT;
+  g.base_mainp = getHealPBase(0, order_mainp);
+  g.base_finep = getHealPBase(1, order_finep);
+  g.base_ring.assign(g.nid, (const T_Healpix_Base<int64>*) NULL);
+  if (! nested)
+    for (int k = 0; k < g.nid; k++)
+      g.base_ring[k] = getHealPBase(0, g.orders[k]);
 
-  long long int id, id_main, id_nest, id_min, id_max;
   double m_area = M_PI/(3.*nside_finep*nside_finep) * (RAD2DEG * RAD2DEG) * 3600; //arcmin^2
 
 cout << "Pixel area (arcmin^2): " << m_area << endl;
 
-  cout << "Be patient while creating the table '" << tablen << "'..."<<endl;
-
-// Loop on Main pixels (ring)
-  for (id_main = 0; id_main < npix_main; id_main++) {
-//  for (id_main = 0; id_main < 10; id_main++) {
-
-    
-    id_nest = base_mainp->ring2nest(id_main);
-
-    id_min = id_nest * nside_diff;
-    id_max = id_min + nside_diff - 1;
-
-// Loop on Fine pixels
-//  for (id = 0; id < npix_fine; id++) {
-  for (id = id_min; id <= id_max; id++) {
-
-    double sth;
-    bool have_sth;
-    base_finep->pix2loc(id, bc_dec, bc_ra, sth, have_sth);
-    bc_ra *= RAD2DEG;
-    have_sth ? bc_dec = 90. - atan2(sth,bc_dec)*RAD2DEG :
-               bc_dec = asin(bc_dec) * RAD2DEG;
-
-
-//- cout << "ID: " << id << endl;
-//- cout << "Center RA, Dec: " << bc_ra <<"  "<< bc_dec << endl;
-
-    RAmas  = (long int)(bc_ra*DEG2MAS);
-    DECmas = (long int)(bc_dec*DEG2MAS);
-
-      sprintf(ins_comm, "INSERT INTO %s VALUES (%ld, %ld, %lf, %lf, %lld)",
-              tablen, RAmas, DECmas, bc_ra, bc_dec, id);
-//cout << ins_comm << endl;
-
-      ret = db_query(0, ins_comm);
-      if (!ret)
-        cout << "DB error: " << db_error(0) << endl;
+  cout << "Be patient while creating the table '" << tablen << "' ("
+       << nthr << " threads)..." << endl;
 
-  }  // End loop on Fine pixels
-  }  // End loop on Main pixels
+// Loop on Main pixels (ring), at least ~64k entries per thread and round
+  unsigned long long per = 1 + (1 << 16) / nside_diff;
+  ret = fs_run(npix_main, nthr, per, gen_mainpix, &g, out);
+  ret = out.close() && ret;
 
-  strcpy(ins_comm, "UNLOCK TABLES");
-  ret = db_query(0, ins_comm);
   if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
+    cout << "Error writing the table." << endl;
     return(1);
   }
 
-  db_close(0);
+  if (fmt == FS_OUT_DB)
+    db_close(0);
 
 
+  cout << out.rows() << " entries written." << endl;
   ret = system("date");
   cout << "done!" << endl;
 
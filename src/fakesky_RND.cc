@@ -1,7 +1,7 @@
 /*
   Fake sky with fully random generated points.
 
-  LN @ INAF-OAS March 2009                         Last changed: 17/11/2018
+  LN @ INAF-OAS March 2009                         Last changed: 19/10/2026
 */
 
 #include <iostream>
@@ -17,12 +17,13 @@ using namespace std;
 
 int getHTMid(char*& saved, int depth, double ra, double dec,
              unsigned long long int *id);
+void cleanHTMUval(char*& saved);
 
 // Progran name
-//const char PROGNAME[] = "fakesky_RND";
+const char PROGNAME[] = "fakesky_RND";
 
 // Version ID string
-static string VERID="Ver 1.0, 22-04-2009, LN@IASF-INAF";
+static string VERID="Ver 1.1, 19-10-2026, LN@INAF-OAS";
 
 /* degrees to milli-arcsec */
 static double DEG2MAS = 3.6E6;
@@ -39,134 +40,249 @@ static const double ARCSEC_RAD = 4.848136811095359935899141;
 
 #include <my_stmt_db.h>
 
+// Counter based RNG, parallel blocks and bulk output
+
+#include "fakesky_utils.hh"
+
 // --
 
 void
-usage(char *name) {
+usage() {
 
-  cout << name << "  " << VERID << "\n" << endl
+  cout << PROGNAME << "  " << VERID << "\n" << endl
        << "Usage:" << endl
-       << name << " Sky_density (entries/arcmin^2) [ DB_table_name ]" << endl
+       << PROGNAME << " [OPTIONS] Sky_density (entries/arcmin^2) [ DB_table_name ]" << endl
+       << "Where OPTIONS are:\n" << endl
+       << "  -h: print this help" << endl
+       << "  -b File: write binary records to 'File' instead of the DB" << endl
+       << "  -f File: write tab separated text to 'File' instead of the DB" << endl
+       << "  -I d1,d2,..: add htmID_d1, htmID_d2,... columns (depths 0-25)" << endl
+       << "  -j Nthr: use 'Nthr' threads (def. Nr of CPUs)" << endl
+       << "  -S Seed: random generator seed (def. 184537612)" << endl
+       << "\nThe output only depends on 'Sky_density' and 'Seed', not on 'Nthr'." << endl
        << endl;
   exit(0);
 
 }
 
 
+// Entries are generated in blocks of RND_BLOCK, each with its own sequence
+static const long long int RND_BLOCK = 65536;
+
+// Generation parameters shared by all threads
+struct RND_Gen {
+  int dmax, nid;
+  long long n_e;
+  unsigned long long seed;
+  vector<int> depths;           // depth of each ID column
+  vector<char*> saved;          // per thread SpatialIndex at depth 'dmax'
+  FS_Format fmt;
+};
+
+
+unsigned long long
+gen_block(unsigned long long blk, string &buf, int thr, void *arg)
+{
+  RND_Gen *g = (RND_Gen*) arg;
+  unsigned long long cur_id, ids[FS_MAXID];
+  long long int i, i0 = blk * RND_BLOCK, n = RND_BLOCK;
+  double phi, lat;
+  long int RAmas, DECmas;
+
+  if (i0 + n > g->n_e) n = g->n_e - i0;
+  FS_Rng rng(g->seed, blk);
+
+  for (i=0; i<n; i++) {
+/* Random Theta and Phi */
+    lat = asin(2 * rng.uni() - 1.) * RAD2DEG; // -90, 90 deg
+    phi = rng.uni() * 360.; // 0-360 deg
+
+    RAmas  = (long int)(phi*DEG2MAS);
+    DECmas = (long int)(lat*DEG2MAS);
+
+// Deepest ID only, coarser ones by shifting
+    getHTMid(g->saved[thr], g->dmax, phi, lat, &cur_id);
+    for (int k = 0; k < g->nid; k++)
+      ids[k] = cur_id >> 2*(g->dmax - g->depths[k]);
+
+    fs_put(buf, g->fmt, RAmas, DECmas, phi, lat, ids, g->nid);
+  }
+
+  return n;
+}
+
+
 int
 main(int argc, char *argv[]){
+  unsigned short kwds=0;
+  char c;
   int narg = 1;                 // number of required arguments
-  int ret;
-  string password;
-  char db_tabname[40], ins_comm[200];
+  int ret, nthr = fs_ncpu();
+  string password, ins_comm;
+  char db_tabname[40], my_depths[100]="", out_file[256]="";
   double dens;
+  FS_Format fmt = FS_OUT_DB;
+  unsigned long long seed = 184537612;
+
+/* Keywords section */
+  while (--argc > 0 && (*++argv)[0] == '-')
+  {
+    kwds=1;
+    while (kwds && (c = *++argv[0]))
+    {
+      switch (c)
+      {
+        case 'h':
+          usage();
+          break;
+        case 'b':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_BIN;
+          --argc;
+          kwds=0;
+          break;
+        case 'f':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%255s",out_file);
+          fmt = FS_OUT_TXT;
+          --argc;
+          kwds=0;
+          break;
+        case 'I':
+          if (argc < 2) usage();
+          sscanf(*++argv,"%99s",my_depths);
+          --argc;
+          kwds=0;
+          break;
+        case 'j':
+          if (argc < 2) usage();
+          nthr = atoi(*++argv);
+          --argc;
+          kwds=0;
+          break;
+        case 'S':
+          if (argc < 2) usage();
+          seed = strtoull(*++argv, NULL, 10);
+          --argc;
+          kwds=0;
+          break;
+        default:
+          fprintf (stderr,"Illegal option `%c'.\n\n",c);
+          usage();
+      }
+    }
+  }
 
-  if (argc != narg+1) usage(argv[0]);
+  if (argc < narg || argc > narg+1) usage();
 
   char host[] = "localhost", user[] = "root", db[] = "test";
 
-  dens = atof(*++argv);
-
-/* Connect to the DB */
-  ret = db_init(0);
-  if (!ret)
-  {
-    cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
-    return(1);
-  }
+  dens = atof(*argv);
 
-  if (argc > 2)
+  if (argc > 1)
     strcpy(db_tabname,*++argv);
   else
     strcpy(db_tabname,"fakeskyRND");
 
+  if (nthr < 1) nthr = 1;
 
-  cout << "Enter root password: ";
-  getline(cin, password);
-//password="baff0lO";
-//password="R0zz02";
-
-  ret = db_connect(0, host, user, password.c_str(), db);
-
-  if (!ret) {
-    cout << "DB error: " << db_error(0);
+// Depth 6 HTM grid, plus optional columns
+  RND_Gen g;
+  g.depths.push_back(6);
+  vector<int> extra;
+  if (fs_parse_depths(my_depths, 0, 25, extra) < 0) {
+    cout << "Invalid depth list '" << my_depths << "'." << endl;
     return(1);
   }
+  g.dmax = 6;
+  for (size_t k = 0; k < extra.size(); k++) {
+    if (extra[k] == 6) continue;
+    g.depths.push_back(extra[k]);
+    if (extra[k] > g.dmax) g.dmax = extra[k];
+  }
+  g.nid = g.depths.size();
+
+  if (fmt == FS_OUT_DB) {
+
+/* Connect to the DB */
+    ret = db_init(0);
+    if (!ret)
+    {
+      cout << "Can't set CONNECT_TIMEOUT for MySQL connection." << endl;
+      return(1);
+    }
+    if (!db_local_infile(0))
+      cout << "Can't enable LOCAL INFILE for MySQL connection." << endl;
+
+
+    cout << "Enter root password: ";
+    getline(cin, password);
+
+    ret = db_connect(0, host, user, password.c_str(), db);
+
+    if (!ret) {
+      cout << "DB error: " << db_error(0);
+      return(1);
+    }
 
 // Create table in case it is not there: ignore error
-  strcpy(ins_comm, "CREATE TABLE ");
-  strcat(ins_comm, db_tabname);
-  strcat(ins_comm, " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0, htmID_6 smallint unsigned not null default 0)");
-  ret = db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl
-         << "... continue." << endl;
+    ins_comm = "CREATE TABLE ";
+    ins_comm += db_tabname;
+    ins_comm += " (RAmas int unsigned not null default 0, DECmas int not null default 0, RAdeg double not null default 0, DECdeg double not null default 0";
+    for (int k = 0; k < g.nid; k++) {
+      ins_comm += ", htmID_" + to_string(g.depths[k]);
+      if (g.depths[k] <= 6)
+        ins_comm += " smallint unsigned not null default 0";
+      else if (g.depths[k] <= 14)
+        ins_comm += " int unsigned not null default 0";
+      else
+        ins_comm += " bigint unsigned not null default 0";
+    }
+    ins_comm += ")";
+    ret = db_query(0, ins_comm.c_str());
+    if (!ret) {
+      cout << "DB error: " << db_error(0) << endl
+           << "... continue." << endl;
+    }
   }
 
-  ret = system("date");
-/* First lock the table */
-  strcpy(ins_comm, "LOCK TABLES ");
-  strcat(ins_comm, db_tabname);
-  strcat(ins_comm, " WRITE");
-  ret = db_query(0, ins_comm);
-  if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
+  FS_Output out;
+  if (! out.open(fmt, out_file, db_tabname)) {
+    cout << "Can't open output file." << endl;
     return(1);
   }
 
+  ret = system("date");
+
 
 // Use the RA=[0, 360], Dec=[-90, 90] range (could be parametrized)
   double sky_area = (4*M_PI) * (RAD2DEG * RAD2DEG);
-  double phi, lat;
-  long int RAmas, DECmas;
-  long long int i, n_e;
 
-  n_e = (long long int) (dens*3600. * sky_area);
-cout << "Sky area (deg^2): " << sky_area <<"  N_entries=" << n_e << endl;
+  g.n_e = (long long int) (dens*3600. * sky_area);
+cout << "Sky area (deg^2): " << sky_area <<"  N_entries=" << g.n_e << endl;
 
-// Depth 6 HTM grid
-  int depth = 6;
-  long long int one = 1;
-  unsigned long long int cur_id, npix = ( one << (2*depth+3) );
-  
-//  n_e = 500000000;
-/* Random No. generator init. */
-  srand(184537612);  // Initialization: any large integer would be OK
-//cout << RAND_MAX << endl;
-  double d_rand_max = (double) RAND_MAX + 1.;
+  g.seed = seed;
+  g.fmt = (fmt == FS_OUT_BIN) ? FS_OUT_BIN : FS_OUT_TXT;
+  g.saved.assign(nthr, (char*) NULL);
 
-  char* saved = NULL;  // dummy for HTM id calc.
+  cout << "Be patient while creating the catalogue (" << nthr
+       << " threads)..." << endl;
 
-  cout << "Be patient while creating the catalogue..."<<endl;
+  ret = fs_run((g.n_e + RND_BLOCK - 1) / RND_BLOCK, nthr, 1, gen_block, &g,
+               out);
+  ret = out.close() && ret;
 
-  for (i=0; i<n_e; i++) {
-/* Random Theta and Phi */
-    lat = asin(2 * (double) rand()/d_rand_max - 1.) * RAD2DEG; // -90, 90 deg
-    phi = (double) rand() / d_rand_max * 360.; // 0-360 deg
-
-    RAmas  = (long int)(phi*DEG2MAS);
-    DECmas = (long int)(lat*DEG2MAS);
-
-   getHTMid(saved, depth, phi, lat, &cur_id);
-
-    sprintf(ins_comm, "INSERT INTO %s VALUES (%ld, %ld, %lf, %lf, %lld)",
-        db_tabname, RAmas, DECmas, phi, lat, cur_id);
-//cout << ins_comm << endl;
-
-       ret = db_query(0, ins_comm);
-        if (!ret)
-          cout << "DB error: " << db_error(0) << endl;
-
-  }
+  for (int t = 0; t < nthr; t++)
+    cleanHTMUval(g.saved[t]);
 
-  strcpy(ins_comm, "UNLOCK TABLES");
-  ret = db_query(0, ins_comm);
   if (!ret) {
-    cout << "DB error: " << db_error(0) << endl;
+    cout << "Error writing the catalogue." << endl;
     return(1);
   }
 
-  db_close(0);
+  if (fmt == FS_OUT_DB)
+    db_close(0);
 
 
   ret = system("date");
@@ -0,0 +1,263 @@
+/*
+  Common tools for the fakesky_* programs:
+   - counter based random number generator: the sequence used for a pixel
+     (or block) only depends on the seed and on its ID, so the produced
+     catalogue is the same whatever the number of threads used;
+   - parallel generation of pixel blocks, written back in block order;
+   - bulk output: tab separated text file, binary file with fixed length
+     records, or direct load into MySQL via "LOAD DATA LOCAL INFILE".
+
+  Binary records are (native byte order):
+    int32 RAmas, int32 DECmas, float64 RAdeg, float64 DECdeg, uint64 ID[nid]
+
+
+  LN @ INAF-OAS, Oct. 2026                         Last changed: 19/10/2026
+*/
+
+#ifndef FAKESKY_UTILS_HH
+#define FAKESKY_UTILS_HH
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdint.h>
+
+#include "my_stmt_db.h"
+
+
+// Counter based RNG (splitmix64 finalizer applied to key + counter)
+class FS_Rng {
+  uint64_t key, ctr;
+
+public:
+  static uint64_t mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+  }
+
+  FS_Rng(uint64_t seed, uint64_t id)
+    : key(mix(seed + mix(id + 0x9E3779B97F4A7C15ULL))), ctr(0) {}
+
+  uint64_t next() { return mix(key + (++ctr) * 0x9E3779B97F4A7C15ULL); }
+
+// Uniform in [0, 1)
+  double uni() { return (next() >> 11) * (1. / 9007199254740992.); }
+};
+
+
+// Maximum number of IDs (depths/orders) of an entry
+#define FS_MAXID 32
+
+
+// Output formats
+enum FS_Format { FS_OUT_DB, FS_OUT_TXT, FS_OUT_BIN };
+
+
+// Append one entry to a buffer in the given format
+inline void fs_put(std::string &buf, FS_Format fmt, long ramas, long decmas,
+                   double ra, double dec, const unsigned long long *ids,
+                   int nid)
+{
+  if (fmt == FS_OUT_BIN) {
+    int32_t im[2] = { (int32_t) ramas, (int32_t) decmas };
+    double dv[2] = { ra, dec };
+    buf.append((const char*) im, sizeof(im));
+    buf.append((const char*) dv, sizeof(dv));
+    for (int i = 0; i < nid; i++) {
+      uint64_t u = ids[i];
+      buf.append((const char*) &u, sizeof(u));
+    }
+    return;
+  }
+
+// Up to 20 digits and a tab for each ID, one byte kept for the newline
+  char line[80 + 21*FS_MAXID];
+  int n = snprintf(line, sizeof(line) - 1, "%ld\t%ld\t%.9f\t%.9f",
+                   ramas, decmas, ra, dec);
+  for (int i = 0; i < nid  &&  n < (int) sizeof(line) - 1; i++)
+    n += snprintf(line + n, sizeof(line) - 1 - n, "\t%llu", ids[i]);
+  if (n > (int) sizeof(line) - 2)
+    n = sizeof(line) - 2;
+  line[n++] = '\n';
+  buf.append(line, n);
+}
+
+
+// Output sink. In FS_OUT_DB mode entries are collected in a temporary file
+// which is loaded into 'table' each time it exceeds 'chunk' bytes.
+class FS_Output {
+  FS_Format fmt;
+  std::string fname, table;
+  FILE *fp;
+  size_t nbytes, chunk;
+  unsigned long long nrows;
+
+  int load() {
+    if (fflush(fp) != 0) return 0;
+    std::string q = "LOAD DATA LOCAL INFILE '" + fname + "' INTO TABLE " +
+                    table;
+    if (! db_query(0, q.c_str())) {
+      fprintf(stderr, "DB error: %s\n", db_error(0));
+      return 0;
+    }
+    if (! (fp = freopen(fname.c_str(), "w", fp))) return 0;
+    nbytes = 0;
+    return 1;
+  }
+
+public:
+  FS_Output() : fmt(FS_OUT_DB), fp(NULL), nbytes(0), chunk(256 << 20),
+                nrows(0) {}
+
+// Open a file output, or the temporary file for "LOAD DATA" if the format
+// is FS_OUT_DB. Return 1 on success.
+  int open(FS_Format f, const char *file, const char *tab) {
+    fmt = f;
+    if (fmt == FS_OUT_DB) {
+      char tmpl[] = "/tmp/fakeskyXXXXXX";
+      int fd = mkstemp(tmpl);
+      if (fd < 0) return 0;
+      fname = tmpl;
+      table = tab;
+      fp = fdopen(fd, "w");
+    } else {
+      fname = file;
+      fp = fopen(file, (fmt == FS_OUT_BIN) ? "wb" : "w");
+    }
+    return fp != NULL;
+  }
+
+  FS_Format format() const { return fmt; }
+
+  unsigned long long rows() const { return nrows; }
+
+  int write(const std::string &buf, unsigned long long n) {
+    if (buf.size() && fwrite(buf.data(), 1, buf.size(), fp) != buf.size())
+      return 0;
+    nbytes += buf.size();
+    nrows += n;
+    if (fmt == FS_OUT_DB && nbytes >= chunk) return load();
+    return 1;
+  }
+
+// Flush pending entries and close. Return 1 on success.
+  int close() {
+    int ret = 1;
+    if (! fp) return 0;
+    if (fmt == FS_OUT_DB) {
+      if (nbytes) ret = load();
+      if (fp) fclose(fp);
+      unlink(fname.c_str());
+    } else
+      ret = (fclose(fp) == 0);
+    fp = NULL;
+    return ret;
+  }
+};
+
+
+// Block generator: fill 'buf' with entries of block 'blk', return their number.
+// 'thr' is the thread slot, to be used to index per thread (non shareable)
+// objects in 'arg'.
+typedef unsigned long long (*FS_GenFunc)(unsigned long long blk,
+                                         std::string &buf, int thr, void *arg);
+
+struct FS_Job {
+  FS_GenFunc gen;
+  void *arg;
+  int thr;
+  unsigned long long b0, b1;
+  std::vector<std::string> *bufs;
+  std::vector<unsigned long long> *nent;
+};
+
+inline void *fs_worker(void *p)
+{
+  FS_Job *j = (FS_Job*) p;
+  for (unsigned long long b = j->b0; b < j->b1; b++)
+    (*j->nent)[b - j->b0] = j->gen(b, (*j->bufs)[b - j->b0], j->thr, j->arg);
+  return NULL;
+}
+
+
+// Default number of threads: online CPUs
+inline int fs_ncpu()
+{
+  long n = sysconf(_SC_NPROCESSORS_ONLN);
+  return (n > 0) ? (int) n : 1;
+}
+
+
+// Generate blocks [0, nblk) with 'nthr' threads. Blocks are processed in
+// rounds of 'nthr' x 'per' consecutive blocks and written in block order.
+// Return 1 on success.
+inline int fs_run(unsigned long long nblk, int nthr, unsigned long long per,
+                  FS_GenFunc gen, void *arg, FS_Output &out)
+{
+  if (nthr < 1) nthr = 1;
+  if (per < 1) per = 1;
+
+  std::vector<FS_Job> jobs(nthr);
+  std::vector< std::vector<std::string> > bufs(nthr,
+                                             std::vector<std::string>(per));
+  std::vector< std::vector<unsigned long long> > nent(nthr,
+                                    std::vector<unsigned long long>(per));
+  std::vector<pthread_t> tid(nthr);
+  std::vector<int> started(nthr);
+
+  for (unsigned long long r0 = 0; r0 < nblk; r0 += nthr * per) {
+    int t;
+    for (t = 0; t < nthr; t++) {
+      unsigned long long b0 = r0 + t * per;
+      if (b0 >= nblk) break;
+      FS_Job &j = jobs[t];
+      j.gen = gen; j.arg = arg; j.thr = t;
+      j.b0 = b0;
+      j.b1 = (b0 + per < nblk) ? b0 + per : nblk;
+      j.bufs = &bufs[t];
+      j.nent = &nent[t];
+      for (unsigned long long k = 0; k < per; k++) bufs[t][k].clear();
+      started[t] = (nthr > 1 &&
+                    pthread_create(&tid[t], NULL, fs_worker, &j) == 0);
+      if (! started[t]) fs_worker(&j);
+    }
+    for (int k = 0; k < t; k++)
+      if (started[k]) pthread_join(tid[k], NULL);
+
+    for (int k = 0; k < t; k++)
+      for (unsigned long long b = 0; b < jobs[k].b1 - jobs[k].b0; b++)
+        if (! out.write(bufs[k][b], nent[k][b])) return 0;
+  }
+
+  return 1;
+}
+
+
+// Parse a comma separated list of distinct depths/orders in [lo, hi], at
+// most FS_MAXID-1 (the main one is added by the caller). Return the
+// number of values, -1 on error.
+inline int fs_parse_depths(const char *s, int lo, int hi, std::vector<int> &d)
+{
+  char *end;
+  d.clear();
+  while (*s) {
+    long v = strtol(s, &end, 10);
+    if (end == s || v < lo || v > hi) return -1;
+    if (std::find(d.begin(), d.end(), (int) v) != d.end()  ||
+        d.size() >= FS_MAXID - 1)
+      return -1;
+    d.push_back((int) v);
+    s = end;
+    if (*s == ',') s++;
+    else if (*s) return -1;
+  }
+  return (int) d.size();
+}
+
+#endif
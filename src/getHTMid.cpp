@@ -1,10 +1,16 @@
 /*
-  Name:  int getHTMid, int getHTMid1
+  Name:  int getHTMid, int getHTMid1, getHTMIndex, getHTMidBatch
 
   Purpose:
    Return the HTM ID for a given depth mesh.
    getHTMid1 always creates a new SpatialIndex class instance and destroys
    it on exit.
+   getHTMIndex returns the shared (read only) SpatialIndex of a depth: the
+   26 indexes are built only once (on first use, thread safe) and never
+   destroyed.
+   getHTMidBatch returns the IDs of arrays of coordinates at one or more
+   depths: the ID at the deepest one is evaluated and the coarser ones are
+   obtained by shifting it.
 
   Parameters:
  ( (i) char*& saved: if not NULL then re-use existing SpatialIndex )
@@ -14,13 +20,23 @@
 
    (o) unsigned long long int *id: HTM id
 
+  Parameters (getHTMidBatch):
+   (i) const int* depths: Pixelization depths, in the range [0, 25]
+   (i) int nd:            Number of depths
+   (i) long n:            Number of positions
+   (i) const double* ra:  Right Ascension (degrees)
+   (i) const double* dec: Declination (degrees)
+
+   (o) unsigned long long int* id: HTM IDs, id[i*nd + j] is that of the
+                                   i-th position at depth depths[j]
+
   Note:
     Check for depth in the range [0, 25].
 
   Return 0 on success.
 
 
-  LN @ INAF-OAS, Jan 2003                        Last change: 17/11/2018
+  LN @ INAF-OAS, Jan 2003                        Last change: 19/10/2026
 */
 
 #include <iostream>
@@ -28,6 +44,9 @@ using namespace std;
 
 #include "SpatialInterface.h"
 
+/* Maximum HTM depth */
+static const int HTM_MAX_DEPTH = 25;
+
 
 int getHTMid(char*& saved, int depth, double ra, double dec,
              unsigned long long int *id)
@@ -74,3 +93,64 @@ int getHTMid1(int depth, double ra, double dec, unsigned long long int *id)
   cleanHTMUval(saved);
   return ret;
 }
+
+
+
+// Indexes of all the depths
+struct HTMIndexTable {
+  SpatialIndex* index[HTM_MAX_DEPTH+1];
+
+  HTMIndexTable() {
+    for (int d=0; d<=HTM_MAX_DEPTH; d++)
+      index[d] = new SpatialIndex(d);
+  }
+};
+
+
+const SpatialIndex* getHTMIndex(int depth)
+{
+  static const HTMIndexTable table;
+
+  if ((depth < 0) || (depth > HTM_MAX_DEPTH))
+    return NULL;
+
+  return table.index[depth];
+}
+
+
+
+int getHTMidBatch(const int* depths, int nd, long n, const double* ra,
+                  const double* dec, unsigned long long int* id)
+{
+  int j, deep = 0;
+  long i;
+
+  for (j=0; j<nd; j++) {
+    if ((depths[j] < 0) || (depths[j] > HTM_MAX_DEPTH))
+      return -1;
+    if (depths[j] > deep)
+      deep = depths[j];
+  }
+
+  const SpatialIndex* index = getHTMIndex(deep);
+  int ret = 0;
+
+  for (i=0; i<n; i++) {
+    unsigned long long int idd, *out = id + i*nd;
+
+    try {
+      idd = index->idByPoint(ra[i], dec[i]);
+    } catch (SpatialException &x) {
+#ifdef DEBUG_PRINT
+      cerr << "Error: " << x.what() << endl;
+#endif
+      idd = 0;
+      ret = -1;
+    }
+
+    for (j=0; j<nd; j++)
+      out[j] = idd >> 2*(deep - depths[j]);
+  }
+
+  return ret;
+}
@@ -4,11 +4,11 @@
   Description:
    Return the HEALPix pixel barycentre (center) coordinates given scheme
    (RING or NESTED), order and spherical coordinates.
-   getHealPBaryC1 always creates a new Healpix_Base base and destroys
-   it on exit.
+   The shared (read only) base of the given scheme and order is used
+   (see getHealPBase), no base is allocated.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base2 )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) int nested: Scheme ID; if 0 then RING else NESTED
    (i) int k:      Resolution order in the range [0, 29]
    (i) double ra:  Right Ascension (degrees)
@@ -24,7 +24,7 @@
   Return 0 on success.
 
 
-  LN@IASF-INAF, September 2008                      Last change: 04/08/2016
+  LN@IASF-INAF, September 2008                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -37,6 +37,7 @@ static const double DEG2RAD = 1.74532925199432957692369E-2;
 static const double RAD2DEG = 57.2957795130823208767981548;
 
 void cleanHealPUval(char*& saved);
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
 
 using namespace std;
 
@@ -44,25 +45,15 @@ using namespace std;
 int getHealPBaryC(char*& saved, int nested, int k, double ra, double dec,
                   double *bc_ra, double *bc_dec)
 {
-  long long int my_nside;
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
   if (! saved) {
 
     if ((k < 0) || (k > 29))
       return -1;
-
-    my_nside = 1 << k;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
   long long int id;
   double theta = (90. - dec)*DEG2RAD, phi = ra*DEG2RAD;
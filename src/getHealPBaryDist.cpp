@@ -4,13 +4,13 @@
   Description:
    Return the distance from the HEALPix pixel barycentre (center) given scheme
    (RING or NESTED), order, pixel ID and coordinates.
-   getHealPBaryDist1 always creates a new Healpix_Base base and destroys
-   it on exit.
+   The shared (read only) base of the given scheme and order is used
+   (see getHealPBase), no base is allocated.
    This is a DIF oriented function.
 
   Parameters:
    (i) int nested:       Scheme ID; if 0 then RING else NESTED
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base2 )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) int k:            Resolution level of map in the range [0, 29]
    (i) long long int id: Pixel ID
    (i) double ra:        Right Ascension (degrees)
@@ -23,7 +23,7 @@
   If k not in the allowed range then return -1.
 
 
-  LN@IASF-INAF, October 2008                      Last change: 16/05/2016
+  LN@IASF-INAF, October 2008                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -33,6 +33,7 @@
 static const double DEG2RAD = 1.74532925199432957692369E-2;
 
 void cleanHealPUval(char*& saved);
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
 
 using namespace std;
 
@@ -40,26 +41,16 @@ using namespace std;
 double getHealPBaryDist(int nested, char*& saved, int k, long long int id,
                         double ra, double dec)
 {
-  long long int my_nside;
   double z, bc_ra, bc_dec;
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
   if (! saved) {
 
     if ((k < 0) || (k > 29))
       return -1.;
-
-    my_nside = 1 << k;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
   double sth;
   bool have_sth;
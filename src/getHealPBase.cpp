@@ -0,0 +1,114 @@
+/*
+  Name:  getHealPBase, getHealPidBatch
+
+  Description:
+   getHealPBase returns the shared HEALPix base of the given scheme and
+   order. The bases of all the 30 orders and 2 schemes are built only once
+   (on first use, thread safe) and never modified nor destroyed: all the
+   HEALPix functions and UDFs use them instead of allocating a new base.
+
+   getHealPidBatch returns the pixel IDs (RING or NESTED) of the given
+   coordinates arrays at one or more orders. For each position z=sin(dec)
+   and phi are computed once and the order 29 NESTED ID is evaluated, IDs
+   at the requested orders are obtained by shifting it (NESTED hierarchy)
+   and then converted to RING if needed.
+
+  Parameters (getHealPBase):
+   (i) int nested: Scheme ID; if 0 then RING else NESTED
+   (i) int k:      Resolution order in the range [0, 29]
+
+  Return the base, NULL if k is not in the allowed range.
+
+  Parameters (getHealPidBatch):
+   (i) int nested:        Scheme ID; if 0 then RING else NESTED
+   (i) const int* orders: Resolution orders, in the range [0, 29]
+   (i) int nord:          Number of orders, at most 30
+   (i) long n:            Number of positions
+   (i) const double* ra:  Right Ascension (degrees)
+   (i) const double* dec: Declination (degrees)
+
+   (o) long long int* id: HEALPix IDs, id[i*nord + j] is that of the i-th
+                          position at order orders[j]
+
+  Return 0 on success, -1 if an order or their number is not in the allowed
+  range.
+
+
+  LN@INAF-OAS, October 2026                       Last change: 19/10/2026
+*/
+
+#include "healpix_base.h"
+
+/* degrees to radians */
+static const double DEG2RAD = 1.74532925199432957692369E-2;
+
+/* Maximum HEALPix order */
+static const int HP_MAX_ORDER = 29;
+
+using namespace std;
+
+#include "dif.hh"
+
+
+// RING (0) and NESTED (1) bases of all the orders
+struct HealPBaseTable {
+  T_Healpix_Base<int64> base[2][HP_MAX_ORDER+1];
+
+  HealPBaseTable() {
+    for (int k=0; k<=HP_MAX_ORDER; k++) {
+      base[0][k].Set(k, RING);
+      base[1][k].Set(k, NEST);
+    }
+  }
+};
+
+
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k)
+{
+  static const HealPBaseTable table;
+
+  if ((k < 0) || (k > HP_MAX_ORDER))
+    return NULL;
+
+  return &table.base[nested ? 1 : 0][k];
+}
+
+
+
+int getHealPidBatch(int nested, const int* orders, int nord, long n,
+                    const double* ra, const double* dec, long long int* id)
+{
+  const T_Healpix_Base<int64>* base29 = getHealPBase(1, HP_MAX_ORDER);
+  const T_Healpix_Base<int64>* bring[HP_MAX_ORDER+1];
+  int j, sh[HP_MAX_ORDER+1];
+  long i;
+
+  if ((nord < 0) || (nord > HP_MAX_ORDER+1))
+    return -1;
+
+  for (j=0; j<nord; j++) {
+    if ((orders[j] < 0) || (orders[j] > HP_MAX_ORDER))
+      return -1;
+    sh[j] = 2*(HP_MAX_ORDER - orders[j]);
+    bring[j] = (nested ? NULL : getHealPBase(0, orders[j]));
+  }
+
+  for (i=0; i<n; i++) {
+    double d = dec[i]*DEG2RAD, phi = ra[i]*DEG2RAD;
+    double z = sin(d);
+    int64 id29;
+
+// Close to the poles use sin(theta), as in ang2pix
+    (fabs(z) > 0.99) ?
+      id29 = base29->loc2pix(z, phi, cos(d), true) :
+      id29 = base29->loc2pix(z, phi, 0., false);
+
+    long long int* out = id + i*nord;
+    for (j=0; j<nord; j++) {
+      int64 idk = id29 >> sh[j];
+      out[j] = (nested ? idk : bring[j]->nest2ring(idk));
+    }
+  }
+
+  return 0;
+}
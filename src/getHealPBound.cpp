@@ -5,11 +5,11 @@
    Return the HEALPix pixel boundaries coordinates given scheme
    (RING or NESTED), order and pixel ID.
    If step=1 then return the 4 corners (north, west, south and east).
-   getHealPBound1 always creates a new Healpix_Base base and destroys
-   it on exit.
+   The shared (read only) base of the given scheme and order is used
+   (see getHealPBase), no base is allocated.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) int nested:       Scheme ID; if 0 then RING else NESTED
    (i) int k:            Resolution order in the range [0, 29]
    (i) long long int id: Pixel ID
@@ -25,7 +25,7 @@
   Return 0 on success.
 
 
-  LN@IASF-INAF, May 2016                      Last change: 04/08/2016
+  LN@IASF-INAF, May 2016                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -35,6 +35,7 @@
 static const double RAD2DEG = 57.2957795130823208767981548;
 
 void cleanHealPUval(char*& saved);
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
 
 using namespace std;
 
@@ -49,22 +50,15 @@ int getHealPBound(char*& saved, int nested, int k, long long int id, unsigned in
 
   my_nside = 1 << k;
 
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
   b_ra.resize(4*step);
   b_dec.resize(4*step);
 
   if (! saved) {
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
   try {
 
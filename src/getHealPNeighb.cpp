@@ -6,11 +6,11 @@
    (RING or NESTED).
    Result contains (typically) 8 pixel numbers of the (in this order)
    SW, W, NW, N, NE, E, SE and S neighbor.
-   getHealPNeighb1 always creates a new Healpix_Base base and destroys
-   it on exit.
+   The shared (read only) base of the given scheme and order is used
+   (see getHealPBase), no base is allocated.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) int nested:       Scheme ID; if 0 then RING else NESTED
    (i) int k:            Resolution order in the range [0, 29]
    (i) long long int id: Pixel ID
@@ -27,7 +27,7 @@
   Return 0 on success.
 
 
-  LN@IASF-INAF, September 2008                      Last change: 04/08/2016
+  LN@IASF-INAF, September 2008                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -39,6 +39,7 @@
 static const double DEG2RAD = 1.74532925199432957692369E-2;
 
 void cleanHealPUval(char*& saved);
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
 
 using namespace std;
 
@@ -48,8 +49,7 @@ int getHealPNeighb(char*& saved, int nested, int k, long long int id,
 {
   int64 id_temp = id;
   fix_arr<int64, 8> idn_temp;
-  long long int my_nside;
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
   idn.clear();
 
@@ -58,18 +58,9 @@ int getHealPNeighb(char*& saved, int nested, int k, long long int id,
 //    if ((k < 0)  ||  (k > 29))  my_nside = MY_NSIDE_DEF;
     if ((k < 0) || (k > 29))
       return -1;
-
-    my_nside = 1 << k;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
   base->neighbors(id_temp, idn_temp);
 
@@ -6,11 +6,11 @@
    (RING or NESTED) calculated from the input spherical coordinates.
    Result contains (typically) 9 pixel numbers (in this order): central one,
    the SW, W, NW, N, NE, E, SE and S neighbor.
-   getHealPNeighb1C always creates a new Healpix_Base base and destroys
-   it on exit.
+   The shared (read only) base of the given scheme and order is used
+   (see getHealPBase), no base is allocated.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base )
+ ( (i) char*& saved: if not NULL then re-use the base found at the first call )
    (i) int nested: Scheme ID; if 0 then RING else NESTED
    (i) int k:      Resolution order in the range [0, 29]
    (i) double ra:  Right Ascension (degrees)
@@ -28,7 +28,7 @@
   Return 0 on success.
 
 
-  LN@IASF-INAF, September 2008                      Last change: 04/08/2016
+  LN@IASF-INAF, September 2008                      Last change: 19/10/2026
 */
 
 #include "arr.h"
@@ -40,6 +40,7 @@
 static const double DEG2RAD = 1.74532925199432957692369E-2;
 
 void cleanHealPUval(char*& saved);
+const T_Healpix_Base<int64>* getHealPBase(int nested, int k);
 
 using namespace std;
 
@@ -49,8 +50,7 @@ int getHealPNeighbC(char*& saved, int nested, int k, double ra, double dec,
 {
   int64 id;
   fix_arr<int64, 8> idn_temp;
-  long long int my_nside;
-  T_Healpix_Base<int64>* base;
+  const T_Healpix_Base<int64>* base;
 
   idn.clear();
 
@@ -59,18 +59,9 @@ int getHealPNeighbC(char*& saved, int nested, int k, double ra, double dec,
 //    if ((k < 0)  ||  (k > 29))  my_nside = MY_NSIDE_DEF;
     if ((k < 0) || (k > 29))
       return -1;
-
-    my_nside = 1 << k;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
+    saved = (char*) getHealPBase(nested, k);
+  }
+  base = (const T_Healpix_Base<int64>*) saved;
 
   double theta = (90. - dec)*DEG2RAD, phi = ra*DEG2RAD;
 
@@ -4,10 +4,11 @@
   Description:
    Returns the pixel ID (RING or NESTED) which contains the given angular
    coordinates.
-   getHealPid1 always creates a new Healpix_Base2 base and destroys it on exit.
+   The shared bases and the batch kernel getHealPidBatch are used, so that
+   no base is allocated per call.
 
   Parameters:
- ( (i) char*& saved: if not NULL then re-use existing Healpix_Base2 )
+ ( (i) char*& saved: not used, the bases are shared (see getHealPBase) )
    (i) int nested: Scheme ID; if 0 then RING else NESTED
    (i) int k:      Resolution level of map; if 0 then use 6 -> Nside=64
    (i) double ra:  Right Ascension (degrees)
@@ -28,68 +29,37 @@
   25/09/2008: Use Healpix_Base2
   30/09/2008: Use ang2pix_z_phi avoiding pointing structure definition
   16/05/2016: Use Healpix_Base version 3
+  19/10/2026: Use the shared bases and getHealPidBatch
 
 
-  LN@IASF-INAF, July 2007                        Last change: 16/05/2016
+  LN@IASF-INAF, July 2007                        Last change: 19/10/2026
 */
 
 #include "healpix_base.h"
 
-//static const int MY_NSIDE_DEF = 64;
-
-/* degrees to radians */
-static const double DEG2RAD = 1.74532925199432957692369E-2;
-
 using namespace std;
 
+#include "dif.hh"
+
 
 int getHealPid(char*& saved, int nested, int k, double ra, double dec,
                long long int *id)
 {
-  long long int my_nside;
-  T_Healpix_Base<int64>* base;
-
-  if (! saved) {
-
-//    if ((k < 0)  ||  (k > 29))  my_nside = MY_NSIDE_DEF;
-    if ((k < 0) || (k > 29)) {
-      *id = 0;
-      return -1;
-    }
-
-    my_nside = 1 << k;
-
-    if (nested) 
-      base = new T_Healpix_Base<int64>(my_nside, NEST, SET_NSIDE);
-    else
-      base = new T_Healpix_Base<int64>(my_nside, RING, SET_NSIDE);
-
-    saved = (char*) base;
-
-  } else
-    base = (T_Healpix_Base<int64>*) saved;
-
-  //*id = base->ang2pix_z_phi(sin(dec*DEG2RAD), ra*DEG2RAD);
-  double theta = (90. - dec)*DEG2RAD, phi = ra*DEG2RAD;
+  if ((k < 0) || (k > 29)) {
+    *id = 0;
+    return -1;
+  }
 
-  (theta < 0.01 || theta > 3.14159-0.01) ?
-    *id = base->loc2pix(cos(theta), phi, sin(theta), true) :
-    *id = base->loc2pix(cos(theta), phi, 0., false);
+  getHealPidBatch(nested, &k, 1, 1, &ra, &dec, id);
 
-//if (!nested) cout << "nested= " << base->ring2nest(*id) << endl;
-  
   return 0;
 }
 
 
+// Bases are shared (see getHealPBase): nothing to destroy
 void cleanHealPUval(char*& saved)
 {
-  T_Healpix_Base<int64>* base;
-
-  if (saved) {
-    base = (T_Healpix_Base<int64>*) saved;
-    delete base;
-  }
+  saved = NULL;
 }
 
 
@@ -34,6 +34,7 @@
 #include <my_config.h>
 #include <mysql/plugin.h>
 #include "sql_class.h"
+#include "item_cmpfunc.h"
 
 #else
 
@@ -60,6 +61,7 @@
 
 //#include <my_global.h>
 #include "sql_plugin.h"
+#include "item_cmpfunc.h"
 
 #endif
 
@@ -140,7 +142,71 @@ err:
 #endif  // >= 50600
 
 
-extern ThreadSpecificData<DIF_Region> difreg;
+extern ThreadSpecificData<DIF_RegionSet> difregs;
+
+
+// Region context (of the calling thread) read by this table
+DIF_Region* ha_dif::region()
+{
+  if (! difregs.getp()) difregs.constructor();
+  return &(*difregs.getp())[slot];
+}
+
+
+// Fold the "param = N" and "full = N" conjuncts (N integer constant) of a
+// condition pushed to a DIF table into the accepted params mask and full
+// flag. Return whether the whole condition has been folded.
+static bool dif_cond_fold(Item *cond, Field *fparam, Field *ffull,
+                          ulonglong *pmask, int *full)
+{
+  if (cond->type() == Item::COND_ITEM) {
+    Item_cond *c = (Item_cond*) cond;
+    if (c->functype() != Item_func::COND_AND_FUNC)
+      return false;
+
+    bool all = true;
+    List_iterator<Item> li(*c->argument_list());
+    Item *item;
+    while ((item = li++))
+      if (! dif_cond_fold(item, fparam, ffull, pmask, full))
+        all = false;
+    return all;
+  }
+
+  if (cond->type() != Item::FUNC_ITEM  ||
+      ((Item_func*) cond)->functype() != Item_func::EQ_FUNC)
+    return false;
+
+  Item **args = ((Item_func*) cond)->arguments();
+  Item *f = args[0]->real_item();
+  Item *v = args[1]->real_item();
+  if (f->type() != Item::FIELD_ITEM) {
+    f = args[1]->real_item();
+    v = args[0]->real_item();
+  }
+  if (f->type() != Item::FIELD_ITEM     ||
+      v->type() == Item::PARAM_ITEM     ||
+      ! v->basic_const_item()           ||
+      v->result_type() != INT_RESULT    ||
+      v->is_null())
+    return false;
+
+  Field *fld = ((Item_field*) f)->field;
+  long long n = v->val_int();
+
+  if (fld == fparam)
+    *pmask &= ((n >= 0  &&  n < 64)  ?  (1ULL << n)  :  0);
+  else if (fld == ffull) {
+    if ((n != 0  &&  n != 1)  ||  (*full >= 0  &&  *full != n))
+      *pmask = 0;   // no pixel
+    else
+      *full = (int) n;
+  }
+  else
+    return false;
+
+  return true;
+}
 
 
 /* Static declarations for handlerton */
@@ -164,6 +230,9 @@ ha_dif::ha_dif(handlerton *hton,
     int id_type;
     int id_opt;
     int param;
+    slot = 0;
+    kind = DIF_TBL_PIX;
+    cond_clear();
 }
 
 
@@ -206,6 +275,10 @@ int ha_dif::open(const char *name, int mode, uint test_if_locked)
   //sscanf(buf, "%d", &id_opt);
   //sscanf(p+6, "%d", &param);
 
+  // DIF.dif<k>, DIF.difm<k>, DIF.difr<k> read the region slot k
+  slot = DIF_tableSlot(name);
+  kind = DIF_tableKind(name);
+
   DBUG_RETURN(0);
 }
 
@@ -254,9 +327,10 @@ int ha_dif::rnd_init(bool scan)
 {
   DBUG_ENTER("ha_dif::rnd_init");
 
-  if (! difreg.getp()) difreg.constructor();
+  DIF_Region* difreg = region();
   difreg->subStart();
-  difreg->go();
+  difreg->go(kind == DIF_TBL_PIX);  //DIF.dif pixels can be streamed
+  difreg->compact();
   difreg->subStop();
 
   DBUG_RETURN(0);
@@ -274,21 +348,41 @@ int ha_dif::rnd_next(uchar *buf)
 {
   DBUG_ENTER("ha_dif::rnd_next");
 
+  DIF_Region* difreg = region();
   int param, full;
-  long long int val;
+  long long int val, hi, target;
 
   difreg->subStart();
-  int eof = difreg->read_next(param, val, full);
+
+// DIF.difm (target, param, id, full): multi-region searches
+// DIF.difr (param, lo, hi, full): ranges of consecutive IDs
+  int eof;
+  do
+    switch (kind) {
+    case DIF_TBL_TARGET:
+      eof = difreg->read_next_target(target, param, val, full);
+      break;
+    case DIF_TBL_RANGE:
+      eof = difreg->read_next_range(param, val, hi, full);
+      break;
+    default:
+      eof = difreg->read_next(param, val, full);
+    }
+  while (! eof  &&  ! cond_accept(param, full));
 
   if (! eof) {
       Field **field=table->field;
-      (*field)->set_notnull();  field++;
-      (*field)->set_notnull();  field++;
-      (*field)->set_notnull();
-      
-      field=table->field;
+      for (uint i=0; i<table->s->fields; i++)
+        field[i]->set_notnull();
+
+      if (kind == DIF_TBL_TARGET) {
+        (*field)->store(target);  field++;
+      }
       (*field)->store(param);   field++;
       (*field)->store(val);     field++;
+      if (kind == DIF_TBL_RANGE) {
+        (*field)->store(hi);    field++;
+      }
       (*field)->store(full);
       difreg->subStop();
       DBUG_RETURN(0);
@@ -334,6 +428,13 @@ void ha_dif::position(const uchar *record)
   if (flag & HA_STATUS_AUTO)
     stats.auto_increment_value= 1;
 
+// Expected rows for the optimizer: the pixels are computed only when the
+// table is read, estimate them from the region defined so far.
+  if (flag & HA_STATUS_VARIABLE) {
+    double n = region()->estimatePixels();
+    stats.records = (ha_rows) ((n < 1e18)  ?  n  :  1e18);
+  }
+
 #ifndef VOID_HANDLER_INFO
   DBUG_RETURN(0);
 #endif
@@ -346,6 +447,56 @@ int ha_dif::external_lock(THD *thd, int lock_type)
   DBUG_RETURN(0);
 }
 
+
+
+// Pushed condition only holds for the current statement
+int ha_dif::reset()
+{
+  DBUG_ENTER("ha_dif::reset");
+  cond_clear();
+  DBUG_RETURN(0);
+}
+
+
+// Param/full filter only: the "param = N" and "full = N" conjuncts are
+// applied in rnd_next, if these are the whole condition then the server
+// doesn't need to evaluate it. The region, depths/orders and schema are not
+// taken from the condition (see the region functions and DIF_setHTMDepth/
+// DIF_setHEALPOrder).
+#if MY_VERSION_ID >= 100000   // MariaDB
+const COND *ha_dif::cond_push(const COND *cond)
+#elif MY_VERSION_ID >= 80020
+const Item *ha_dif::cond_push(const Item *cond, bool)
+#else
+const Item *ha_dif::cond_push(const Item *cond)
+#endif
+{
+  DBUG_ENTER("ha_dif::cond_push");
+
+// DIF.dif (param, id, full), DIF.difm (target, param, id, full),
+// DIF.difr (param, lo, hi, full)
+  Field **field = table->field;
+  Field *fparam = field[(kind == DIF_TBL_TARGET)  ?  1  :  0];
+  Field *ffull = field[table->s->fields - 1];
+
+  cond_clear();
+  if (dif_cond_fold(const_cast<Item*>(cond), fparam, ffull,
+                    &push_pmask, &push_full))
+    DBUG_RETURN(NULL);
+
+  DBUG_RETURN(cond);
+}
+
+
+#if MY_VERSION_ID < 80000  ||  MY_VERSION_ID >= 100000
+void ha_dif::cond_pop()
+{
+  DBUG_ENTER("ha_dif::cond_pop");
+  cond_clear();
+  DBUG_VOID_RETURN;
+}
+#endif
+
 /*
 uint ha_dif::lock_count(void) const
 {
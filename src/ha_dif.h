@@ -93,10 +93,24 @@ class ha_dif: public handler
   THR_LOCK thr_lock;
 #endif
 
-  //const COND *cond_push(const COND *cond);
   int id_type;
   int id_opt;
   int param;
+  int slot;                ///< Region slot read by this table (see DIF_RegionSet)
+  int kind;                ///< Table content (see DIF_TableKind)
+
+  // Pushed param/full filter ("param = N", "full = N" conjuncts, see cond_push)
+  ulonglong push_pmask;    ///< Accepted params (bit N for param N)
+  int push_full;           ///< Accepted full flag, -1: any
+  void cond_clear()
+  { push_pmask = ~0ULL;  push_full = -1; }
+  bool cond_accept(int p, int full)
+  {
+    return (p >= 0  &&  p < 64  &&  ((push_pmask >> p) & 1)  &&
+            (push_full < 0  ||  full == push_full));
+  }
+
+  DIF_Region* region();
 
 public:
   ha_dif(handlerton *hton, TABLE_SHARE *table_arg);
@@ -181,6 +195,17 @@ public:
 #endif
 
   int external_lock(THD *thd, int lock_type);
+  int reset();
+#if MY_VERSION_ID >= 100000   // MariaDB
+  const COND *cond_push(const COND *cond);
+#elif MY_VERSION_ID >= 80020
+  const Item *cond_push(const Item *cond, bool other_tbls_ok);
+#else
+  const Item *cond_push(const Item *cond);
+#endif
+#if MY_VERSION_ID < 80000  ||  MY_VERSION_ID >= 100000
+  void cond_pop();
+#endif
 // Commented
   //uint lock_count(void) const;
 
@@ -59,10 +59,24 @@ class ha_dif: public handler
   Dif_share *share;    ///< Shared lock info
   Dif_share *get_share(); ///< Get the share
 
-  //const COND *cond_push(const COND *cond);
   int id_type;
   int id_opt;
   int param;
+  int slot;                ///< Region slot read by this table (see DIF_RegionSet)
+  int kind;                ///< Table content (see DIF_TableKind)
+
+  // Pushed param/full filter ("param = N", "full = N" conjuncts, see cond_push)
+  ulonglong push_pmask;    ///< Accepted params (bit N for param N)
+  int push_full;           ///< Accepted full flag, -1: any
+  void cond_clear()
+  { push_pmask = ~0ULL;  push_full = -1; }
+  bool cond_accept(int p, int full)
+  {
+    return (p >= 0  &&  p < 64  &&  ((push_pmask >> p) & 1)  &&
+            (push_full < 0  ||  full == push_full));
+  }
+
+  DIF_Region* region();
 
 public:
   ha_dif(handlerton *hton, TABLE_SHARE *table_arg);
@@ -142,6 +156,9 @@ public:
 #endif
 
   int external_lock(THD *thd, int lock_type);
+  int reset();
+  const COND *cond_push(const COND *cond);
+  void cond_pop();
 // Commented
   //uint lock_count(void) const;
 
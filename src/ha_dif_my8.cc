@@ -36,11 +36,12 @@
 #include "mysql/psi/mysql_memory.h"
 
 #include "sql/field.h"
+#include "sql/item.h"
+#include "sql/item_cmpfunc.h"
+#include "sql/item_func.h"
 #include "sql/table.h"
 //#include "sql/sql_plugin.h"
 
-extern ThreadSpecificData<DIF_Region> difreg;
-
 /* Static declarations for handlerton */
 
 static handler *dif_create_handler(handlerton *hton, TABLE_SHARE *table,
@@ -116,7 +117,71 @@ err:
 }
 
 
-extern ThreadSpecificData<DIF_Region> difreg;
+extern ThreadSpecificData<DIF_RegionSet> difregs;
+
+
+// Region context (of the calling thread) read by this table
+DIF_Region* ha_dif::region()
+{
+  if (! difregs.getp()) difregs.constructor();
+  return &(*difregs.getp())[slot];
+}
+
+
+// Fold the "param = N" and "full = N" conjuncts (N integer constant) of a
+// condition pushed to a DIF table into the accepted params mask and full
+// flag. Return whether the whole condition has been folded.
+static bool dif_cond_fold(Item *cond, Field *fparam, Field *ffull,
+                          ulonglong *pmask, int *full)
+{
+  if (cond->type() == Item::COND_ITEM) {
+    Item_cond *c = (Item_cond*) cond;
+    if (c->functype() != Item_func::COND_AND_FUNC)
+      return false;
+
+    bool all = true;
+    List_iterator<Item> li(*c->argument_list());
+    Item *item;
+    while ((item = li++))
+      if (! dif_cond_fold(item, fparam, ffull, pmask, full))
+        all = false;
+    return all;
+  }
+
+  if (cond->type() != Item::FUNC_ITEM  ||
+      ((Item_func*) cond)->functype() != Item_func::EQ_FUNC)
+    return false;
+
+  Item **args = ((Item_func*) cond)->arguments();
+  Item *f = args[0]->real_item();
+  Item *v = args[1]->real_item();
+  if (f->type() != Item::FIELD_ITEM) {
+    f = args[1]->real_item();
+    v = args[0]->real_item();
+  }
+  if (f->type() != Item::FIELD_ITEM     ||
+      v->type() == Item::PARAM_ITEM     ||
+      ! v->basic_const_item()           ||
+      v->result_type() != INT_RESULT    ||
+      v->is_null())
+    return false;
+
+  Field *fld = ((Item_field*) f)->field;
+  long long n = v->val_int();
+
+  if (fld == fparam)
+    *pmask &= ((n >= 0  &&  n < 64)  ?  (1ULL << n)  :  0);
+  else if (fld == ffull) {
+    if ((n != 0  &&  n != 1)  ||  (*full >= 0  &&  *full != n))
+      *pmask = 0;   // no pixel
+    else
+      *full = (int) n;
+  }
+  else
+    return false;
+
+  return true;
+}
 
 
 /* Static declarations for handlerton */
@@ -137,6 +202,9 @@ ha_dif::ha_dif(handlerton *hton, TABLE_SHARE *table_arg)
     int id_type;
     int id_opt;
     int param;
+    slot = 0;
+    kind = DIF_TBL_PIX;
+    cond_clear();
 }
 
 
@@ -177,7 +245,7 @@ static bool dif_is_supported_system_table(const char *db,
 
 
 //int ha_dif::open(const char *name, int mode, uint test_if_locked)
-int ha_dif::open(const char *, int, uint, const dd::Table *)
+int ha_dif::open(const char *name, int, uint, const dd::Table *)
 {
   DBUG_ENTER("ha_dif::open");
 
@@ -185,6 +253,10 @@ int ha_dif::open(const char *, int, uint, const dd::Table *)
     DBUG_RETURN(1);
   thr_lock_data_init(&share->lock, &lock, NULL);
 
+  // DIF.dif<k>, DIF.difm<k>, DIF.difr<k> read the region slot k
+  slot = DIF_tableSlot(name);
+  kind = DIF_tableKind(name);
+
   DBUG_RETURN(0);
 }
 
@@ -251,9 +323,10 @@ int ha_dif::rnd_init(bool)
 {
   DBUG_ENTER("ha_dif::rnd_init");
 
-  if (! difreg.getp()) difreg.constructor();
+  DIF_Region* difreg = region();
   difreg->subStart();
-  difreg->go();
+  difreg->go(kind == DIF_TBL_PIX);  //DIF.dif pixels can be streamed
+  difreg->compact();
   difreg->subStop();
 
   DBUG_RETURN(0);
@@ -273,21 +346,41 @@ int ha_dif::rnd_next(uchar *)
 {
   DBUG_ENTER("ha_dif::rnd_next");
 
+  DIF_Region* difreg = region();
   int param, full;
-  long long int val;
+  long long int val, hi, target;
 
   difreg->subStart();
-  int eof = difreg->read_next(param, val, full);
+
+// DIF.difm (target, param, id, full): multi-region searches
+// DIF.difr (param, lo, hi, full): ranges of consecutive IDs
+  int eof;
+  do
+    switch (kind) {
+    case DIF_TBL_TARGET:
+      eof = difreg->read_next_target(target, param, val, full);
+      break;
+    case DIF_TBL_RANGE:
+      eof = difreg->read_next_range(param, val, hi, full);
+      break;
+    default:
+      eof = difreg->read_next(param, val, full);
+    }
+  while (! eof  &&  ! cond_accept(param, full));
 
   if (! eof) {
       Field **field=table->field;
-      (*field)->set_notnull();  field++;
-      (*field)->set_notnull();  field++;
-      (*field)->set_notnull();
-      
-      field=table->field;
+      for (uint i=0; i<table->s->fields; i++)
+        field[i]->set_notnull();
+
+      if (kind == DIF_TBL_TARGET) {
+        (*field)->store(target);  field++;
+      }
       (*field)->store(param);   field++;
       (*field)->store(val);     field++;
+      if (kind == DIF_TBL_RANGE) {
+        (*field)->store(hi);    field++;
+      }
       (*field)->store(full);
       difreg->subStop();
       DBUG_RETURN(0);
@@ -332,6 +425,13 @@ int ha_dif::info(uint flag)
   if (flag & HA_STATUS_AUTO)
     stats.auto_increment_value= 1;
 
+// Expected rows for the optimizer: the pixels are computed only when the
+// table is read, estimate them from the region defined so far.
+  if (flag & HA_STATUS_VARIABLE) {
+    double n = region()->estimatePixels();
+    stats.records = (ha_rows) ((n < 1e18)  ?  n  :  1e18);
+  }
+
   DBUG_RETURN(0);
 }
 
@@ -345,6 +445,44 @@ int ha_dif::external_lock(THD *, int)
 }
 
 
+
+// Pushed condition only holds for the current statement
+int ha_dif::reset()
+{
+  DBUG_ENTER("ha_dif::reset");
+  cond_clear();
+  DBUG_RETURN(0);
+}
+
+
+// Param/full filter only: the "param = N" and "full = N" conjuncts are
+// applied in rnd_next, if these are the whole condition then the server
+// doesn't need to evaluate it. The region, depths/orders and schema are not
+// taken from the condition (see the region functions and DIF_setHTMDepth/
+// DIF_setHEALPOrder).
+#if MY_VERSION_ID >= 80020
+const Item *ha_dif::cond_push(const Item *cond, bool)
+#else
+const Item *ha_dif::cond_push(const Item *cond)
+#endif
+{
+  DBUG_ENTER("ha_dif::cond_push");
+
+// DIF.dif (param, id, full), DIF.difm (target, param, id, full),
+// DIF.difr (param, lo, hi, full)
+  Field **field = table->field;
+  Field *fparam = field[(kind == DIF_TBL_TARGET)  ?  1  :  0];
+  Field *ffull = field[table->s->fields - 1];
+
+  cond_clear();
+  if (dif_cond_fold(const_cast<Item*>(cond), fparam, ffull,
+                    &push_pmask, &push_full))
+    DBUG_RETURN(NULL);
+
+  DBUG_RETURN(cond);
+}
+
+
 /*
 int ha_dif::extra(enum ha_extra_function) {
   DBUG_ENTER("ha_dif::extra");
@@ -3,7 +3,7 @@
 
   Note: here use "myXmatch" custom bind function "my_difbind"
 
-  LN @ IASF-INAF, Sep. 2010                         Last changed: 28/01/2023
+  LN @ IASF-INAF, Sep. 2010                         Last changed: 19/10/2026
 */
 
 #include <stdlib.h>
@@ -25,6 +25,13 @@ int db_init(int ID) {
   return iret;
 }
 
+int db_local_infile(int ID) {
+  unsigned int on = 1;
+
+  if (mysql_options(&conn[ID], MYSQL_OPT_LOCAL_INFILE, &on) == 0) return 1;
+  else return 0;
+}
+
 int db_connect(int ID, const char *host, const char *username, const char *password, const char *db) {
   MYSQL *ret;
 
@@ -313,6 +320,16 @@ char **db_row(int ID, unsigned int row) {
   return NULL;
 }
 
+/* Next row of a db_uquery result (streamed, no data_seek), with its lengths */
+char **db_next_row(int ID, unsigned long **lengths) {
+  MYSQL_ROW record;
+
+  record = mysql_fetch_row(result[ID]);
+  if (record && lengths)
+    *lengths = mysql_fetch_lengths(result[ID]);
+  return record;
+}
+
 short db_unsigned(int ID, int ord) {
   MYSQL_FIELD *fields;
 
@@ -3,7 +3,7 @@
 
   Note: "myXmatch" custom
 
-  LN @ INAF-OAS, Sep. 2010                         Last changed: 28/01/2023
+  LN @ INAF-OAS, Sep. 2010                         Last changed: 19/10/2026
 */
 
 #ifndef MY_STMT_DB_H
@@ -24,6 +24,7 @@
 __BEGIN_DECLS
 
 int db_init(int ID);
+int db_local_infile(int ID);
 int db_connect(int ID, const char *host, const char *username, const char *password, const char *db);
 int db_select(int ID, const char *db);
 const char * db_error(int ID);
@@ -37,6 +38,7 @@ enum enum_field_types db_fieldtype(int ID, int ord);
 unsigned int db_fieldlength(int ID, int ord);
 char *db_data(int ID, unsigned int row, unsigned int field);
 char **db_row(int ID, unsigned int row);
+char **db_next_row(int ID, unsigned long **lengths);
 short db_unsigned(int ID, int ord);
 void db_free_result(int ID);
 void db_close(int ID);
@@ -0,0 +1,145 @@
+/*
+  Test the estimated number of pixels of a region (DIFestimate.cpp) against
+  the pixels computed by go() for circles and rectangles of several sizes,
+  positions and depths/orders, and for a few region expressions. Return 0
+  if all the estimates are within the bounds given in DIFestimate.cpp.
+
+Last changed: 19/10/2026
+*/
+
+#include <iostream>
+#include <math.h>
+#include <string.h>
+#include <vector>
+using namespace std;
+
+#include "dif.hh"
+
+
+static int nfail = 0;
+static double qmin = 1., qmax = 1.;
+
+static void check(bool ok, const char* what, int round)
+{
+  if (! ok) {
+    cout << "FAILED: " << what << " (round " << round << ")" << endl;
+    nfail++;
+  }
+}
+
+
+// Full and partial pixels of the region at all the depths/orders
+static double countPixels(DIF_Region& r)
+{
+  double n = 0.;
+  for (unsigned long i=0; i<r.params.size(); i++)
+    n += r.flist(r.params[i]).size() + r.plist(r.params[i]).size();
+  return n;
+}
+
+
+// Circle (shape 0) or rectangle (shape 1) of half side rad (arcmin)
+static void testRegion(enum DIF_Schema schema, const vector<int>& params,
+                       double ra, double de, double rad, int shape,
+                       int round)
+{
+  DIF_Region r;
+  double h = rad/60.;
+
+  r.clear_region();
+  r.setSchema(schema);
+  for (unsigned long i=0; i<params.size(); i++)
+    r.setAvailParam(params[i]);
+  if (shape == 0)
+    r.setCircle(ra, de, rad);
+  else {
+    double w = h / cos(de * M_PI/180.);
+    r.setRect(ra - w, de - h, ra + w, de + h);
+  }
+
+  double est = r.estimatePixels();
+  r.go();
+  double n = countPixels(r);
+  double q = est / n;
+
+// HEALPix 10%, HTM 20% at one depth and 40% at several, beyond 30 pixels
+  double tol = (schema != DIF_HTM  ?  0.1  :
+                (params.size() == 1  ?  0.2  :  0.4));
+  if (n >= 30.) {
+    check(q >= 1. - tol  &&  q <= 1. + tol, "estimatePixels", round);
+    qmin = min(qmin, q);
+    qmax = max(qmax, q);
+  }
+  else
+    check(q >= 0.1  &&  q <= 10., "estimatePixels (few pixels)", round);
+}
+
+
+// Union, intersection and difference of regions (DIFexpr.cpp): within a
+// factor 2, the smaller operand of an intersection bounds its area
+static void testExpr(enum DIF_Schema schema, const vector<int>& params,
+                     const char* expr, int round)
+{
+  DIF_Region r;
+
+  r.clear_region();
+  r.setSchema(schema);
+  for (unsigned long i=0; i<params.size(); i++)
+    r.setAvailParam(params[i]);
+  r.setExpr(expr, strlen(expr));
+  r.regtype = DIF_REG_EXPR;
+
+  double est = r.estimatePixels();
+  r.go();
+  double q = est / countPixels(r);
+  check(q >= 0.5  &&  q <= 2., "estimatePixels (expression)", round);
+  qmin = min(qmin, q);
+  qmax = max(qmax, q);
+}
+
+
+int main() {
+    int i, j, k, round = 0;
+    double ctr[][2] = {{100.3, 40.}, {44.9, 40.}, {10., 0.}, {200., 70.},
+		       {300., -20.}, {123., -55.}, {77., 85.}};
+    double rad[] = {10., 30., 60., 120., 300., 1200.};
+    int htm[][3] = {{6}, {8}, {10}, {12}, {6, 8, 10}, {8, 12}, {10, 11}};
+    int nhtm[] = {1, 1, 1, 1, 3, 2, 2};
+    int healp[][2] = {{6}, {8}, {10}, {6, 8}};
+    int nhealp[] = {1, 1, 1, 2};
+    const char* expr[] = {
+	"circle(15,0,300) & rect(10,-2,25,3)",
+	"circle(40,30,60) | annulus(42,30,30,60) | ellipse(38,31,60,20,30)",
+	"annulus(40,30,60,120) | ellipse(45,30,60,20,30) - strip(30,25,50,35,5)"};
+
+    for (i=0; i<7; i++)
+	for (j=0; j<7; j++)
+	    for (k=0; k<6; k++) {
+		vector<int> p(htm[i], htm[i] + nhtm[i]);
+		testRegion(DIF_HTM, p, ctr[j][0], ctr[j][1], rad[k], 0, round);
+		if (fabs(ctr[j][1]) + rad[k]/60. < 89.)
+		    testRegion(DIF_HTM, p, ctr[j][0], ctr[j][1], rad[k], 1,
+			       round);
+		round++;
+	    }
+
+    for (i=0; i<4; i++)
+	for (j=0; j<7; j++)
+	    for (k=0; k<6; k++) {
+		vector<int> p(healp[i], healp[i] + nhealp[i]);
+		testRegion(DIF_HEALP_NEST, p, ctr[j][0], ctr[j][1], rad[k], 0,
+			   round);
+		round++;
+	    }
+
+    for (i=0; i<7; i++)
+	for (j=0; j<3; j++) {
+	    vector<int> p(htm[i], htm[i] + nhtm[i]);
+	    testExpr(DIF_HTM, p, expr[j], round);
+	    round++;
+	}
+
+    cout << round << " rounds, estimate/actual " << qmin << ".." << qmax
+	 << ", " << nfail << " failed checks" << endl;
+    return (nfail ? 1 : 0);
+}
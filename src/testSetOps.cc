@@ -0,0 +1,254 @@
+/*
+  Test the pixel ID set algebra (DIFsetops.cpp) and the DIF_PixelSet
+  compressed sets (DIFpixset.cpp) against the std::set_* algorithms on
+  random inputs. Return 0 if all the checks pass.
+
+Last changed: 19/10/2026
+*/
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <stdlib.h>
+using namespace std;
+
+#include "dif.hh"
+
+
+static int nfail = 0;
+
+static void check(bool ok, const char* what, int round)
+{
+  if (! ok) {
+    cout << "FAILED: " << what << " (round " << round << ")" << endl;
+    nfail++;
+  }
+}
+
+
+// n sorted, distinct IDs in [base, base+span)
+static void randomIds(vector<long long int>& v, unsigned long n,
+                      long long int base, long long int span)
+{
+  set<long long int> s;
+  while (s.size() < n)
+    s.insert(base + (long long int) (((double) rand() / RAND_MAX) * (span-1)));
+  v.assign(s.begin(), s.end());
+}
+
+
+// IDs with runs of consecutive values (as the full pixels of a region)
+static void randomRuns(vector<long long int>& v, int nruns,
+                       long long int base, long long int span)
+{
+  set<long long int> s;
+  for (int i=0; i<nruns; i++) {
+    long long int lo = base + rand() % span;
+    long long int len = 1 + rand() % 3000;
+    for (long long int id=lo; id<lo+len; id++)
+      s.insert(id);
+  }
+  v.assign(s.begin(), s.end());
+}
+
+
+// Sorted, disjoint and not adjacent ranges [lo, hi) in [0, span)
+static void randomRanges(DIF_Ranges& r, int n, long long int span)
+{
+  vector<long long int> b;
+  randomIds(b, 2*n, 0, span);
+  r.clear();
+  for (unsigned long i=0; i+1<b.size(); i+=2)
+    if (r.size() == 0  ||  b[i] > r.hi.back()) {
+      r.lo.push_back(b[i]);
+      r.hi.push_back(b[i+1]);
+    }
+}
+
+
+static void expand(const DIF_Ranges& r, vector<long long int>& v)
+{
+  v.clear();
+  for (unsigned long i=0; i<r.size(); i++)
+    for (long long int id=r.lo[i]; id<r.hi[i]; id++)
+      v.push_back(id);
+}
+
+
+static bool wellFormed(const DIF_Ranges& r)
+{
+  for (unsigned long i=0; i<r.size(); i++) {
+    if (r.lo[i] >= r.hi[i])
+      return false;
+    if (i > 0  &&  r.lo[i] < r.hi[i-1])
+      return false;
+  }
+  return true;
+}
+
+
+static void testLists(int round)
+{
+  vector<long long int> a, b, out, ref;
+  long long int span = 1 + rand() % 200000;
+
+  randomIds(a, rand() % min(span, 5000LL), 8, span);
+  randomIds(b, rand() % min(span, 5000LL), 8, span);
+
+  DIF_setUnion(a, b, out);
+  ref.clear();
+  set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(ref));
+  check(out == ref, "DIF_setUnion", round);
+
+  DIF_setIntersection(a, b, out);
+  ref.clear();
+  set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                   back_inserter(ref));
+  check(out == ref, "DIF_setIntersection", round);
+
+  DIF_setDifference(a, b, out);
+  ref.clear();
+  set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(ref));
+  check(out == ref, "DIF_setDifference", round);
+
+// Parents (2 levels up) and children (1 level down)
+  int shift = 2 * (1 + rand() % 3);
+  vector<long long int> par;
+  DIF_setParents(a, shift, par);
+  set<long long int> sp;
+  for (unsigned long i=0; i<a.size(); i++)
+    sp.insert(a[i] >> shift);
+  ref.assign(sp.begin(), sp.end());
+  check(par == ref, "DIF_setParents", round);
+
+  DIF_setChildren(par, 2, out);
+  ref.clear();
+  for (unsigned long i=0; i<par.size(); i++)
+    for (long long int c=par[i] << 2; c<(par[i]+1) << 2; c++)
+      ref.push_back(c);
+  check(out == ref, "DIF_setChildren", round);
+
+// IDs of a not covered by the coarser IDs of par (a subset of the parents)
+  vector<long long int> cover;
+  for (unsigned long i=0; i<par.size(); i++)
+    if (rand() % 2)
+      cover.push_back(par[i]);
+  DIF_setDropCovered(a, cover, shift, out);
+  ref.clear();
+  for (unsigned long i=0; i<a.size(); i++)
+    if (! binary_search(cover.begin(), cover.end(), a[i] >> shift))
+      ref.push_back(a[i]);
+  check(out == ref, "DIF_setDropCovered", round);
+}
+
+
+static void testRanges(int round)
+{
+  DIF_Ranges a, b, out;
+  vector<long long int> ea, eb, eo, ref;
+  long long int span = 2 + rand() % 50000;
+
+  randomRanges(a, rand() % 200, span);
+  randomRanges(b, rand() % 200, span);
+  expand(a, ea);
+  expand(b, eb);
+
+  DIF_rangeUnion(a, b, out);
+  expand(out, eo);
+  ref.clear();
+  set_union(ea.begin(), ea.end(), eb.begin(), eb.end(), back_inserter(ref));
+  check(wellFormed(out)  &&  eo == ref, "DIF_rangeUnion", round);
+
+  DIF_rangeIntersection(a, b, out);
+  expand(out, eo);
+  ref.clear();
+  set_intersection(ea.begin(), ea.end(), eb.begin(), eb.end(),
+                   back_inserter(ref));
+  check(wellFormed(out)  &&  eo == ref, "DIF_rangeIntersection", round);
+
+  DIF_rangeDifference(a, b, out);
+  expand(out, eo);
+  ref.clear();
+  set_difference(ea.begin(), ea.end(), eb.begin(), eb.end(),
+                 back_inserter(ref));
+  check(wellFormed(out)  &&  eo == ref, "DIF_rangeDifference", round);
+}
+
+
+static void testPixelSet(int round)
+{
+  vector<long long int> a, b, v, ref;
+  DIF_PixelSet sa, sb, so;
+  long long int base = (long long int) (rand() % 1000) << 20;
+
+// Sparse (deltas), runs and dense (bitmap) blocks
+  switch (round % 3) {
+    case 0:
+      randomIds(a, rand() % 20000, base, 1 << 22);
+      randomIds(b, rand() % 20000, base, 1 << 22);
+      break;
+    case 1:
+      randomRuns(a, 1 + rand() % 50, base, 1 << 20);
+      randomRuns(b, 1 + rand() % 50, base, 1 << 20);
+      break;
+    default:
+      randomIds(a, 40000 + rand() % 20000, base, 1 << 16);
+      randomIds(b, rand() % 60000, base, 1 << 17);
+  }
+
+  sa.assign(a);
+  sb.assign(b);
+  sa.toVector(v);
+  check(v == a  &&  sa.size() == a.size(), "DIF_PixelSet round trip", round);
+
+// Cursor from a rank, by runs of consecutive IDs
+  unsigned long long rank = (a.size()  ?  rand() % a.size()  :  0);
+  DIF_PixelSet::Cursor c;
+  long long int lo, hi;
+  c.begin(sa, rank);
+  v.clear();
+  while (c.nextRun(lo, hi, 1 + rand() % 1000))
+    for (long long int id=lo; id<=hi; id++)
+      v.push_back(id);
+  check(equal(v.begin(), v.end(), a.begin() + rank)  &&
+        v.size() == a.size() - rank, "DIF_PixelSet::Cursor", round);
+
+  DIF_PixelSet::setUnion(sa, sb, so);
+  so.toVector(v);
+  ref.clear();
+  set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(ref));
+  check(v == ref  &&  so.size() == ref.size(), "DIF_PixelSet::setUnion",
+        round);
+
+  DIF_PixelSet::setIntersection(sa, sb, so);
+  so.toVector(v);
+  ref.clear();
+  set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                   back_inserter(ref));
+  check(v == ref  &&  so.size() == ref.size(),
+        "DIF_PixelSet::setIntersection", round);
+
+  DIF_PixelSet::setDifference(sa, sb, so);
+  so.toVector(v);
+  ref.clear();
+  set_difference(a.begin(), a.end(), b.begin(), b.end(), back_inserter(ref));
+  check(v == ref  &&  so.size() == ref.size(),
+        "DIF_PixelSet::setDifference", round);
+}
+
+
+int main() {
+    int i, nround = 300;
+
+    srand(12345);
+    for (i=0; i<nround; i++) {
+	testLists(i);
+	testRanges(i);
+	if (i % 10 == 0)
+	    testPixelSet(i / 10);
+    }
+
+    cout << nround << " rounds, " << nfail << " failed checks" << endl;
+    return (nfail ? 1 : 0);
+}
@@ -23,10 +23,12 @@
 
 #include <cmath>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
 //#include <regex>
 #include <algorithm>    // std::sort
+#include <functional>   // std::greater
 #include <string>
 
 #include "dif.hh"
@@ -53,14 +55,102 @@ typedef unsigned long long      uint64;
 */
 //static const double MIN_CONE_RAD = 5e-9;
 static const double MIN_CONE_DEG = 2.865e-7;
+static const double MIN_CONE_ARCMIN = MIN_CONE_DEG * 60.;   //radii in arcmin
 
 // use an approx offset for coords close to limits 0,360 and +/-90 deg
 static const double MIN_OFF_DEG = 6e-4;
 
 
-ThreadSpecificData<DIF_Region> difreg;
+ThreadSpecificData<DIF_RegionSet> difregs;
 vector<long long int> DIF_Region::nullvec;
 
+
+// Region context of slot k of the calling thread
+static DIF_Region* getRegion(int k)
+{
+  if (! difregs.getp()) difregs.constructor();
+  return &(*difregs.getp())[k];
+}
+
+
+// Constant INT argument i in the init function. With MySQL 8 the value can
+// be undefined (e.g. when aliases are used): parse its text ("attributes")
+// first, use the value only if the text is not an integer (e.g. a user
+// variable). Otherwise parse the text only if the value is not given.
+static long long constIntArg(UDF_ARGS *args, unsigned int i)
+{
+  string a(args->attributes[i], args->attribute_lengths[i]);
+  char *end;
+  long long n = strtoll(a.c_str(), &end, 10);
+  bool isnum = (end != a.c_str()  &&  *end == '\0');
+
+#if MY_VERSION_ID >= 80000 &&  MY_VERSION_ID < 100000
+  if (isnum)
+    return n;
+  return (args->args[i]  ?  IARGS(i)  :  0);
+#else
+  if (args->args[i])
+    return IARGS(i);
+  return (isnum  ?  n  :  0);
+#endif
+}
+
+
+// Slot given by the optional argument i (default 0): -1 if out of range
+static int slotArg(UDF_ARGS *args, unsigned int i)
+{
+  long long k = 0;
+
+  if (args->arg_count > i) {
+    if (args->arg_type[i] != INT_RESULT)
+      return -1;
+    k = constIntArg(args, i);
+  }
+
+  return (k >= 0  &&  k < DIF_NSLOTS)  ?  (int) k  :  -1;
+}
+
+
+// Optional frame name (the only STRING argument): return the frame (-1 if
+// not valid), set nargs to the number of arguments before it (all if not
+// given). The optional slot must follow the frame.
+static int frameArg(UDF_ARGS *args, unsigned int* nargs)
+{
+  unsigned int i;
+
+  *nargs = args->arg_count;
+  for (i=0; i<args->arg_count; i++)
+    if (args->arg_type[i] == STRING_RESULT) {
+      *nargs = i;
+      if (! args->args[i]  ||  i+2 < args->arg_count)
+        return -1;
+      return DIF_frameParse(args->args[i], args->lengths[i]);
+    }
+
+  return DIF_FRAME_EQ;
+}
+
+
+// Index of the optional slot of a function with n required arguments
+// followed by the optional frame and slot (nargs from frameArg): -1 if the
+// number of arguments is not valid
+static int frameSlotIndex(UDF_ARGS *args, unsigned int nargs, unsigned int n)
+{
+  if (nargs < args->arg_count)   // frame given
+    return (nargs == n)  ?  (int) n+1  :  -1;
+  return (nargs == n  ||  nargs == n+1)  ?  (int) n  :  -1;
+}
+
+
+// Get the region of the slot given by argument NUM or raise an error
+#define GET_SLOT_REGION(NUM)               \
+  int slot = slotArg(args, NUM);           \
+  if (slot < 0) {                          \
+    strcpy(message, argerr);               \
+    return 1;                              \
+  }                                        \
+  DIF_Region* difreg = getRegion(slot);
+
 //ThreadSpecificData<XMatch> xmatch;
 
 
@@ -72,12 +162,14 @@ vector<long long int> DIF_Region::nullvec;
    de1, de2, rad. The depth/order parameters to be used (either one
    or more) are stored in params array.
  */
-void DIF_Region::go() {
+void DIF_Region::go(bool stream) {
     int i;
 
 
-    if (go_performed) return;
+    //Streamed pixels are computed again into the lists if these are needed
+    if (go_performed  &&  (stream  ||  ! st_on)) return;
     go_performed = true;
+    st_on = false;
     params.clear();
 
     params = avail_params;
@@ -93,10 +185,31 @@ void DIF_Region::go() {
     //Sort parameters
     sort(params.begin(), params.end());
 
-    //prepare pixel lists
+    //Prepared region: pixels already computed by any connection
+    if (pl_handle  &&  go_prepared()) {
+	read_reset();
+	return;
+    }
+
+    if (stream  &&  streamable()  &&  ! pl_handle) {
+	st_on = true;
+	read_reset();
+	return;
+    }
+
+    //prepare pixel lists (from the pool), reserved from the estimated
+    //number of pixels; partial pixels are at the highest HTM depth or
+    //at the HEALPix order
+    double est = estimatePixels() * chunk_n / params.size();
+    unsigned long nres = (est < DIF_LIST_MAXRESERVE  ?
+			  (unsigned long) est  :  DIF_LIST_MAXRESERVE);
+    int ipart = (schema == DIF_HTM  ?  params.size() - 1  :  0);
     for (i=0; i<params.size(); i++) {
-	pflist.push_back(new vector<long long int>);
-	pplist.push_back(new vector<long long int>);
+	pflist.push_back(newList());
+	pplist.push_back(newList());
+	pflist[i]->reserve(nres);
+	if (i == ipart)
+	    pplist[i]->reserve(nres);
     }
 
 
@@ -138,6 +251,25 @@ void DIF_Region::go() {
         case DIF_REG_SNEIGHB:
 	  DIFgetHTMsNeighb1(*this); 
 	  break;
+
+        case DIF_REG_CONES:
+	  DIFhtmCones(*this);
+	  break;
+
+        case DIF_REG_POLYGON:
+	  DIFhtmPolygon(*this);
+	  break;
+
+        case DIF_REG_ANNULUS:
+        case DIF_REG_ELLIPSE:
+        case DIF_REG_STRIP:
+        case DIF_REG_LONLAT:
+	  DIFhtmShape(*this);
+	  break;
+
+// MOC are HEALPix only, expressions are computed by go_expr
+        case DIF_REG_MOC:
+        case DIF_REG_EXPR:
         case DIF_REG_RECT:
         case DIF_REG_2VERT:
         case DIF_REG_NONE:
@@ -163,6 +295,26 @@ void DIF_Region::go() {
 	  DIFgetHealPNeighbC1(*this); 
 	  break;
 
+        case DIF_REG_CONES:
+	  DIFmyHealPCones(*this);
+	  break;
+
+        case DIF_REG_POLYGON:
+	  DIFmyHealPPolygon(*this);
+	  break;
+
+        case DIF_REG_MOC:
+	  DIFmyHealPMOC(*this);
+	  break;
+
+        case DIF_REG_ANNULUS:
+        case DIF_REG_ELLIPSE:
+        case DIF_REG_STRIP:
+        case DIF_REG_LONLAT:
+	  DIFmyHealPShape(*this);
+	  break;
+
+        case DIF_REG_EXPR:
         case DIF_REG_RECT:
         case DIF_REG_2VERT:
         case DIF_REG_SNEIGHB:
@@ -173,13 +325,208 @@ void DIF_Region::go() {
       case DIF_NONE:
         break;
     }
-    
+
+    if (regtype == DIF_REG_CONES)
+      go_cones();
+
+    if (regtype == DIF_REG_EXPR)
+      go_expr();
+
+    if (pl_handle)
+      keep_prepared();
+
+    read_reset();
+}
+
+
+// Next run of consecutive IDs of the full or partial list (chunk) of the
+// current param, taking the lowest ID of the two (sorted here if needed):
+// full and partial pixels are disjoint, so that runs never overlap.
+int DIF_Region::read_next_range(int& param, long long int& lo,
+                                long long int& hi, int& full)
+{
+    long long int fid = 0, pid = 0;
+
+    while (rg_iavail_param < avail_params.size()) {
+	int i = locateParam(avail_params[rg_iavail_param]);
+
+	if ((i > -1)  &&  (pflist.size() > i)) {
+	    if (rg_begin) {
+		vector<long long int>& fl = *pflist[i];
+		vector<long long int>& pl = *pplist[i];
+		if (adjacent_find(fl.begin(), fl.end(),
+				  greater<long long int>()) != fl.end())
+		    sort(fl.begin(), fl.end());
+		if (adjacent_find(pl.begin(), pl.end(),
+				  greater<long long int>()) != pl.end())
+		    sort(pl.begin(), pl.end());
+		openList(rg_f, i, 1);
+		openList(rg_p, i, 0);
+		rg_begin = false;
+	    }
+
+	    int f = rg_f.peek(fid);
+	    int p = rg_p.peek(pid);
+	    if (f  ||  p) {
+		full = (f  &&  (! p  ||  fid < pid));
+		param = params[i];
+		(full  ?  rg_f  :  rg_p).nextRun(lo, hi);
+		return 0;
+	    }
+	}
+
+	rg_iavail_param++;
+	rg_begin = true;
+    }
+
+    return 1; //Final EOF
+}
+
+
+// Sorted, unique IDs of a large list into the set: the list is released
+static void compactList(vector<long long int>& l, DIF_PixelSet& s)
+{
+    if (l.size() < DIF_COMPACT_MIN)
+	return;
+    sort(l.begin(), l.end());
+    l.erase(unique(l.begin(), l.end()), l.end());
+    s.assign(l);
+    vector<long long int>().swap(l);
+}
+
+
+void DIF_Region::compact() {
+    unsigned int i;
+
+    pfset.resize(pflist.size());
+    ppset.resize(pplist.size());
+    for (i=0; i<pflist.size(); i++) {
+	compactList(*pflist[i], pfset[i]);
+	compactList(*pplist[i], ppset[i]);
+    }
     read_reset();
 }
 
 
 
 
+/*
+   Multi-region search: sort the target lookup tables used by
+   DIF_FineSearch and fill the PARTIAL and FULL pixel lists with the union
+   of the pixels of all targets (used when reading DIF.dif). A pixel full
+   for any target is full, as are its descendants (not listed).
+ */
+void DIF_Region::go_cones() {
+    int i, nt = tg_id.size();
+    unsigned long j;
+
+    tg_byid.resize(nt);
+    tg_byde.resize(nt);
+    for (i=0; i<nt; i++)
+      tg_byid[i] = tg_byde[i] = i;
+
+    sort(tg_byid.begin(), tg_byid.end(),
+         [this](int a, int b) { return tg_id[a] < tg_id[b]; });
+    sort(tg_byde.begin(), tg_byde.end(),
+         [this](int a, int b) { return tg_de[a] < tg_de[b]; });
+
+    for (i=0; i<params.size(); i++) {
+      vector<long long int>& fl = *pflist[i];
+      vector<long long int> pl;
+
+      for (j=0; j<tpix.size(); j++)
+	if (tpix[j].param == params[i])
+	  (tpix[j].full ? fl : pl).push_back(tpix[j].id);
+
+      sort(fl.begin(), fl.end());
+      fl.erase(unique(fl.begin(), fl.end()), fl.end());
+      sort(pl.begin(), pl.end());
+      pl.erase(unique(pl.begin(), pl.end()), pl.end());
+
+      DIF_setDifference(pl, fl, *pplist[i]);
+    }
+
+    dropCovered();
+}
+
+
+// Rectangle of corners (r1, d1) and (r2, d2), r1 <= r2 and d1 <= d2 (deg)
+void DIF_Region::setRect(double r1, double d1, double r2, double d2) {
+// RA in 0 - 2pi
+    while (r1 < 0.)
+      r1 += 360.;
+    while (r2 > 360.)
+      r2 -= 360.;
+
+    if (r1 == r2) {
+      r1 = MIN_OFF_DEG;
+      r2 = 360.;
+    }
+
+// Order ranges (clockwise) assuming a convex
+    if (r1 < r2) {
+      ra1 = r1;
+      ra3 = r2;
+    } else {
+      ra1 = r2;
+      ra3 = r1;
+    }
+    ra2 = ra1;
+    ra4 = ra3;
+
+    if (schema == DIF_HEALP_NEST || schema == DIF_HEALP_RING)
+    {
+// Peculiar Dec
+      if (d1 < -90.) {
+        //if (is_ring)
+          d1 = -90. + MIN_OFF_DEG;
+        //else
+          //d1 = -180. - d1 ;
+      } else if (d1 == -90.)
+        d1 += MIN_OFF_DEG;
+
+      if (d2 > 90.) {
+        //if (is_ring)
+          d2 = 90. - MIN_OFF_DEG;
+        //else
+          //d2 = 180. - d2;
+      } else if (d2 == 90.)
+        d2 -= MIN_OFF_DEG;
+    }
+
+    if (d1 == d2) {
+      d1 = MIN_OFF_DEG;
+      d2 = 90. - MIN_OFF_DEG;
+    }
+
+    if (d1 < d2) {
+      de1 = d1;
+      de2 = d2;
+    } else {
+      de1 = d2;
+      de2 = d1;
+    }
+    de3 = de2;
+    de4 = de1;
+    regtype = DIF_REG_4VERT;
+}
+
+
+// Circle of center (ra, de) and radius r (arcmin)
+void DIF_Region::setCircle(double ra, double de, double r) {
+    regtype = DIF_REG_CIRCLE;
+    ra1 = ra;
+    de1 = de;
+    rad = r;
+
+// Force to minimum radius - should alert 
+    if (rad < MIN_CONE_ARCMIN) 
+      rad = MIN_CONE_ARCMIN;
+}
+
+
+
+
 
 
 //Implement UDFs
@@ -187,6 +534,8 @@ extern "C" {
   DEFINE_FUNCTION(longlong, HTMidByName);
   DEFINE_FUNCTION(longlong, HTMLookup);
   DEFINE_FUNCTION(longlong, HEALPLookup);
+  DEFINE_FUNCTION(longlong, HTMParent);
+  DEFINE_FUNCTION(longlong, HEALPNestParent);
 
   DEFINE_FUNCTION(double, Sphedist);
   DEFINE_FUNCTION(double, HTMBaryDist);
@@ -210,6 +559,7 @@ extern "C" {
   DEFINE_FUNCTION(longlong, DIF_setHEALPOrder);
   DEFINE_FUNCTION(longlong, DIF_clear);    
   DEFINE_FUNCTION(double  , DIF_cpuTime);    
+  DEFINE_FUNCTION(longlong, DIF_Chunk);    
   DEFINE_FUNCTION(longlong, DIF_FineSearch);
 
 
@@ -220,6 +570,22 @@ extern "C" {
   DEFINE_FUNCTION(longlong, DIF_NeighbC);
   DEFINE_FUNCTION(longlong, DIF_sNeighb);
 
+  DEFINE_FUNCTION(longlong, DIF_addTarget);
+  DEFINE_FUNCTION(longlong, DIF_Cones);
+  DEFINE_FUNCTION(longlong, DIF_Polygon);
+  DEFINE_FUNCTION(longlong, DIF_MOC);
+  DEFINE_FUNCTION(longlong, DIF_Annulus);
+  DEFINE_FUNCTION(longlong, DIF_Ellipse);
+  DEFINE_FUNCTION(longlong, DIF_Strip);
+  DEFINE_FUNCTION(longlong, DIF_RegionExpr);
+  DEFINE_FUNCTION(longlong, DIF_Prepare);
+  DEFINE_FUNCTION(longlong, DIF_UsePrepared);
+  DEFINE_FUNCTION(longlong, DIF_Unprepare);
+
+  DEFINE_FUNCTION_CHAR(char*, DIF_MOCBuild);
+  void DIF_MOCBuild_clear(UDF_INIT*, char*, char*);
+  void DIF_MOCBuild_add(UDF_INIT*, UDF_ARGS*, char*, char*);
+
 //  DEFINE_FUNCTION(longlong, IDMatch);
 //  DEFINE_FUNCTION(longlong, CrossMatch);
 
@@ -435,14 +801,15 @@ longlong HTMLookup(UDF_INIT *init, UDF_ARGS *args,
   double dec = DARGS(2);
   unsigned long long int id;
 
-  if ( getHTMid(init->ptr, depth, raa, dec, &id) )
+// Shared SpatialIndex: nothing is built per statement (or trigger row)
+  if ( getHTMidBatch(&depth, 1, 1, &raa, &dec, &id) )
     *error = 1;
 
   return id;
 }
 
 void HTMLookup_deinit(UDF_INIT *init)
-{ cleanHTMUval(init->ptr); }
+{}
 
 
 
@@ -487,6 +854,99 @@ void HEALPLookup_deinit(UDF_INIT *init)
 
 
 
+//--------------------------------------------------------------------
+// Coarser HTM and HEALPix NESTED IDs are the deeper ones shifted by 2 bits
+// per level: return NULL if an argument is NULL or the ID is not valid at
+// depth/order 'from'.
+my_bool HTMParent_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "HTMParent(id BIGINT, from_depth INT, to_depth INT)";
+
+  CHECK_ARG_NUM(3);
+  CHECK_ARG_TYPE(0, INT_RESULT);
+  CHECK_ARG_TYPE(1, INT_RESULT);
+  CHECK_ARG_TYPE(2, INT_RESULT);
+
+  init->maybe_null = 1;
+  init->ptr = NULL;
+
+  return 0;
+}
+
+
+longlong HTMParent(UDF_INIT *init, UDF_ARGS *args,
+                   char *is_null, char* error)
+{
+  if (! args->args[0]  ||  ! args->args[1]  ||  ! args->args[2]) {
+    *is_null = 1;
+    return 0;
+  }
+
+  unsigned long long int id = IARGS(0);
+  int from = IARGS(1);
+  int to   = IARGS(2);
+
+  if ((to < 0)  ||  (to > from)  ||  (from > 25)  ||
+      (id < (8ULL << 2*from))  ||  (id >= (16ULL << 2*from))) {
+    *is_null = 1;
+    return 0;
+  }
+
+  return id >> 2*(from - to);
+}
+
+void HTMParent_deinit(UDF_INIT *init)
+{}
+
+
+
+
+
+//--------------------------------------------------------------------
+my_bool HEALPNestParent_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "HEALPNestParent(id BIGINT, from_order INT, to_order INT)";
+
+  CHECK_ARG_NUM(3);
+  CHECK_ARG_TYPE(0, INT_RESULT);
+  CHECK_ARG_TYPE(1, INT_RESULT);
+  CHECK_ARG_TYPE(2, INT_RESULT);
+
+  init->maybe_null = 1;
+  init->ptr = NULL;
+
+  return 0;
+}
+
+
+longlong HEALPNestParent(UDF_INIT *init, UDF_ARGS *args,
+                         char *is_null, char* error)
+{
+  if (! args->args[0]  ||  ! args->args[1]  ||  ! args->args[2]) {
+    *is_null = 1;
+    return 0;
+  }
+
+  long long int id = IARGS(0);
+  int from = IARGS(1);
+  int to   = IARGS(2);
+
+  if ((to < 0)  ||  (to > from)  ||  (from > 29)  ||
+      (id < 0)  ||  (id >= (12LL << 2*from))) {
+    *is_null = 1;
+    return 0;
+  }
+
+  return id >> 2*(from - to);
+}
+
+void HEALPNestParent_deinit(UDF_INIT *init)
+{}
+
+
+
+
+
 //--------------------------------------------------------------------
 my_bool Sphedist_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
@@ -1362,27 +1822,27 @@ void HEALPMaxS_deinit(UDF_INIT* init)
 //--------------------------------------------------------------------
 my_bool DIF_setHTMDepth_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_setHTMDepth(depth INT)";
+  const char* argerr = "DIF_setHTMDepth(depth INT [, slot INT])";
 
-  CHECK_ARG_NUM(1);
+  if (args->arg_count != 2) {
+    CHECK_ARG_NUM(1);
+  }
   CHECK_ARG_TYPE(0, INT_RESULT);
 
   init->maybe_null = 0;
   init->max_length = 4;
   init->const_item = 1;
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(1);
+  init->ptr = (char*) difreg;
   //difreg->clear_region();
   difreg->setSchema(DIF_HTM);
 
 // 14/11/2018: changed for MySQL 8
 // NOTE: args->args can be undefined alias (AS) are being used. Use "attributes".
-//int depth = IARGS(0);
-#if MY_VERSION_ID >= 80000 &&  MY_VERSION_ID < 100000
-int depth = atoi(args->attributes[0]);
-#else
-int depth = *((long long*) args->args[0]);
-#endif
+// Also for the other MySQL versions if the value is not given (see
+// constIntArg).
+  int depth = (int) constIntArg(args, 0);
 
   difreg->setAvailParam( depth );
 
@@ -1401,7 +1861,7 @@ longlong DIF_setHTMDepth(UDF_INIT *init, UDF_ARGS *args,
 
 void DIF_setHTMDepth_deinit(UDF_INIT *init)
 {
-    difreg->clear_pixel();
+    ((DIF_Region*) init->ptr)->clear_pixel();
 }
 
 
@@ -1409,9 +1869,11 @@ void DIF_setHTMDepth_deinit(UDF_INIT *init)
 //--------------------------------------------------------------------
 my_bool DIF_setHEALPOrder_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_setHEALPOrder(nested INT, order INT)";
+  const char* argerr = "DIF_setHEALPOrder(nested INT, order INT [, slot INT])";
 
-  CHECK_ARG_NUM(2);
+  if (args->arg_count != 3) {
+    CHECK_ARG_NUM(2);
+  }
   CHECK_ARG_TYPE(0, INT_RESULT);
   CHECK_ARG_TYPE(1, INT_RESULT);
 
@@ -1419,20 +1881,16 @@ my_bool DIF_setHEALPOrder_init(UDF_INIT* init, UDF_ARGS *args, char *message)
   init->max_length = 4;
   init->const_item = 1;
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(2);
+  init->ptr = (char*) difreg;
   //difreg->clear_region();
   // 5/7/2016 exchange: difreg->setSchema(IARGS(0)   ?   DIF_HEALP_RING   :   DIF_HEALP_NEST);
 // 14/11/2018: changed for MySQL 8
   //difreg->setSchema(IARGS(0)   ?   DIF_HEALP_NEST   :   DIF_HEALP_RING);
   //difreg->setAvailParam( IARGS(1) );
 
-#if MY_VERSION_ID >= 80000 &&  MY_VERSION_ID < 100000
-  int nested = atoi(args->attributes[0]);
-  int order = atoi(args->attributes[1]);
-#else
-  int nested = IARGS(0);
-  int order = IARGS(1);
-#endif
+  int nested = (int) constIntArg(args, 0);
+  int order = (int) constIntArg(args, 1);
   difreg->setSchema(nested   ?   DIF_HEALP_NEST   :   DIF_HEALP_RING);
   difreg->setAvailParam( order );
 
@@ -1446,7 +1904,7 @@ longlong DIF_setHEALPOrder(UDF_INIT *init, UDF_ARGS *args,
 
 void DIF_setHEALPOrder_deinit(UDF_INIT *init)
 {
-    difreg->clear_pixel();
+    ((DIF_Region*) init->ptr)->clear_pixel();
 }
 
 
@@ -1457,9 +1915,13 @@ void DIF_setHEALPOrder_deinit(UDF_INIT *init)
 //--------------------------------------------------------------------
 my_bool DIF_clear_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_clear()";
+  const char* argerr = "DIF_clear([slot INT])";
+
+  if (args->arg_count > 1) {
+    CHECK_ARG_NUM(1);
+  }
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(0);
   difreg->clear_region();
   return 0;
 }
@@ -1477,6 +1939,14 @@ void DIF_clear_deinit(UDF_INIT *init)
 //--------------------------------------------------------------------
 my_bool DIF_cpuTime_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
+  const char* argerr = "DIF_cpuTime([slot INT])";
+
+  if (args->arg_count > 1) {
+    CHECK_ARG_NUM(1);
+  }
+
+  GET_SLOT_REGION(0);
+  init->ptr = (char*) difreg;
   init->decimals = NOT_FIXED_DEC;
 
   return 0;
@@ -1484,15 +1954,49 @@ my_bool DIF_cpuTime_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 
 double DIF_cpuTime(UDF_INIT *init, UDF_ARGS *args, char *is_null, char* error)
 {
-    if (difreg.getp())
-	return difreg->cpuTime();
-
-    return 0;
+    return ((DIF_Region*) init->ptr)->cpuTime();
 }
 
 void DIF_cpuTime_deinit(UDF_INIT *init)
 {}
 
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Chunk_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_Chunk(k INT, n INT [, slot INT])";
+
+  if (args->arg_count != 3) {
+    CHECK_ARG_NUM(2);
+  }
+  CHECK_ARG_TYPE(0, INT_RESULT);
+  CHECK_ARG_TYPE(1, INT_RESULT);
+
+  long long k = constIntArg(args, 0);
+  long long n = constIntArg(args, 1);
+  if (n < 1  ||  k < 0  ||  k >= n) {
+    strcpy(message, "DIF_Chunk: chunk k must be in [0, n)");
+    return 1;
+  }
+
+  GET_SLOT_REGION(2);
+  init->ptr = (char*) difreg;
+  difreg->setChunk((int) k, (int) n);
+  return 0;
+}
+
+longlong DIF_Chunk(UDF_INIT *init, UDF_ARGS *args,
+                   char *is_null, char* error)
+{ return 1; }
+
+// The chunk is read by the searches of this statement only
+void DIF_Chunk_deinit(UDF_INIT *init)
+{
+    ((DIF_Region*) init->ptr)->setChunk(0, 1);
+}
+
      
 
 
@@ -1503,23 +2007,40 @@ my_bool DIF_FineSearch_init(UDF_INIT* init, UDF_ARGS *args, char *message)
   const char* argerr = "DIF_FineSearch(...)";
 
 // Always 3 params: RA, Dec, full_pixel_flag
-  if (difreg.getp()) {
-    switch (difreg->regtype) {
-      case DIF_REG_CIRCLE:
-      case DIF_REG_4VERT:
-      case DIF_REG_NEIGHBC:
-      case DIF_REG_SNEIGHB:
-        CHECK_ARG_NUM(3);
-        CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
-        CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
-        CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
-        break;
+// plus the target ID (DIF.difm.target) for multi-region searches
+// and the region slot (the target is then ignored if not a multi-region)
+  if (args->arg_count < 3  ||  args->arg_count > 5) {
+    CHECK_ARG_NUM(3);
+  }
 
-      case DIF_REG_RECT:
-      case DIF_REG_2VERT:
-      case DIF_REG_NONE:
-        break;
-     }
+  GET_SLOT_REGION(4);
+  init->ptr = (char*) difreg;
+
+  switch (difreg->regtype) {
+    case DIF_REG_CIRCLE:
+    case DIF_REG_4VERT:
+    case DIF_REG_NEIGHBC:
+    case DIF_REG_SNEIGHB:
+    case DIF_REG_CONES:
+    case DIF_REG_POLYGON:
+    case DIF_REG_MOC:
+    case DIF_REG_ANNULUS:
+    case DIF_REG_ELLIPSE:
+    case DIF_REG_STRIP:
+    case DIF_REG_LONLAT:
+    case DIF_REG_EXPR:
+      if (args->arg_count == 4) {   // may be NULL if the slot is given
+        CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
+      }
+      CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
+      CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
+      CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
+      break;
+
+    case DIF_REG_RECT:
+    case DIF_REG_2VERT:
+    case DIF_REG_NONE:
+      break;
   }
 
   return 0;
@@ -1530,6 +2051,7 @@ my_bool DIF_FineSearch_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 longlong DIF_FineSearch(UDF_INIT *init, UDF_ARGS *args,
                         char *is_null, char* error)
 {
+    DIF_Region* difreg = (DIF_Region*) init->ptr;
     double sep; // side1, side2;
     double ra = DARGS(0);
     double de = DARGS(1);
@@ -1542,8 +2064,6 @@ longlong DIF_FineSearch(UDF_INIT *init, UDF_ARGS *args,
     if (*(args->args[2]))
       return 1; //If the pixel is "full" return immediately
 
-    if (! difreg.getp())
-      return 0;
     difreg->subStart();
     
     //unsigned short ra1border=0; // Toggle for negative start RA range
@@ -1638,6 +2158,39 @@ longlong DIF_FineSearch(UDF_INIT *init, UDF_ARGS *args,
 	    ret = 1;
 	    break;
 
+// With the target ID check only its circle, otherwise all (DIF.dif)
+	case DIF_REG_CONES:
+	    if (args->arg_count >= 4  &&  args->args[3]) {
+	      int it = difreg->findTarget(IARGS(3));
+	      if (it >= 0) {
+		sep = skysep_h(difreg->targetRa(it), difreg->targetDec(it),
+			       ra, de, 0);
+		if (sep >= 0. && sep <= difreg->rad)
+		  ret = 1;
+	      }
+	    } else
+	      ret = difreg->inTargets(ra, de);
+	    break;
+
+	case DIF_REG_POLYGON:
+	    ret = difreg->inPolygon(ra, de);
+	    break;
+
+	case DIF_REG_MOC:
+	    ret = difreg->inMOC(ra, de);
+	    break;
+
+	case DIF_REG_ANNULUS:
+	case DIF_REG_ELLIPSE:
+	case DIF_REG_STRIP:
+	case DIF_REG_LONLAT:
+	    ret = difreg->inShape(ra, de);
+	    break;
+
+	case DIF_REG_EXPR:
+	    ret = difreg->inExpr(ra, de);
+	    break;
+
 	case DIF_REG_NONE:
 	    break;
     }
@@ -1661,22 +2214,23 @@ void DIF_FineSearch_deinit(UDF_INIT *init)
 //--------------------------------------------------------------------
 my_bool DIF_Circle_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_Circle(Ra_deg DOUBLE, Dec_deg DOUBLE, Rad_arcmin DOUBLE)";
+  const char* argerr = "DIF_Circle(Ra_deg DOUBLE, Dec_deg DOUBLE, Rad_arcmin DOUBLE [, frame STRING] [, slot INT])";
 
-  CHECK_ARG_NUM(3);
+  unsigned int nargs;
+  int frame = frameArg(args, &nargs);
+  int islot = frameSlotIndex(args, nargs, 3);
+  if (frame < 0  ||  islot < 0) {
+    strcpy(message, argerr);
+    return 1;
+  }
   CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
   CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
   CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
 
-  if (! difreg.getp()) difreg.constructor();
-  difreg->regtype = DIF_REG_CIRCLE;
-  difreg->ra1 = DARGS(0);
-  difreg->de1 = DARGS(1);
-  difreg->rad = DARGS(2);
-
-// Force to minimum radius - should alert 
-  if (difreg->rad < MIN_CONE_DEG) 
-    difreg->rad = MIN_CONE_DEG;
+  GET_SLOT_REGION(islot);
+  double ra, de;
+  DIF_frameToEq((enum DIF_Frame) frame, DARGS(0), DARGS(1), &ra, &de);
+  difreg->setCircle(ra, de, DARGS(2));
 
   return 0;
 }
@@ -1696,9 +2250,17 @@ void DIF_Circle_deinit(UDF_INIT *init)
 my_bool DIF_Rect_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
 //This function requires the coordinates of the center of the rectangular region and one or two sides.
-  const char* argerr = "DIF_Rect(Ra_deg DOUBLE, Dec_deg DOUBLE, side_ra_arcmin DOUBLE [, side_dec_arcmin DOUBLE])";
+  const char* argerr = "DIF_Rect(Ra_deg DOUBLE, Dec_deg DOUBLE, side_ra_arcmin DOUBLE [, side_dec_arcmin DOUBLE] [, frame STRING] [, slot INT])";
+
+// The optional slot follows the frame, or the 4th argument
+  unsigned int nargs, islot = 4;
+  int frame = frameArg(args, &nargs);
+  if (nargs < args->arg_count)
+    islot = nargs + 1;
+  else if (nargs == 5)
+    nargs = 4;
 
-  switch (args->arg_count) { 
+  switch (nargs) { 
   case 4:
     CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
   case 3:
@@ -1707,10 +2269,14 @@ my_bool DIF_Rect_init(UDF_INIT* init, UDF_ARGS *args, char *message)
     CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
     break;
   default:
-    CHECK_ARG_NUM(4);  //Raise an error
+    frame = -1;  //Raise an error
+  }
+  if (frame < 0) {
+    strcpy(message, argerr);
+    return 1;
   }
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(islot);
 //  difreg->clear_region();
 //  difreg->regtype = DIF_REG_RECT;
 
@@ -1722,7 +2288,7 @@ my_bool DIF_Rect_init(UDF_INIT* init, UDF_ARGS *args, char *message)
     hside_ra = MIN_CONE_DEG;
   //double hside_de = (args->arg_count == 4  ?  DARGS(3)/120.  :  hside_ra);
   double hside_de = hside_ra;
-  if (args->arg_count == 4) {
+  if (nargs == 4) {
     hside_de = DARGS(3)/120.;
     if (hside_de < MIN_CONE_DEG) 
       hside_de = MIN_CONE_DEG;
@@ -1799,6 +2365,17 @@ my_bool DIF_Rect_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 //sprintf(message, "%13.8lf,%13.8lf %13.8lf,%13.8lf  \0", difreg->ra1,difreg->de1, difreg->ra3,difreg->de2);
 //return 1;
   difreg->regtype = DIF_REG_4VERT;
+
+// Galactic/Ecliptic longitude/latitude box
+  if (frame != DIF_FRAME_EQ) {
+    difreg->regtype = DIF_REG_LONLAT;
+    difreg->frame = (enum DIF_Frame) frame;
+    if (difreg->makeShape() < 0) {
+      strcpy(message, "DIF_Rect: longitude range larger than 180 deg in Galactic/Ecliptic frame");
+      return 1;
+    }
+  }
+
   return 0;
 }
 
@@ -1821,10 +2398,24 @@ void DIF_Rect_deinit(UDF_INIT *init)
 my_bool DIF_Rectv_init(UDF_INIT* init, UDF_ARGS *args, char *message)
 {
 //This function requires the coordinates of the 2 opposite (or 4) corners of the rectangular region.
-  const char* argerr = "DIF_Rectv(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE [, x 2])";
-
+  const char* argerr = "DIF_Rectv(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE [, x 2] [, frame STRING] [, slot INT])";
+
+// The optional slot is the last argument, after the optional frame
+  unsigned int nargs, islot;
+  int frame = frameArg(args, &nargs);
+  if (nargs < args->arg_count)
+    islot = nargs + 1;
+  else {
+    if (nargs == 5  ||  nargs == 9)
+      nargs--;
+    islot = nargs;
+  }
+  if (frame < 0) {
+    strcpy(message, argerr);
+    return 1;
+  }
 
-  switch (args->arg_count) {
+  switch (nargs) {
   case 8:
     CHECK_ARG_NOT_TYPE(4, STRING_RESULT);
     CHECK_ARG_NOT_TYPE(5, STRING_RESULT);
@@ -1837,17 +2428,18 @@ my_bool DIF_Rectv_init(UDF_INIT* init, UDF_ARGS *args, char *message)
     CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
     break;
   default:
-    CHECK_ARG_NUM(4);  //Raise an error
+    strcpy(message, argerr);  //Raise an error
+    return 1;
   }
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(islot);
 //  difreg->clear_region();
 //  difreg->regtype = DIF_REG_RECT;
 
   double ra1, de1, ra2, de2;
   bool is_ring = false;
 
-  if (args->arg_count == 4) {
+  if (nargs == 4) {
     ra1 = DARGS(0);
     de1 = DARGS(1);
     ra2 = DARGS(2);
@@ -1883,66 +2475,18 @@ my_bool DIF_Rectv_init(UDF_INIT* init, UDF_ARGS *args, char *message)
     de2 = de[3];
   }
 
-// RA in 0 - 2pi
-  while (ra1 < 0.)
-    ra1 += 360.;
-  while (ra2 > 360.)
-    ra2 -= 360.;
+  difreg->setRect(ra1, de1, ra2, de2);
 
-  if (ra1 == ra2) {
-    ra1 = MIN_OFF_DEG;
-    ra2 = 360.;
-  }
-
-// Order ranges (clockwise) assuming a convex
-  if (ra1 < ra2) {
-    difreg->ra1 = ra1;
-    difreg->ra3 = ra2;
-  } else {
-    difreg->ra1 = ra2;
-    difreg->ra3 = ra1;
-  }
-  difreg->ra2 = difreg->ra1;
-  difreg->ra4 = difreg->ra3;
-
-  if (difreg->getSchema() == DIF_HEALP_NEST || difreg->getSchema() == DIF_HEALP_RING)
-  {
-// Peculiar Dec
-    if (de1 < -90.) {
-      //if (is_ring)
-        de1 = -90. + MIN_OFF_DEG;
-      //else
-        //de1 = -180. - de1 ;
-    } else if (de1 == -90.)
-      de1 += MIN_OFF_DEG;
-
-    if (de2 > 90.) {
-      //if (is_ring)
-        de2 = 90. - MIN_OFF_DEG;
-      //else
-        //de2 = 180. - de2;
-    } else if (de2 == 90.)
-      de2 -= MIN_OFF_DEG;
-  }
-
-  if (de1 == de2) {
-    de1 = MIN_OFF_DEG;
-    de2 = 90. - MIN_OFF_DEG;
-  }
-
-  if (de1 < de2) {
-    difreg->de1 = de1;
-    difreg->de2 = de2;
-  } else {
-    difreg->de1 = de2;
-    difreg->de2 = de1;
+// Galactic/Ecliptic longitude/latitude box
+  if (frame != DIF_FRAME_EQ) {
+    difreg->regtype = DIF_REG_LONLAT;
+    difreg->frame = (enum DIF_Frame) frame;
+    if (difreg->makeShape() < 0) {
+      strcpy(message, "DIF_Rectv: longitude range larger than 180 deg in Galactic/Ecliptic frame");
+      return 1;
+    }
   }
-  difreg->de3 = difreg->de2;
-  difreg->de4 = difreg->de1;
 
-//sprintf(message, "%13.8lf,%13.8lf %13.8lf,%13.8lf  \0", difreg->ra1,difreg->de1, difreg->ra3,difreg->de3);
-//return 1;
-  difreg->regtype = DIF_REG_4VERT;
   return 0;
 }
 
@@ -1961,13 +2505,15 @@ void DIF_Rectv_deinit(UDF_INIT *init)
 //--------------------------------------------------------------------
 my_bool DIF_NeighbC_init(UDF_INIT *init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_NeighbC(Ra_deg DOUBLE, Dec_deg DOUBLE)";
+  const char* argerr = "DIF_NeighbC(Ra_deg DOUBLE, Dec_deg DOUBLE [, slot INT])";
 
-  CHECK_ARG_NUM(2);
+  if (args->arg_count != 3) {
+    CHECK_ARG_NUM(2);
+  }
   CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
   CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(2);
   difreg->regtype = DIF_REG_NEIGHBC;
   difreg->ra1 = DARGS(0);
   difreg->de1 = DARGS(1);
@@ -1990,14 +2536,16 @@ void DIF_NeighbC_deinit(UDF_INIT* init)
 //--------------------------------------------------------------------
 my_bool DIF_sNeighb_init(UDF_INIT *init, UDF_ARGS *args, char *message)
 {
-  const char* argerr = "DIF_sNeighb(in_depth INT, id INT, out_depth INT)";
+  const char* argerr = "DIF_sNeighb(in_depth INT, id INT, out_depth INT [, slot INT])";
 
-  CHECK_ARG_NUM(3);
+  if (args->arg_count != 4) {
+    CHECK_ARG_NUM(3);
+  }
   CHECK_ARG_TYPE(0, INT_RESULT);
   CHECK_ARG_TYPE(1, INT_RESULT);
   CHECK_ARG_TYPE(2, INT_RESULT);
 
-  if (! difreg.getp()) difreg.constructor();
+  GET_SLOT_REGION(3);
   difreg->regtype = DIF_REG_SNEIGHB;
   difreg->indepth = IARGS(0);
   difreg->refpix = DARGS(1);
@@ -2018,6 +2566,574 @@ void DIF_sNeighb_deinit(UDF_INIT* init)
 
 
 
+//--------------------------------------------------------------------
+my_bool DIF_addTarget_init(UDF_INIT *init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_addTarget(id INT, Ra_deg DOUBLE, Dec_deg DOUBLE [, slot INT])";
+
+  if (args->arg_count != 4) {
+    CHECK_ARG_NUM(3);
+  }
+  CHECK_ARG_TYPE(0, INT_RESULT);
+  CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
+
+  init->maybe_null = 0;
+  init->const_item = 0;
+
+  GET_SLOT_REGION(3);
+  init->ptr = (char*) difreg;
+
+  return 0;
+}
+
+
+// Append a target to the multi-region list: return the Nr of targets.
+// Rows with NULL or invalid coordinates are skipped.
+longlong DIF_addTarget(UDF_INIT *init, UDF_ARGS *args,
+                       char *is_null, char *error)
+{
+  DIF_Region* difreg = (DIF_Region*) init->ptr;
+
+  if (ISNULL(0) || ISNULL(1) || ISNULL(2))
+    return difreg->ntargets();
+
+  double ra = DARGS(1);
+  double de = DARGS(2);
+
+  while (ra < 0.)
+    ra += 360.;
+  while (ra >= 360.)
+    ra -= 360.;
+
+  if (! (-90. <= de  &&  de <= 90.))
+    return difreg->ntargets();
+
+  return difreg->addTarget(IARGS(0), ra, de);
+}
+
+
+void DIF_addTarget_deinit(UDF_INIT* init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Cones_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_Cones(Rad_arcmin DOUBLE [, slot INT])";
+
+  if (args->arg_count != 2) {
+    CHECK_ARG_NUM(1);
+  }
+  CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
+
+  GET_SLOT_REGION(1);
+  init->ptr = (char*) difreg;
+  difreg->regtype = DIF_REG_CONES;
+  difreg->rad = DARGS(0);
+
+// Force to minimum radius - should alert 
+  if (difreg->rad < MIN_CONE_ARCMIN) 
+    difreg->rad = MIN_CONE_ARCMIN;
+
+  return 0;
+}
+
+
+longlong DIF_Cones(UDF_INIT *init, UDF_ARGS *args,
+                   char *is_null, char* error)
+{ return ((DIF_Region*) init->ptr)->ntargets(); }
+
+
+void DIF_Cones_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Polygon_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+// Coordinates of N >= 3 vertices, connected by great circle arcs
+  const char* argerr = "DIF_Polygon(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE, Ra3_deg DOUBLE, Dec3_deg DOUBLE [, ...] [, frame STRING] [, slot INT])";
+
+// The optional slot is the last argument, after the optional frame
+  unsigned int i, nargs, islot;
+  int frame = frameArg(args, &nargs);
+  if (nargs < args->arg_count)
+    islot = nargs + 1;
+  else {
+    if (nargs % 2)
+      nargs--;
+    islot = nargs;
+  }
+
+  if (frame < 0  ||  nargs < 6  ||  nargs % 2) {
+    strcpy(message, argerr);
+    return 1;
+  }
+  for (i=0; i<nargs; i++) {
+    CHECK_ARG_NOT_TYPE(i, STRING_RESULT);
+  }
+
+  GET_SLOT_REGION(islot);
+  difreg->clear_polygon();
+
+  for (i=0; i<nargs; i+=2) {
+    double ra = DARGS(i);
+    double de = DARGS(i+1);
+    if (! (-90. <= de  &&  de <= 90.)) {
+      strcpy(message, argerr);
+      return 1;
+    }
+    DIF_frameToEq((enum DIF_Frame) frame, DARGS(i), DARGS(i+1), &ra, &de);
+    difreg->addVertex(ra, de);
+  }
+
+  if (difreg->makePolygon() < 0) {
+    strcpy(message, "DIF_Polygon: degenerate or self-intersecting polygon, or not within an hemisphere");
+    return 1;
+  }
+
+  difreg->regtype = DIF_REG_POLYGON;
+
+  return 0;
+}
+
+
+longlong DIF_Polygon(UDF_INIT *init, UDF_ARGS *args,
+                     char *is_null, char* error)
+{ return 1; }
+
+
+void DIF_Polygon_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_MOC_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+// ASCII ("order/cells ...") or binary (ranges at order 29) MOC
+  const char* argerr = "DIF_MOC(moc STRING|BLOB [, slot INT])";
+
+  if (args->arg_count != 2) {
+    CHECK_ARG_NUM(1);
+  }
+  CHECK_ARG_TYPE(0, STRING_RESULT);
+
+  if (! args->args[0]) {
+    strcpy(message, "DIF_MOC: the MOC must be a constant (a literal, a variable or LOAD_FILE)");
+    return 1;
+  }
+
+  GET_SLOT_REGION(1);
+  init->ptr = (char*) difreg;
+  difreg->clear_moc();
+
+  if (difreg->setMOC(args->args[0], args->lengths[0]) < 0) {
+    strcpy(message, "DIF_MOC: invalid MOC");
+    return 1;
+  }
+
+  difreg->regtype = DIF_REG_MOC;
+
+  return 0;
+}
+
+
+longlong DIF_MOC(UDF_INIT *init, UDF_ARGS *args,
+                 char *is_null, char* error)
+{ return ((DIF_Region*) init->ptr)->nmocranges(); }
+
+
+void DIF_MOC_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Annulus_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_Annulus(Ra_deg DOUBLE, Dec_deg DOUBLE, Rin_arcmin DOUBLE, Rout_arcmin DOUBLE [, frame STRING] [, slot INT])";
+
+  unsigned int nargs;
+  int frame = frameArg(args, &nargs);
+  int islot = frameSlotIndex(args, nargs, 4);
+  if (frame < 0  ||  islot < 0) {
+    strcpy(message, argerr);
+    return 1;
+  }
+  CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
+
+  GET_SLOT_REGION(islot);
+  difreg->regtype = DIF_REG_ANNULUS;
+  DIF_frameToEq((enum DIF_Frame) frame, DARGS(0), DARGS(1),
+                &difreg->ra1, &difreg->de1);
+  difreg->rad2 = DARGS(2);
+  difreg->rad  = DARGS(3);
+
+  if (difreg->makeShape() < 0) {
+    strcpy(message, "DIF_Annulus: radii must be 0 <= Rin < Rout <= 180 deg");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+longlong DIF_Annulus(UDF_INIT *init, UDF_ARGS *args,
+                     char *is_null, char* error)
+{ return 1; }
+
+
+void DIF_Annulus_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Ellipse_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_Ellipse(Ra_deg DOUBLE, Dec_deg DOUBLE, SemiMajor_arcmin DOUBLE, SemiMinor_arcmin DOUBLE, PA_deg DOUBLE [, frame STRING] [, slot INT])";
+
+  unsigned int nargs;
+  int frame = frameArg(args, &nargs);
+  int islot = frameSlotIndex(args, nargs, 5);
+  if (frame < 0  ||  islot < 0) {
+    strcpy(message, argerr);
+    return 1;
+  }
+  CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(4, STRING_RESULT);
+
+  GET_SLOT_REGION(islot);
+  difreg->regtype = DIF_REG_ELLIPSE;
+  DIF_frameToEq((enum DIF_Frame) frame, DARGS(0), DARGS(1),
+                &difreg->ra1, &difreg->de1);
+  difreg->rad  = DARGS(2);
+  difreg->rad2 = DARGS(3);
+  difreg->pa   = DIF_frameToEqPA((enum DIF_Frame) frame, DARGS(0), DARGS(1),
+                                 DARGS(4));
+
+  if (difreg->makeShape() < 0) {
+    strcpy(message, "DIF_Ellipse: semi-axes must be 0 < SemiMinor <= SemiMajor < 90 deg");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+longlong DIF_Ellipse(UDF_INIT *init, UDF_ARGS *args,
+                     char *is_null, char* error)
+{ return 1; }
+
+
+void DIF_Ellipse_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Strip_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+// Two points defining the great circle and the half width of the strip
+  const char* argerr = "DIF_Strip(Ra1_deg DOUBLE, Dec1_deg DOUBLE, Ra2_deg DOUBLE, Dec2_deg DOUBLE, HalfWidth_arcmin DOUBLE [, frame STRING] [, slot INT])";
+
+  unsigned int nargs;
+  int frame = frameArg(args, &nargs);
+  int islot = frameSlotIndex(args, nargs, 5);
+  if (frame < 0  ||  islot < 0) {
+    strcpy(message, argerr);
+    return 1;
+  }
+  CHECK_ARG_NOT_TYPE(0, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(1, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(2, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(3, STRING_RESULT);
+  CHECK_ARG_NOT_TYPE(4, STRING_RESULT);
+
+  GET_SLOT_REGION(islot);
+  difreg->regtype = DIF_REG_STRIP;
+  DIF_frameToEq((enum DIF_Frame) frame, DARGS(0), DARGS(1),
+                &difreg->ra1, &difreg->de1);
+  DIF_frameToEq((enum DIF_Frame) frame, DARGS(2), DARGS(3),
+                &difreg->ra2, &difreg->de2);
+  difreg->rad = DARGS(4);
+
+  if (difreg->makeShape() < 0) {
+    strcpy(message, "DIF_Strip: coincident or antipodal points, or half width not in (0, 90) deg");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+longlong DIF_Strip(UDF_INIT *init, UDF_ARGS *args,
+                   char *is_null, char* error)
+{ return 1; }
+
+
+void DIF_Strip_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_RegionExpr_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+// Union (|), intersection (&) and difference (-) of regions, see DIFexpr.cpp
+  const char* argerr = "DIF_RegionExpr(expr STRING [, slot INT])";
+
+  if (args->arg_count != 2) {
+    CHECK_ARG_NUM(1);
+  }
+  CHECK_ARG_TYPE(0, STRING_RESULT);
+
+  if (! args->args[0]) {
+    strcpy(message, "DIF_RegionExpr: the expression must be a constant");
+    return 1;
+  }
+
+  GET_SLOT_REGION(1);
+  init->ptr = (char*) difreg;
+
+  switch (difreg->setExpr(args->args[0], args->lengths[0])) {
+  case -1:
+    strcpy(message, "DIF_RegionExpr: syntax error, regions: circle(ra,dec,rad), rect(ra1,dec1,ra2,dec2), poly(ra1,dec1,...), annulus(ra,dec,rin,rout), ellipse(ra,dec,a,b,pa), strip(ra1,dec1,ra2,dec2,hw); operators: | & - ( ) (nested up to 64 levels)");
+    return 1;
+  case -2:
+    strcpy(message, "DIF_RegionExpr: invalid region parameters");
+    return 1;
+  }
+
+  difreg->regtype = DIF_REG_EXPR;
+
+  return 0;
+}
+
+
+longlong DIF_RegionExpr(UDF_INIT *init, UDF_ARGS *args,
+                        char *is_null, char* error)
+{ return ((DIF_Region*) init->ptr)->nexpratoms(); }
+
+
+void DIF_RegionExpr_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Prepare_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+// Region expression or MOC kept for all the connections, see DIFprepare.cpp
+  const char* argerr = "DIF_Prepare(expr_or_moc STRING|BLOB)";
+
+  CHECK_ARG_NUM(1);
+  CHECK_ARG_TYPE(0, STRING_RESULT);
+
+  init->maybe_null = 1;
+  init->max_length = 20;
+  init->const_item = 0;
+
+  return 0;
+}
+
+
+// The handle, NULL if the region is not valid or too many are prepared
+longlong DIF_Prepare(UDF_INIT *init, UDF_ARGS *args,
+                     char *is_null, char* error)
+{
+  long long int h = -1;
+
+  if (args->args[0])
+    h = DIF_planPrepare(args->args[0], args->lengths[0]);
+
+  if (h < 0) {
+    *is_null = 1;
+    return 0;
+  }
+  return h;
+}
+
+
+void DIF_Prepare_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_UsePrepared_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_UsePrepared(handle INT [, slot INT])";
+
+  if (args->arg_count != 2) {
+    CHECK_ARG_NUM(1);
+  }
+  CHECK_ARG_TYPE(0, INT_RESULT);
+
+  GET_SLOT_REGION(1);
+  init->ptr = (char*) difreg;
+
+  if (difreg->usePlan(constIntArg(args, 0)) < 0) {
+    strcpy(message, "DIF_UsePrepared: unknown handle (see DIF_Prepare)");
+    return 1;
+  }
+
+  return 0;
+}
+
+
+longlong DIF_UsePrepared(UDF_INIT *init, UDF_ARGS *args,
+                         char *is_null, char* error)
+{ return 1; }
+
+
+// The prepared pixels are used by the searches of this statement only
+void DIF_UsePrepared_deinit(UDF_INIT *init)
+{
+    ((DIF_Region*) init->ptr)->usePlan(0);
+}
+
+
+
+
+//--------------------------------------------------------------------
+my_bool DIF_Unprepare_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_Unprepare(handle INT)";
+
+  CHECK_ARG_NUM(1);
+  CHECK_ARG_TYPE(0, INT_RESULT);
+
+  init->maybe_null = 0;
+  init->const_item = 0;
+
+  return 0;
+}
+
+
+longlong DIF_Unprepare(UDF_INIT *init, UDF_ARGS *args,
+                       char *is_null, char* error)
+{
+  if (! args->args[0])
+    return 0;
+  return DIF_planRelease(IARGS(0));
+}
+
+
+void DIF_Unprepare_deinit(UDF_INIT *init)
+{}
+
+
+
+
+//--------------------------------------------------------------------
+// Aggregate: MOC (ASCII serialization) of a set of HEALPix NESTED IDs.
+// The IDs are sorted and deduplicated each time their number doubles, so
+// that the memory is bounded by the distinct IDs, not by the rows
+#define DIF_MOCBUILD_MINCOMPACT 65536
+
+struct DIF_MOCBuilder {
+  int order;
+  vector<long long int> ids;
+  unsigned long ncompact;   //size of ids triggering the next dedup
+  string moc;
+};
+
+
+my_bool DIF_MOCBuild_init(UDF_INIT* init, UDF_ARGS *args, char *message)
+{
+  const char* argerr = "DIF_MOCBuild(order INT, nested_id INT)";
+
+  CHECK_ARG_NUM(2);
+  CHECK_ARG_TYPE(0, INT_RESULT);
+  CHECK_ARG_TYPE(1, INT_RESULT);
+
+  DIF_MOCBuilder* b = new DIF_MOCBuilder;
+  b->order = -1;
+  b->ncompact = DIF_MOCBUILD_MINCOMPACT;
+  init->ptr = (char*) b;
+
+  init->maybe_null = 0;
+  init->max_length = 16777216;
+  init->const_item = 0;
+
+  return 0;
+}
+
+
+void DIF_MOCBuild_clear(UDF_INIT *init, char *is_null, char *error)
+{
+  DIF_MOCBuilder* b = (DIF_MOCBuilder*) init->ptr;
+  b->order = -1;
+  b->ids.clear();
+  b->ncompact = DIF_MOCBUILD_MINCOMPACT;
+}
+
+
+void DIF_MOCBuild_add(UDF_INIT *init, UDF_ARGS *args,
+                      char *is_null, char *error)
+{
+  DIF_MOCBuilder* b = (DIF_MOCBuilder*) init->ptr;
+
+  if (! args->args[0]  ||  ! args->args[1])
+    return;
+
+  int order = IARGS(0);
+  if (order < 0  ||  order > 29  ||  (b->order >= 0  &&  order != b->order)) {
+    *error = 1;
+    return;
+  }
+  b->order = order;
+  b->ids.push_back(IARGS(1));
+
+  if (b->ids.size() >= b->ncompact) {
+    sort(b->ids.begin(), b->ids.end());
+    b->ids.erase(unique(b->ids.begin(), b->ids.end()), b->ids.end());
+    b->ncompact = max((unsigned long) (2 * b->ids.size()),
+                      (unsigned long) DIF_MOCBUILD_MINCOMPACT);
+  }
+}
+
+
+char * DIF_MOCBuild(UDF_INIT *init, UDF_ARGS *args,
+                    char *result, unsigned long *length,
+                    char *is_null, char *error)
+{
+  DIF_MOCBuilder* b = (DIF_MOCBuilder*) init->ptr;
+
+  DIF_MOCString((b->order < 0 ? 0 : b->order), b->ids, b->moc);
+  *length = b->moc.size();
+  return (char*) b->moc.c_str();
+}
+
+
+void DIF_MOCBuild_deinit(UDF_INIT *init)
+{
+  delete (DIF_MOCBuilder*) init->ptr;
+}
+
+
+
+
 
 
 